@@ -101,18 +101,21 @@ void update_meter(void*)
 #endif
         Units.update();
         if (xSemaphoreTake(_updateLock, 1)) {
-            while (unit.available()) {
-#if defined(USING_UNIT_VMETER)
-                store_value(unit.voltage());
-#elif defined(USING_UNIT_AMETER)
-                store_value(unit.current());
+            // Take out the stored values in bulk
+            float values[32]{};
+            size_t cnt{};
+            do {
+#if defined(USING_UNIT_VMETER) || defined(USING_UNIT_AMETER)
+                cnt = unit.drain(values, m5::stl::size(values));
 #elif defined(USING_UNIT_KMETER_ISO) || defined(USING_UNIT_DUAL_KMETER)
-                store_value(unit.temperature());
+                cnt = unit.drainTemperature(values, m5::stl::size(values));
 #else
 #error "Choose unit"
 #endif
-                unit.discard();
-            }
+                for (size_t i = 0; i < cnt; ++i) {
+                    store_value(values[i]);
+                }
+            } while (cnt);
             xSemaphoreGive(_updateLock);
         }
     }
@@ -76,15 +76,22 @@ void loop()
         }
     }
 
-    // Togle channel 1 <-> 2
+    // Togle channel 1 -> 2 -> alternating 1 and 2
     if (M5.BtnA.wasHold() || touch.wasHold()) {
-        static Channel ch{};
-        ch = (ch == Channel::One) ? Channel::Two : Channel::One;
-        if (unit.writeCurrentChannel(ch)) {
+        static uint8_t mode{};
+        mode = (mode + 1) % 3;
+        unit.stopPeriodicMeasurement();
+        bool started{};
+        if (mode < 2) {
+            started = unit.startPeriodicMeasurement(unit.config().interval, static_cast<Channel>(mode));
+        } else {
+            started = unit.startAlternatingMeasurement(unit.config().interval);
+        }
+        if (started) {
             M5.Speaker.tone(3000, 20);
             m5::utility::delay(50);
             M5.Speaker.tone(2000, 20);
-            M5.Log.printf("Change ch:%u\n", (int)ch + 1);
+            M5.Log.printf("Change ch:%s\n", mode < 2 ? (mode ? "2" : "1") : "1/2");
         }
     }
 }
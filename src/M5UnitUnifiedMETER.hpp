@@ -21,6 +21,7 @@
 #include "unit/unit_KmeterISO.hpp"
 #include "unit/unit_DualKmeter.hpp"
 #include "unit/unit_INA226.hpp"
+#include "unit/meter_bus_scheduler.hpp"
 
 /*!
   @namespace m5
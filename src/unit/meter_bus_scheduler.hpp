@@ -0,0 +1,310 @@
+/*
+ * SPDX-FileCopyrightText: 2024 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+/*!
+  @file meter_bus_scheduler.hpp
+  @brief Earliest-deadline-first update() scheduler of the units on a shared I2C bus
+  @details Instead of calling update() of every unit in the loop, each unit is updated by the scheduler only when it
+  is due, in order of the deadline. The units due at the same time are updated back-to-back in one pass, so the caller
+  can sleep until nextWakeup() between the passes.
+  @code
+  m5::unit::meter::BusScheduler sched{};
+  sched.add(unitAmeter);
+  sched.add(unitINA226);
+  sched.add(unitDualKmeter);
+  for (;;) {
+      sched.update();  // Instead of Units.update()
+      ...
+  }
+  @endcode
+*/
+#ifndef M5_UNIT_METER_METER_BUS_SCHEDULER_HPP
+#define M5_UNIT_METER_METER_BUS_SCHEDULER_HPP
+
+#include "meter_schedule.hpp"
+#include <M5UnitComponent.hpp>
+#include <M5Utility.hpp>
+#include <cstdint>
+#include <vector>
+
+namespace m5 {
+namespace unit {
+namespace meter {
+
+///@cond
+namespace detail {
+// Deadline and interval of the unit. Units that do not have nextDue() are scheduled by updatedMillis() + interval()
+template <class U>
+auto next_due(const U& u, uint32_t& at, int) -> decltype(u.nextDue(at))
+{
+    return u.nextDue(at);
+}
+template <class U>
+bool next_due(const U& u, uint32_t& at, long)
+{
+    if (!u.inPeriodic()) {
+        return false;
+    }
+    // Relative to millis(), since the counters of millis() and micros() are not necessarily in phase
+    int32_t remain = u.updatedMillis() ? (int32_t)(u.updatedMillis() + u.interval() - m5::utility::millis()) : 0;
+    // Clamped to the span the microsecond counter can compare wrap-safely
+    constexpr int32_t span{(int32_t)MAX_SPAN_MILLIS};
+    remain = remain > span ? span : (remain < -span ? -span : remain);
+    at     = (uint32_t)m5::utility::micros() + (uint32_t)(remain * 1000);
+    return true;
+}
+template <class U>
+auto interval_us(const U& u, int) -> decltype(u.intervalMicros())
+{
+    return u.intervalMicros();
+}
+template <class U>
+uint32_t interval_us(const U& u, long)
+{
+    return (uint32_t)u.interval() * 1000U;
+}
+}  // namespace detail
+///@endcond
+
+/*!
+  @class BusScheduler
+  @brief Updates the units sharing a bus earliest-deadline-first
+  @details Each pass collects the units whose next bus access is due, and calls their update() in order of the
+  deadline. The transaction cost of each unit is learned from the time update() took, and if the budget per pass is
+  set, the units that would exceed it are deferred to the next pass (they are the ones with the latest deadlines).
+  A unit served later than its interval from the deadline is counted as a deadline miss, since the unit then
+  resynchronizes and the period is lost
+  @note Time values are the 32-bit microsecond counter and are compared wrap-safely
+  @warning The units must outlive the scheduler, or be removed before destroyed
+ */
+class BusScheduler {
+public:
+    /*!
+      @struct UnitStats
+      @brief Deadline statistics of the unit
+     */
+    struct UnitStats {
+        uint32_t updates{};     //!< Updates that stored a measurement
+        uint32_t idles{};       //!< Updates at the deadline that did not store (e.g. not ready)
+        uint32_t misses{};      //!< Updates later than one interval from the deadline
+        uint32_t deferred{};    //!< Passes the unit was due but deferred by the budget
+        uint32_t late_max{};    //!< Maximum lateness of the updates (us)
+        uint64_t late_total{};  //!< Sum of lateness of the updates (us)
+        uint32_t cost{};        //!< Expected transaction cost of update() (us)
+
+        //! @brief Mean lateness of the updates (us)
+        inline float meanLateness() const
+        {
+            return updates ? (float)late_total / updates : 0.0f;
+        }
+    };
+
+    BusScheduler() = default;
+    BusScheduler(const BusScheduler&)            = delete;
+    BusScheduler& operator=(const BusScheduler&) = delete;
+
+    /*!
+      @brief Add the unit
+      @tparam U Unit class, which may provide nextDue() and intervalMicros()
+      @param unit Unit
+      @param cost Initial expected cost of update() (us), learned if zero
+      @return True if successful, false if already added
+     */
+    template <class U>
+    bool add(U& unit, const uint32_t cost = 0)
+    {
+        if (find(unit)) {
+            return false;
+        }
+        Entry e{};
+        e.unit       = &unit;
+        e.next_due   = &BusScheduler::next_due_of<U>;
+        e.interval   = &BusScheduler::interval_of<U>;
+        e.stats.cost = cost;
+        _entries.push_back(e);
+        _order.reserve(_entries.size());
+        return true;
+    }
+    /*!
+      @brief Remove the unit
+      @return True if successful
+     */
+    bool remove(const Component& unit)
+    {
+        for (auto it = _entries.begin(); it != _entries.end(); ++it) {
+            if (it->unit == &unit) {
+                _entries.erase(it);
+                return true;
+            }
+        }
+        return false;
+    }
+    //! @brief Number of the units
+    inline size_t size() const
+    {
+        return _entries.size();
+    }
+
+    ///@name Budget
+    ///@{
+    //! @brief Budget of the bus time per pass (us), zero if unlimited
+    inline uint32_t budget() const
+    {
+        return _budget;
+    }
+    /*!
+      @brief Set the budget of the bus time per pass
+      @param us Time (us), zero if unlimited
+      @note At least one unit is updated in each pass even if its cost exceeds the budget
+     */
+    inline void budget(const uint32_t us)
+    {
+        _budget = us;
+    }
+    ///@}
+
+    /*!
+      @brief Update the due units earliest-deadline-first
+      @return Number of the units that stored a measurement
+     */
+    size_t update()
+    {
+        const uint32_t now{(uint32_t)m5::utility::micros()};
+        _order.clear();
+        for (auto&& e : _entries) {
+            if (e.next_due(*e.unit, e.due) && (int32_t)(now - e.due) >= 0) {
+                _order.push_back(&e);
+            }
+        }
+        // Earliest first, and in order of the addition if same time
+        for (size_t i = 1; i < _order.size(); ++i) {
+            for (size_t j = i; j > 0 && (int32_t)(_order[j]->due - _order[j - 1]->due) < 0; --j) {
+                std::swap(_order[j], _order[j - 1]);
+            }
+        }
+
+        size_t cnt{};
+        uint32_t spent{};
+        for (auto&& e : _order) {
+            auto& st = e->stats;
+            if (_budget && spent && spent + st.cost > _budget) {
+                ++st.deferred;
+                continue;
+            }
+            const uint32_t at{(uint32_t)m5::utility::micros()};
+            e->unit->update();
+            const uint32_t elapsed{(uint32_t)m5::utility::micros() - at};
+            spent += elapsed;
+            if (!e->unit->updated()) {
+                ++st.idles;
+                continue;
+            }
+            ++cnt;
+            ++st.updates;
+            // Learn the cost of the transaction (EWMA 1/8)
+            st.cost = st.cost ? st.cost - (st.cost >> 3) + (elapsed >> 3) : elapsed;
+            const uint32_t late{at - e->due};
+            st.late_max = late > st.late_max ? late : st.late_max;
+            st.late_total += late;
+            const uint32_t itv{e->interval(*e->unit)};
+            st.misses += (itv && late >= itv) ? 1 : 0;
+        }
+        return cnt;
+    }
+
+    /*!
+      @brief Time until the next deadline
+      @param[out] us Time (us), zero if due now
+      @return True if any unit has something to do
+      @note For sleeping the CPU between the passes
+     */
+    bool nextWakeup(uint32_t& us) const
+    {
+        const uint32_t now{(uint32_t)m5::utility::micros()};
+        bool any{};
+        int32_t earliest{};
+        for (auto&& e : _entries) {
+            uint32_t at{};
+            if (e.next_due(*e.unit, at)) {
+                const int32_t d = (int32_t)(at - now);
+                earliest        = (!any || d < earliest) ? d : earliest;
+                any             = true;
+            }
+        }
+        us = earliest > 0 ? (uint32_t)earliest : 0;
+        return any;
+    }
+
+    ///@name Statistics
+    ///@{
+    /*!
+      @brief Gets the statistics of the unit
+      @return Pointer to the statistics, or nullptr if not added
+     */
+    const UnitStats* stats(const Component& unit) const
+    {
+        auto e = find(unit);
+        return e ? &e->stats : nullptr;
+    }
+    //! @brief Clear the statistics of all units, keeping the learned costs
+    void resetStats()
+    {
+        for (auto&& e : _entries) {
+            const uint32_t cost = e.stats.cost;
+            e.stats             = UnitStats{};
+            e.stats.cost        = cost;
+        }
+    }
+    //! @brief Output the statistics to the log
+    void dump() const
+    {
+        for (auto&& e : _entries) {
+            const auto& st = e.stats;
+            (void)st;  // Unused if the log level is lower
+            M5_LIB_LOGI("%s: U:%u I:%u M:%u D:%u late max:%u mean:%.1f cost:%u us", e.unit->deviceName(),
+                        (unsigned)st.updates, (unsigned)st.idles, (unsigned)st.misses, (unsigned)st.deferred,
+                        (unsigned)st.late_max, st.meanLateness(), (unsigned)st.cost);
+        }
+    }
+    ///@}
+
+private:
+    struct Entry {
+        Component* unit{};
+        bool (*next_due)(const Component&, uint32_t&){};
+        uint32_t (*interval)(const Component&){};
+        uint32_t due{};  // Deadline in the current pass (us)
+        UnitStats stats{};
+    };
+
+    template <class U>
+    static bool next_due_of(const Component& c, uint32_t& at)
+    {
+        return detail::next_due(static_cast<const U&>(c), at, 0);
+    }
+    template <class U>
+    static uint32_t interval_of(const Component& c)
+    {
+        return detail::interval_us(static_cast<const U&>(c), 0);
+    }
+    const Entry* find(const Component& unit) const
+    {
+        for (auto&& e : _entries) {
+            if (e.unit == &unit) {
+                return &e;
+            }
+        }
+        return nullptr;
+    }
+
+    std::vector<Entry> _entries{};
+    std::vector<Entry*> _order{};
+    uint32_t _budget{};
+};
+
+}  // namespace meter
+}  // namespace unit
+}  // namespace m5
+#endif
@@ -0,0 +1,288 @@
+/*
+ * SPDX-FileCopyrightText: 2024 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+/*!
+  @file meter_calibration_cache.hpp
+  @brief Persistent cache of the Ameter/Vmeter calibration
+  @details The calibration read from the EEPROM is stored with the content hash of the EEPROM block,
+  keyed by the bus and the address of the EEPROM, so that the next begin() can skip reading the EEPROM.
+  CalibrationCache is the interface of the storage, and the file, key-value and NVS (ESP-IDF) backends are provided
+*/
+#ifndef M5_UNIT_METER_METER_CALIBRATION_CACHE_HPP
+#define M5_UNIT_METER_METER_CALIBRATION_CACHE_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <string>
+#if defined(ESP_PLATFORM) && defined(__has_include)
+#if __has_include(<nvs.h>)
+#include <nvs.h>
+#define M5_UNIT_METER_CALIBRATION_CACHE_NVS (1)
+#endif
+#endif
+
+namespace m5 {
+namespace unit {
+namespace meter {
+
+//! @brief FNV-1a 32 bit hash
+inline uint32_t fnv1a32(const uint8_t* p, const size_t len, uint32_t h = 2166136261U)
+{
+    for (size_t i = 0; i < len; ++i) {
+        h = (h ^ p[i]) * 16777619U;
+    }
+    return h;
+}
+
+/*!
+  @struct GainCalibration
+  @brief Calibration of a gain
+ */
+struct GainCalibration {
+    int16_t hope{1};
+    int16_t actual{1};
+};
+
+/*!
+  @struct CalibrationRecord
+  @brief Calibration of all gains as stored in the cache
+  @note Trivially copyable, stored as is
+ */
+struct CalibrationRecord {
+    static constexpr uint32_t MAGIC{0x4C41434DU};  // "MCAL"
+    static constexpr uint8_t VERSION{1};
+
+    uint32_t magic{MAGIC};
+    uint8_t version{VERSION};
+    uint8_t valid{};  //!< Bit per gain
+    std::array<uint8_t, 2> reserved{};
+    uint32_t hash{};                        //!< Content hash of the calibration block of the EEPROM
+    std::array<GainCalibration, 8> gain{};  //!< Per gain
+    uint32_t check{};                       //!< Hash of the preceding fields
+
+    //! @brief Update the check
+    inline void seal()
+    {
+        check = compute();
+    }
+    //! @brief Is the record intact and of this version?
+    inline bool verify() const
+    {
+        return magic == MAGIC && version == VERSION && check == compute();
+    }
+
+private:
+    inline uint32_t compute() const
+    {
+        return fnv1a32(reinterpret_cast<const uint8_t*>(this), offsetof(CalibrationRecord, check));
+    }
+};
+
+/*!
+  @class CalibrationCache
+  @brief Interface of the calibration storage
+  @details The backend implements load(), store() and erase() of the raw record. read() and write() verify and seal
+  the record
+ */
+class CalibrationCache {
+public:
+    //! @brief Buffer size of the key (including the terminator, within the 15 characters of NVS)
+    static constexpr size_t KEY_SIZE{16};
+
+    virtual ~CalibrationCache() = default;
+
+    /*!
+      @brief Make the key
+      @param[out] key Buffer at least KEY_SIZE
+      @param bus Identifier of the bus (e.g. the port number)
+      @param addr Address of the EEPROM
+     */
+    static void makeKey(char* key, const uint8_t bus, const uint8_t addr)
+    {
+        snprintf(key, KEY_SIZE, "mcal_%02X_%02X", bus, addr);
+    }
+
+    /*!
+      @brief Read the record
+      @return True if the record exists and is intact
+     */
+    bool read(const char* key, CalibrationRecord& rec)
+    {
+        return load(key, rec) && rec.verify();
+    }
+    //! @brief Write the record
+    bool write(const char* key, const CalibrationRecord& rec)
+    {
+        CalibrationRecord r = rec;
+        r.seal();
+        return store(key, r);
+    }
+    //! @brief Remove the record
+    inline bool remove(const char* key)
+    {
+        return erase(key);
+    }
+
+protected:
+    virtual bool load(const char* key, CalibrationRecord& rec)        = 0;
+    virtual bool store(const char* key, const CalibrationRecord& rec) = 0;
+    virtual bool erase(const char* key)                               = 0;
+};
+
+/*!
+  @class FileCalibrationCache
+  @brief Stores each record to a file in the directory
+  @note For the host (Linux) and the file systems mounted to the VFS
+ */
+class FileCalibrationCache : public CalibrationCache {
+public:
+    //! @param dir Directory of the files (must exist)
+    explicit FileCalibrationCache(const std::string& dir) : _dir(dir)
+    {
+    }
+
+    //! @brief Path of the file of the key
+    inline std::string path(const char* key) const
+    {
+        return _dir + "/" + key + ".bin";
+    }
+
+protected:
+    virtual bool load(const char* key, CalibrationRecord& rec) override
+    {
+        auto fp = std::fopen(path(key).c_str(), "rb");
+        if (!fp) {
+            return false;
+        }
+        const bool ok = std::fread(&rec, sizeof(rec), 1, fp) == 1;
+        std::fclose(fp);
+        return ok;
+    }
+    virtual bool store(const char* key, const CalibrationRecord& rec) override
+    {
+        // Replace with the complete file, not to leave a torn one
+        const std::string to = path(key);
+        const std::string tmp{to + ".tmp"};
+        auto fp = std::fopen(tmp.c_str(), "wb");
+        if (!fp) {
+            return false;
+        }
+        bool ok = std::fwrite(&rec, sizeof(rec), 1, fp) == 1;
+        ok      = (std::fclose(fp) == 0) && ok;
+        return ok && std::rename(tmp.c_str(), to.c_str()) == 0;
+    }
+    virtual bool erase(const char* key) override
+    {
+        return std::remove(path(key).c_str()) == 0;
+    }
+
+private:
+    std::string _dir{};
+};
+
+/*!
+  @class KeyValueCalibrationCache
+  @brief Stores each record as a blob by the functions of a key-value store
+  @details e.g. Preferences of Arduino-ESP32
+  @code
+  Preferences prefs;  // prefs.begin("m5meter") in setup()
+  m5::unit::meter::KeyValueCalibrationCache cache(
+      [](const char* k, uint8_t* b, size_t n) { return prefs.getBytes(k, b, n) == n; },
+      [](const char* k, const uint8_t* b, size_t n) { return prefs.putBytes(k, b, n) == n; },
+      [](const char* k) { return prefs.remove(k); });
+  @endcode
+ */
+class KeyValueCalibrationCache : public CalibrationCache {
+public:
+    //! @brief Get the blob of the key, true if exists and the length matches
+    using get_function_t = std::function<bool(const char* key, uint8_t* buf, const size_t len)>;
+    //! @brief Set the blob of the key
+    using set_function_t = std::function<bool(const char* key, const uint8_t* buf, const size_t len)>;
+    //! @brief Erase the key
+    using erase_function_t = std::function<bool(const char* key)>;
+
+    KeyValueCalibrationCache(get_function_t get, set_function_t set, erase_function_t erase = nullptr)
+        : _get(get), _set(set), _erase(erase)
+    {
+    }
+
+protected:
+    virtual bool load(const char* key, CalibrationRecord& rec) override
+    {
+        return _get && _get(key, reinterpret_cast<uint8_t*>(&rec), sizeof(rec));
+    }
+    virtual bool store(const char* key, const CalibrationRecord& rec) override
+    {
+        return _set && _set(key, reinterpret_cast<const uint8_t*>(&rec), sizeof(rec));
+    }
+    virtual bool erase(const char* key) override
+    {
+        return _erase && _erase(key);
+    }
+
+private:
+    get_function_t _get{};
+    set_function_t _set{};
+    erase_function_t _erase{};
+};
+
+#if defined(M5_UNIT_METER_CALIBRATION_CACHE_NVS)
+/*!
+  @class NvsCalibrationCache
+  @brief Stores each record as a blob in the NVS namespace
+  @note NVS must have been initialized (nvs_flash_init)
+ */
+class NvsCalibrationCache : public CalibrationCache {
+public:
+    //! @param ns Namespace (up to 15 characters)
+    explicit NvsCalibrationCache(const char* ns = "m5meter") : _ns(ns)
+    {
+    }
+
+protected:
+    virtual bool load(const char* key, CalibrationRecord& rec) override
+    {
+        nvs_handle_t h{};
+        if (nvs_open(_ns, NVS_READONLY, &h) != ESP_OK) {
+            return false;
+        }
+        size_t len    = sizeof(rec);
+        const bool ok = nvs_get_blob(h, key, &rec, &len) == ESP_OK && len == sizeof(rec);
+        nvs_close(h);
+        return ok;
+    }
+    virtual bool store(const char* key, const CalibrationRecord& rec) override
+    {
+        return modify([key, &rec](nvs_handle_t h) { return nvs_set_blob(h, key, &rec, sizeof(rec)); });
+    }
+    virtual bool erase(const char* key) override
+    {
+        return modify([key](nvs_handle_t h) { return nvs_erase_key(h, key); });
+    }
+
+    template <typename F>
+    bool modify(F f)
+    {
+        nvs_handle_t h{};
+        if (nvs_open(_ns, NVS_READWRITE, &h) != ESP_OK) {
+            return false;
+        }
+        const bool ok = f(h) == ESP_OK && nvs_commit(h) == ESP_OK;
+        nvs_close(h);
+        return ok;
+    }
+
+private:
+    const char* _ns{};
+};
+#endif
+
+}  // namespace meter
+}  // namespace unit
+}  // namespace m5
+#endif
@@ -0,0 +1,449 @@
+/*
+ * SPDX-FileCopyrightText: 2024 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+/*!
+  @file meter_coroutine.hpp
+  @brief Optional C++20 coroutine layer for meter units
+  @details Task is the awaitable coroutine type returned by the *Async() functions of the units,
+  and Scheduler resumes the spawned tasks cooperatively in one thread.
+  @code
+  m5::unit::meter::Task<> measure(m5::unit::UnitADS1115& unit)
+  {
+      m5::unit::ads111x::Data d{};
+      if (co_await unit.measureSingleshotAsync(d)) { ... }
+  }
+
+  m5::unit::meter::Scheduler sched{};
+  sched.spawn(measure(unitADS));
+  while (!sched.empty()) {
+      sched.poll();  // Or sleep until sched.nextWakeup()
+  }
+  @endcode
+  @warning A lambda coroutine refers its captures through the closure, so the closure must outlive the task
+*/
+#ifndef M5_UNIT_METER_METER_COROUTINE_HPP
+#define M5_UNIT_METER_METER_COROUTINE_HPP
+
+/*!
+  @def M5_UNIT_METER_COROUTINE
+  @brief Non-zero if the coroutine layer is available
+  @note Enabled if compiled as C++20 or later with <coroutine>. Define 0 in build flags to disable
+ */
+#ifndef M5_UNIT_METER_COROUTINE
+#if defined(__has_include)
+#if __cplusplus >= 202002L && __has_include(<coroutine>)
+#define M5_UNIT_METER_COROUTINE (1)
+#endif
+#endif
+#endif
+#ifndef M5_UNIT_METER_COROUTINE
+#define M5_UNIT_METER_COROUTINE (0)
+#endif
+
+#if M5_UNIT_METER_COROUTINE
+#include "meter_schedule.hpp"
+#include <M5Utility.hpp>
+#include <coroutine>
+#include <cstdint>
+#include <exception>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace m5 {
+namespace unit {
+namespace meter {
+
+class Scheduler;
+template <typename T>
+class Task;
+
+///@cond
+namespace detail {
+
+struct PromiseBase {
+    Scheduler* scheduler{};
+    std::coroutine_handle<> continuation{};
+
+    // Lazy start, resumed by the scheduler or the awaiting task
+    inline std::suspend_always initial_suspend() noexcept
+    {
+        return {};
+    }
+    // Transfer to the awaiting task if any
+    struct FinalAwaiter {
+        inline bool await_ready() noexcept
+        {
+            return false;
+        }
+        template <typename P>
+        inline std::coroutine_handle<> await_suspend(std::coroutine_handle<P> h) noexcept
+        {
+            auto c = h.promise().continuation;
+            return c ? c : std::noop_coroutine();
+        }
+        inline void await_resume() noexcept
+        {
+        }
+    };
+    inline FinalAwaiter final_suspend() noexcept
+    {
+        return {};
+    }
+    // Exceptions may be disabled on the embedded builds
+    inline void unhandled_exception() noexcept
+    {
+        std::terminate();
+    }
+};
+
+template <typename T>
+struct Promise : PromiseBase {
+    T value{};
+    Task<T> get_return_object() noexcept;
+    inline void return_value(T v) noexcept(std::is_nothrow_move_assignable<T>::value)
+    {
+        value = std::move(v);
+    }
+};
+
+template <>
+struct Promise<void> : PromiseBase {
+    Task<void> get_return_object() noexcept;
+    inline void return_void() noexcept
+    {
+    }
+};
+
+}  // namespace detail
+///@endcond
+
+/*!
+  @class Task
+  @brief Coroutine that can be awaited by another task or spawned on the Scheduler
+  @tparam T Result type
+  @note The task does not run until it is awaited or spawned
+  @warning Arguments passed by reference must outlive the task
+ */
+template <typename T = void>
+class Task {
+public:
+    using promise_type = detail::Promise<T>;
+    using handle_type  = std::coroutine_handle<promise_type>;
+
+    Task() = default;
+    explicit Task(handle_type h) : _h(h)
+    {
+    }
+    Task(Task&& o) noexcept : _h(std::exchange(o._h, {}))
+    {
+    }
+    Task& operator=(Task&& o) noexcept
+    {
+        if (this != &o) {
+            destroy();
+            _h = std::exchange(o._h, {});
+        }
+        return *this;
+    }
+    Task(const Task&)            = delete;
+    Task& operator=(const Task&) = delete;
+    ~Task()
+    {
+        destroy();
+    }
+
+    //! @brief Is completed (or empty)?
+    inline bool done() const
+    {
+        return !_h || _h.done();
+    }
+
+    ///@cond
+    inline bool await_ready() const noexcept
+    {
+        return done();
+    }
+    template <typename P>
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<P> caller) noexcept
+    {
+        _h.promise().scheduler    = caller.promise().scheduler;
+        _h.promise().continuation = caller;
+        return _h;
+    }
+    T await_resume()
+    {
+        if constexpr (!std::is_void<T>::value) {
+            return std::move(_h.promise().value);
+        }
+    }
+    ///@endcond
+
+private:
+    friend class Scheduler;
+    inline void destroy()
+    {
+        if (_h) {
+            _h.destroy();
+            _h = {};
+        }
+    }
+
+    handle_type _h{};
+};
+
+///@cond
+namespace detail {
+template <typename T>
+inline Task<T> Promise<T>::get_return_object() noexcept
+{
+    return Task<T>{std::coroutine_handle<Promise<T>>::from_promise(*this)};
+}
+inline Task<void> Promise<void>::get_return_object() noexcept
+{
+    return Task<void>{std::coroutine_handle<Promise<void>>::from_promise(*this)};
+}
+}  // namespace detail
+///@endcond
+
+/*!
+  @class Scheduler
+  @brief Cooperative single thread scheduler of the tasks
+  @details Spawned tasks run until they await sleepFor(), and are resumed by poll() when the time comes.
+  The clock can be replaced, e.g. by a simulated one in the tests.
+  The deadlines of the *Async() functions of the units are also measured by this clock (See also currentTime())
+  @note Time values are the 32-bit microsecond counter and are compared wrap-safely
+ */
+class Scheduler {
+public:
+    //! @brief Clock (us)
+    using clock_function_t = uint32_t (*)();
+
+    explicit Scheduler(clock_function_t clock = &Scheduler::system_clock) : _clock(clock)
+    {
+    }
+    Scheduler(const Scheduler&)            = delete;
+    Scheduler& operator=(const Scheduler&) = delete;
+    ~Scheduler()
+    {
+        for (auto&& h : _roots) {
+            h.destroy();
+        }
+    }
+
+    //! @brief Current time (us)
+    inline uint32_t now() const
+    {
+        return _clock();
+    }
+    //! @brief No task left?
+    inline bool empty() const
+    {
+        return _roots.empty();
+    }
+    //! @brief Number of the spawned tasks not completed
+    inline size_t size() const
+    {
+        return _roots.size();
+    }
+
+    /*!
+      @brief Spawn the task, which runs at the next poll()
+      @param task Task (The scheduler takes the ownership)
+     */
+    template <typename T>
+    void spawn(Task<T>&& task)
+    {
+        auto h = std::exchange(task._h, {});
+        if (!h) {
+            return;
+        }
+        h.promise().scheduler = this;
+        _roots.push_back(h);
+        wake(h, now());
+    }
+
+    /*!
+      @brief Resume the tasks whose time has come
+      @return Number of resumed tasks
+     */
+    size_t poll()
+    {
+        const uint32_t t = now();
+        std::vector<Sleeper> due{};
+        for (auto it = _sleepers.begin(); it != _sleepers.end();) {
+            if ((int32_t)(t - it->at) >= 0) {
+                due.push_back(*it);
+                it = _sleepers.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        // Earliest first, and in order of the request if same time
+        for (size_t i = 1; i < due.size(); ++i) {
+            for (size_t j = i; j > 0 && (int32_t)(due[j].at - due[j - 1].at) < 0; --j) {
+                std::swap(due[j], due[j - 1]);
+            }
+        }
+        for (auto&& s : due) {
+            s.handle.resume();
+        }
+        for (auto it = _roots.begin(); it != _roots.end();) {
+            if (it->done()) {
+                it->destroy();
+                it = _roots.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        return due.size();
+    }
+
+    //! @brief Poll until every task completes
+    void run()
+    {
+        while (!empty()) {
+            poll();
+        }
+    }
+
+    /*!
+      @brief Time until the next wake-up
+      @param[out] us Time (us), zero if due now
+      @return True if any task is waiting
+      @note For sleeping the CPU between the polls
+     */
+    bool nextWakeup(uint32_t& us) const
+    {
+        if (_sleepers.empty()) {
+            return false;
+        }
+        const uint32_t t = now();
+        int32_t earliest = (int32_t)(_sleepers.front().at - t);
+        for (auto&& s : _sleepers) {
+            const int32_t d = (int32_t)(s.at - t);
+            earliest        = d < earliest ? d : earliest;
+        }
+        us = earliest > 0 ? (uint32_t)earliest : 0;
+        return true;
+    }
+
+    ///@cond
+    inline void wake(std::coroutine_handle<> h, const uint32_t at)
+    {
+        _sleepers.push_back(Sleeper{at, h});
+    }
+    ///@endcond
+
+private:
+    struct Sleeper {
+        uint32_t at{};
+        std::coroutine_handle<> handle{};
+    };
+    static uint32_t system_clock()
+    {
+        return (uint32_t)m5::utility::micros();
+    }
+
+    clock_function_t _clock{};
+    std::vector<std::coroutine_handle<>> _roots{};
+    std::vector<Sleeper> _sleepers{};
+};
+
+/*!
+  @struct SleepFor
+  @brief Awaitable that resumes the task after the time
+  @sa sleepFor
+ */
+struct SleepFor {
+    uint32_t us{};
+
+    ///@cond
+    inline bool await_ready() const noexcept
+    {
+        return false;
+    }
+    template <typename P>
+    inline void await_suspend(std::coroutine_handle<P> h) const
+    {
+        auto s = h.promise().scheduler;
+        s->wake(h, s->now() + us);
+    }
+    inline void await_resume() const noexcept
+    {
+    }
+    ///@endcond
+};
+
+/*!
+  @brief Suspend the task for the time and let the others run
+  @param us Time (us), zero to just yield
+ */
+inline SleepFor sleepFor(const uint32_t us)
+{
+    return SleepFor{us};
+}
+
+/*!
+  @struct CurrentTime
+  @brief Awaitable that returns the time of the scheduler running the task without suspending
+  @sa currentTime
+ */
+struct CurrentTime {
+    Scheduler* scheduler{};
+
+    ///@cond
+    inline bool await_ready() const noexcept
+    {
+        return false;
+    }
+    template <typename P>
+    inline bool await_suspend(std::coroutine_handle<P> h) noexcept
+    {
+        scheduler = h.promise().scheduler;
+        return false;  // Resume at once
+    }
+    inline uint32_t await_resume() const
+    {
+        return scheduler->now();
+    }
+    ///@endcond
+};
+
+//! @brief Current time (us) of the scheduler, e.g. uint32_t now = co_await currentTime();
+inline CurrentTime currentTime()
+{
+    return CurrentTime{};
+}
+
+/*!
+  @brief Coroutine version of pollUntilDone()
+  @details Steps by the scheduler clock, and lets the other tasks run while waiting
+  @tparam Step Callable as Progress(const uint32_t now, const uint32_t elapsed, uint32_t& wait), all in us
+  @return True if completed
+  @warning The references captured by the step must outlive the task
+ */
+template <typename Step>
+Task<bool> pollUntilDoneAsync(Step step)
+{
+    const uint32_t start{co_await currentTime()};
+    uint32_t now{start};
+    for (;;) {
+        uint32_t wait{};
+        const Progress p{step(now, now - start, wait)};
+        if (p != Progress::Pending) {
+            co_return p == Progress::Completed;
+        }
+        co_await sleepFor(wait ? wait : 1);
+        now = co_await currentTime();
+    }
+}
+
+}  // namespace meter
+}  // namespace unit
+}  // namespace m5
+
+#endif
+#endif
@@ -0,0 +1,165 @@
+/*
+ * SPDX-FileCopyrightText: 2024 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+/*!
+  @file meter_decimator.hpp
+  @brief Integer decimation stage for 16-bit sample streams
+*/
+#ifndef M5_UNIT_METER_METER_DECIMATOR_HPP
+#define M5_UNIT_METER_METER_DECIMATOR_HPP
+
+#include "meter_timestamp.hpp"
+#include <cstdint>
+#include <limits>
+
+namespace m5 {
+namespace unit {
+namespace meter {
+
+/*!
+  @enum Decimation
+  @brief Decimation filter
+ */
+enum class Decimation : uint8_t {
+    None,    //!< No decimation
+    Boxcar,  //!< N:1 moving sum (mean of each N samples)
+    CIC2,    //!< 2-stage CIC (triangular weighting over 2N samples, better alias rejection than Boxcar)
+};
+
+/*!
+  @struct Aggregate
+  @brief Aggregated record of N input samples
+ */
+struct Aggregate : SampleTimestamp {
+    int32_t sum{};     //!< Filter output (mean x gain)
+    uint32_t gain{1};  //!< Filter gain (N for Boxcar, N^2 for CIC2)
+    int16_t min{};     //!< Minimum input in the decimation period
+    int16_t max{};     //!< Maximum input in the decimation period
+    uint16_t count{};  //!< Number of input samples in the decimation period
+
+    //! @brief Mean with the fractional part
+    inline float mean() const
+    {
+        return (float)sum / gain;
+    }
+    //! @brief Mean rounded to the input resolution
+    inline int16_t meanRaw() const
+    {
+        const int64_t h = gain / 2;
+        return (int16_t)((sum >= 0 ? (int64_t)sum + h : (int64_t)sum - h) / (int64_t)gain);
+    }
+};
+
+/*!
+  @class Decimator
+  @brief N:1 decimation in integer arithmetic
+  @details Keeps the min/max of each decimation period, so that transient peaks are not lost
+ */
+class Decimator {
+public:
+    //! @brief Maximum ratio for CIC2 (The output must fit in int32_t)
+    static constexpr uint16_t MAX_CIC2_RATIO{256};
+
+    /*!
+      @brief Configure
+      @param type Filter
+      @param ratio Decimation ratio N (2 or more)
+      @return True if valid
+     */
+    bool configure(const Decimation type, const uint16_t ratio)
+    {
+        if (type != Decimation::None && (ratio < 2 || (type == Decimation::CIC2 && ratio > MAX_CIC2_RATIO))) {
+            return false;
+        }
+        _type  = type;
+        _ratio = (type != Decimation::None) ? ratio : 1;
+        reset();
+        return true;
+    }
+    //! @brief Clear the filter state
+    inline void reset()
+    {
+        _i1 = _i2 = _z1 = _z2 = 0;
+        _sum                  = 0;
+        _count                = 0;
+        _filled               = false;
+        _min                  = std::numeric_limits<int16_t>::max();
+        _max                  = std::numeric_limits<int16_t>::min();
+    }
+
+    inline Decimation type() const
+    {
+        return _type;
+    }
+    inline uint16_t ratio() const
+    {
+        return _ratio;
+    }
+    inline bool enabled() const
+    {
+        return _type != Decimation::None;
+    }
+
+    /*!
+      @brief Push an input sample
+      @param x Input
+      @param[out] out Aggregated record if returns true
+      @return True if a decimation period is completed
+     */
+    bool push(const int16_t x, Aggregate& out)
+    {
+        _min = x < _min ? x : _min;
+        _max = x > _max ? x : _max;
+        if (_type == Decimation::CIC2) {
+            // Integrators wrap around, the differences in the combs are still correct
+            _i1 += (uint32_t)(int32_t)x;
+            _i2 += _i1;
+        } else {
+            _sum += x;
+        }
+        if (++_count < _ratio) {
+            return false;
+        }
+
+        out.min   = _min;
+        out.max   = _max;
+        out.count = _count;
+        if (_type == Decimation::CIC2) {
+            const uint32_t c1 = _i2 - _z1;
+            const uint32_t c2 = c1 - _z2;
+            _z1               = _i2;
+            _z2               = c1;
+            out.sum           = (int32_t)c2;
+            out.gain          = (uint32_t)_ratio * _ratio;
+        } else {
+            out.sum  = _sum;
+            out.gain = _count;
+        }
+        _sum   = 0;
+        _count = 0;
+        _min   = std::numeric_limits<int16_t>::max();
+        _max   = std::numeric_limits<int16_t>::min();
+
+        // The first CIC2 output is incomplete until the combs are filled
+        if (_type == Decimation::CIC2 && !_filled) {
+            _filled = true;
+            return false;
+        }
+        return true;
+    }
+
+private:
+    Decimation _type{Decimation::None};
+    uint16_t _ratio{1}, _count{};
+    int32_t _sum{};
+    uint32_t _i1{}, _i2{}, _z1{}, _z2{};
+    int16_t _min{std::numeric_limits<int16_t>::max()}, _max{std::numeric_limits<int16_t>::min()};
+    bool _filled{};
+};
+
+}  // namespace meter
+}  // namespace unit
+}  // namespace m5
+#endif
@@ -0,0 +1,66 @@
+/*
+ * SPDX-FileCopyrightText: 2024 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+/*!
+  @file meter_fixed_point.hpp
+  @brief Fixed-point conversion of the raw values for meter units
+  @details The conversion factor (unit per LSB including the calibration) is precomputed as Q16.16,
+  and the raw values are converted with one integer multiply and shift, without the FPU
+*/
+#ifndef M5_UNIT_METER_METER_FIXED_POINT_HPP
+#define M5_UNIT_METER_METER_FIXED_POINT_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+namespace m5 {
+namespace unit {
+namespace meter {
+
+//! @brief Fraction bits of the scale
+constexpr uint8_t SCALE_FRACTION_BITS{16};
+
+/*!
+  @brief Make the scale from the factor
+  @param factor Output unit per LSB
+  @return Q16.16 scale, saturated
+ */
+inline int32_t makeScale(const float factor)
+{
+    const float q = factor * (float)(1UL << SCALE_FRACTION_BITS);
+    if (q >= (float)std::numeric_limits<int32_t>::max()) {
+        return std::numeric_limits<int32_t>::max();
+    }
+    if (q <= (float)std::numeric_limits<int32_t>::min()) {
+        return std::numeric_limits<int32_t>::min();
+    }
+    return (int32_t)(q + (q >= 0.0f ? 0.5f : -0.5f));
+}
+
+//! @brief Scale the raw value (rounded to nearest)
+inline int32_t applyScale(const int32_t raw, const int32_t scale)
+{
+    return (int32_t)(((int64_t)raw * scale + (1L << (SCALE_FRACTION_BITS - 1))) >> SCALE_FRACTION_BITS);
+}
+
+/*!
+  @brief Scale the raw values
+  @param[out] out Output buffer at least len
+  @param raw Raw values
+  @param len Number of the values
+  @param scale Q16.16 scale
+ */
+inline void applyScale(int32_t* out, const int16_t* raw, const size_t len, const int32_t scale)
+{
+    for (size_t i = 0; i < len; ++i) {
+        out[i] = applyScale(raw[i], scale);
+    }
+}
+
+}  // namespace meter
+}  // namespace unit
+}  // namespace m5
+#endif
@@ -0,0 +1,219 @@
+/*
+ * SPDX-FileCopyrightText: 2024 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+/*!
+  @file meter_ring_buffer.hpp
+  @brief Ring buffer of the measurement data with contiguous segment access
+  @details Same interface as m5::container::CircularBuffer as used by the units, plus the access to the stored
+  elements as at most two contiguous segments (oldest part up to the end of the storage, and the wrapped part),
+  so that the consumers can process them in bulk
+*/
+#ifndef M5_UNIT_METER_METER_RING_BUFFER_HPP
+#define M5_UNIT_METER_METER_RING_BUFFER_HPP
+
+#include <M5Utility.hpp>
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace m5 {
+namespace unit {
+namespace meter {
+
+/*!
+  @struct Span
+  @brief Contiguous elements
+ */
+template <typename T>
+struct Span {
+    T* ptr{};
+    size_t len{};
+
+    inline T* data() const
+    {
+        return ptr;
+    }
+    inline size_t size() const
+    {
+        return len;
+    }
+    inline bool empty() const
+    {
+        return !len;
+    }
+    inline T* begin() const
+    {
+        return ptr;
+    }
+    inline T* end() const
+    {
+        return ptr + len;
+    }
+    inline T& operator[](const size_t i) const
+    {
+        return ptr[i];
+    }
+};
+
+/*!
+  @class RingBuffer
+  @brief Fixed capacity ring buffer, overwriting the oldest if full
+  @tparam T Element type
+ */
+template <typename T>
+class RingBuffer {
+public:
+    using value_type      = T;
+    using size_type       = size_t;
+    using reference       = T&;
+    using const_reference = const T&;
+
+    //! @param n Capacity (at least 1)
+    explicit RingBuffer(const size_t n) : _buf(n ? n : 1)
+    {
+    }
+
+    ///@name Capacity
+    ///@{
+    inline size_t capacity() const
+    {
+        return _buf.size();
+    }
+    inline size_t size() const
+    {
+        return _size;
+    }
+    inline bool empty() const
+    {
+        return !_size;
+    }
+    inline bool full() const
+    {
+        return _size == capacity();
+    }
+    ///@}
+
+    ///@name Element access
+    ///@{
+    //! @brief Oldest element
+    inline m5::stl::optional<T> front() const
+    {
+        return !empty() ? m5::stl::optional<T>(_buf[_tail]) : m5::stl::nullopt;
+    }
+    //! @brief Latest element
+    inline m5::stl::optional<T> back() const
+    {
+        return !empty() ? m5::stl::optional<T>((*this)[_size - 1]) : m5::stl::nullopt;
+    }
+    //! @brief Element from the oldest
+    inline const_reference operator[](const size_t i) const
+    {
+        return _buf[index(i)];
+    }
+    inline const_reference at(const size_t i) const
+    {
+        assert(i < size() && "Out of range");
+        return (*this)[i];
+    }
+    /*!
+      @brief Stored elements from the oldest as contiguous segments
+      @param[out] first Oldest part, up to the end of the storage
+      @param[out] second Wrapped part, empty if not wrapped
+      @param max Up to the number of elements
+      @return Number of elements of the segments
+     */
+    size_t segments(Span<const T>& first, Span<const T>& second, const size_t max = SIZE_MAX) const
+    {
+        const size_t n   = std::min(_size, max);
+        const size_t one = std::min(n, capacity() - _tail);
+        first            = Span<const T>{_buf.data() + _tail, one};
+        second           = Span<const T>{_buf.data(), n - one};
+        return n;
+    }
+    ///@}
+
+    ///@name Modifiers
+    ///@{
+    //! @brief Push the element, overwriting the oldest if full
+    void push_back(const T& v)
+    {
+        _buf[index(_size)] = v;
+        if (full()) {
+            _tail = index(1);
+        } else {
+            ++_size;
+        }
+    }
+    //! @brief Remove the oldest
+    inline void pop_front()
+    {
+        pop_front(1);
+    }
+    /*!
+      @brief Remove the oldest elements
+      @return Number of removed elements
+     */
+    size_t pop_front(const size_t n)
+    {
+        const size_t cnt = std::min(n, _size);
+        _tail            = (_size == cnt) ? 0 : index(cnt);
+        _size -= cnt;
+        return cnt;
+    }
+    inline void clear()
+    {
+        _tail = _size = 0;
+    }
+    ///@}
+
+    /*!
+      @brief Copy the oldest elements and remove them
+      @param[out] out Output buffer
+      @param len Up to the number of elements
+      @return Number of elements
+     */
+    size_t read(T* out, const size_t len)
+    {
+        return consume(len,
+                       [out](const T* p, const size_t n, const size_t offset) { std::copy(p, p + n, out + offset); });
+    }
+    /*!
+      @brief Process the oldest elements segment by segment and remove them
+      @param len Up to the number of elements
+      @param f Function called with (segment, number of elements, offset from the oldest) for each segment
+      @return Number of elements
+     */
+    template <class F>
+    size_t consume(const size_t len, F f)
+    {
+        Span<const T> a{}, b{};
+        const size_t n = segments(a, b, len);
+        if (!a.empty()) {
+            f(a.data(), a.size(), 0);
+        }
+        if (!b.empty()) {
+            f(b.data(), b.size(), a.size());
+        }
+        pop_front(n);
+        return n;
+    }
+
+private:
+    inline size_t index(const size_t i) const
+    {
+        const size_t idx = _tail + i;
+        return idx < capacity() ? idx : idx - capacity();
+    }
+
+    std::vector<T> _buf{};
+    size_t _tail{}, _size{};
+};
+
+}  // namespace meter
+}  // namespace unit
+}  // namespace m5
+#endif
@@ -0,0 +1,311 @@
+/*
+ * SPDX-FileCopyrightText: 2024 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+/*!
+  @file meter_schedule.hpp
+  @brief Microsecond periodic schedule, ready notification, single-shot request and polled operation for meter units
+*/
+#ifndef M5_UNIT_METER_METER_SCHEDULE_HPP
+#define M5_UNIT_METER_METER_SCHEDULE_HPP
+
+#include <M5Utility.hpp>
+#include <cstdint>
+
+namespace m5 {
+namespace unit {
+namespace meter {
+
+//! @brief Longest time span (us) that the 32-bit microsecond counter can compare wrap-safely
+constexpr uint32_t MAX_SPAN_MICROS{0x7FFFFFFFU};
+//! @brief Longest time span (ms), about 35.8 minutes
+constexpr uint32_t MAX_SPAN_MILLIS{MAX_SPAN_MICROS / 1000U};
+
+//! @brief Milliseconds to microseconds, saturated at MAX_SPAN_MICROS
+inline uint32_t millisToMicros(const uint32_t ms)
+{
+    return ms <= MAX_SPAN_MILLIS ? ms * 1000U : MAX_SPAN_MICROS;
+}
+
+/*!
+  @class Schedule
+  @brief Phase-locked periodic deadline in microseconds
+  @details The next deadline advances by the interval from the previous deadline, not from the time of the read,
+  so that the sampling phase does not drift. If the caller falls behind by more than one interval, the schedule
+  resynchronizes to the current time instead of bursting to catch up.
+  @note Time values are the 32-bit microsecond counter and are compared wrap-safely
+ */
+class Schedule {
+public:
+    //! @brief Clear the deadline and statistics, keeping the interval
+    inline void reset()
+    {
+        _next = _last = _count = 0;
+        _span                  = 0;
+        _started = _deferred = _retrying = false;
+    }
+    /*!
+      @brief Clear and defer the first deadline
+      @param at The first deadline (us)
+     */
+    inline void reset(const uint32_t at)
+    {
+        reset();
+        _next     = at;
+        _deferred = true;
+    }
+
+    //! @brief Interval (us)
+    inline uint32_t interval() const
+    {
+        return _interval;
+    }
+    //! @brief Set interval (us)
+    inline void interval(const uint32_t us)
+    {
+        _interval = us;
+    }
+
+    //! @brief Is the deadline reached at now (us)?
+    inline bool due(const uint32_t now) const
+    {
+        if (_retrying && (int32_t)(now - _retry) < 0) {
+            return false;
+        }
+        return (!_started && !_deferred) || (int32_t)(now - _next) >= 0;
+    }
+    /*!
+      @brief Time the deadline is reached
+      @param now Current time (us)
+      @return The retry time if holding off, otherwise the deadline (now if not started)
+     */
+    inline uint32_t next(const uint32_t now) const
+    {
+        if (_retrying) {
+            return _retry;
+        }
+        return (!_started && !_deferred) ? now : _next;
+    }
+
+    /*!
+      @brief Hold off until the retry time when the device was not ready at the deadline
+      @param now Current time (us)
+      @param after Retry after (us)
+      @note The phase of the deadline is kept. Cleared by advance()
+     */
+    inline void retry(const uint32_t now, const uint32_t after)
+    {
+        _retry    = now + after;
+        _retrying = true;
+    }
+
+    /*!
+      @brief Record a sample taken at now (us) and advance the deadline
+      @param now Current time (us)
+     */
+    void advance(const uint32_t now)
+    {
+        if (!_started) {
+            _started = true;
+            _next    = now;
+            _last    = now;
+        }
+        _next += _interval;
+        if ((int32_t)(now - _next) >= 0) {
+            // Missed more than one period, resynchronize
+            _next = now + _interval;
+        }
+        _span += now - _last;
+        _last     = now;
+        _retrying = false;
+        ++_count;
+    }
+
+    /*!
+      @brief Effective sample rate (Hz) measured since the first sample
+      @return Rate, or zero if less than two samples
+     */
+    inline float effectiveRate() const
+    {
+        return (_count > 1 && _span) ? (float)(_count - 1) * 1000000.f / (float)_span : 0.0f;
+    }
+    //! @brief Number of samples since reset
+    inline uint32_t count() const
+    {
+        return _count;
+    }
+
+private:
+    uint32_t _interval{}, _next{}, _last{}, _count{}, _retry{};
+    uint64_t _span{};  // Total time between the first and the last sample (us)
+    bool _started{}, _deferred{}, _retrying{};
+};
+
+/*!
+  @class ReadyNotifier
+  @brief Counts the ready notifications from the device (e.g. ALERT/RDY pin edges)
+  @details notify() only counts, so it is safe to call from ISR or a simulated pin.
+  The consumer reads the device once per consume() that returns true
+ */
+class ReadyNotifier {
+public:
+    //! @brief Notify that the device is ready
+    inline void notify()
+    {
+        _notified = _notified + 1;
+    }
+    /*!
+      @brief Consume the notifications
+      @return True if notified since the last call
+      @note If notified more than once, the surplus is counted as overruns
+     */
+    bool consume()
+    {
+        const uint32_t notified = _notified;
+        if (notified == _consumed) {
+            return false;
+        }
+        _overruns += notified - _consumed - 1;
+        _consumed = notified;
+        return true;
+    }
+    //! @brief Discard the pending notifications and clear the overruns
+    inline void reset()
+    {
+        _consumed = _notified;
+        _overruns = 0;
+    }
+    //! @brief Number of notifications that were not consumed in time
+    inline uint32_t overruns() const
+    {
+        return _overruns;
+    }
+
+private:
+    volatile uint32_t _notified{};
+    uint32_t _consumed{}, _overruns{};
+};
+
+/*!
+  @enum SingleshotState
+  @brief State of the asynchronous single-shot request
+ */
+enum class SingleshotState : uint8_t {
+    Idle,        //!< No request, or the result has been taken
+    Converting,  //!< Requested and waiting for the conversion
+    Completed,   //!< Completed and the result is not taken yet
+    Failed,      //!< Failed to access or timed out
+};
+
+/*!
+  @class SingleshotRequest
+  @brief Deadline of the asynchronous single-shot conversion
+  @details The device is not accessed until the expected conversion time has passed.
+  If it is still converting at that time, the next check is after a fraction of the expected time
+  @note Time values are the 32-bit microsecond counter and are compared wrap-safely
+ */
+class SingleshotRequest {
+public:
+    //! @brief Divisor of the expected time for the check interval after the expected time
+    static constexpr uint32_t POLL_DIVISOR{16};
+
+    inline SingleshotState state() const
+    {
+        return _state;
+    }
+    //! @brief Waiting for the conversion?
+    inline bool pending() const
+    {
+        return _state == SingleshotState::Converting;
+    }
+
+    /*!
+      @brief Start waiting for the conversion
+      @param now Time when the conversion was started (us)
+      @param expected Expected conversion time (us)
+      @param timeout Fail if not completed within (us)
+     */
+    inline void start(const uint32_t now, const uint32_t expected, const uint32_t timeout)
+    {
+        _state    = SingleshotState::Converting;
+        _expected = expected;
+        _check    = now + expected;
+        _deadline = now + timeout;
+    }
+    //! @brief Is it time to check the device?
+    inline bool due(const uint32_t now) const
+    {
+        return pending() && (int32_t)(now - _check) >= 0;
+    }
+    //! @brief Time until the next check (us), zero if due
+    inline uint32_t remaining(const uint32_t now) const
+    {
+        return (int32_t)(now - _check) >= 0 ? 0 : _check - now;
+    }
+    //! @brief Still converting at now (us), check again later
+    inline void retry(const uint32_t now)
+    {
+        const uint32_t after = _expected / POLL_DIVISOR;
+        _check               = now + (after ? after : 1);
+    }
+    //! @brief Is the timeout reached at now (us)?
+    inline bool expired(const uint32_t now) const
+    {
+        return (int32_t)(now - _deadline) >= 0;
+    }
+    //! @brief Finish the request
+    inline void complete(const bool ok)
+    {
+        _state = ok ? SingleshotState::Completed : SingleshotState::Failed;
+    }
+    //! @brief The result has been taken
+    inline void clear()
+    {
+        _state = SingleshotState::Idle;
+    }
+
+private:
+    uint32_t _expected{}, _check{}, _deadline{};
+    SingleshotState _state{SingleshotState::Idle};
+};
+
+/*!
+  @enum Progress
+  @brief Result of one step of the polled operation
+ */
+enum class Progress : uint8_t {
+    Pending,    //!< Not yet, step again after the wait
+    Completed,  //!< Succeeded
+    Failed,     //!< Failed to access or timed out
+};
+
+/*!
+  @brief Step the operation until it is not pending, sleeping for the requested wait between the steps
+  @tparam Step Callable as Progress(const uint32_t now, const uint32_t elapsed, uint32_t& wait), all in us.
+  elapsed is the time since the first step, and wait is the time until the next step if pending
+  @return True if completed
+  @note The blocking functions of the units and their *Async() counterparts (pollUntilDoneAsync) share the step
+ */
+template <typename Step>
+bool pollUntilDone(Step&& step)
+{
+    const uint32_t start{(uint32_t)m5::utility::micros()};
+    uint32_t now{start};
+    for (;;) {
+        uint32_t wait{};
+        const Progress p{step(now, now - start, wait)};
+        if (p != Progress::Pending) {
+            return p == Progress::Completed;
+        }
+        if (wait >= 1000) {
+            m5::utility::delay(wait / 1000);
+        }
+        now = (uint32_t)m5::utility::micros();
+    }
+}
+
+}  // namespace meter
+}  // namespace unit
+}  // namespace m5
+#endif
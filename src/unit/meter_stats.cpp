@@ -0,0 +1,27 @@
+/*
+ * SPDX-FileCopyrightText: 2024 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+/*!
+  @file meter_stats.cpp
+  @brief Link-time guard of M5_UNIT_METER_BUS_STATS
+*/
+#include "meter_stats.hpp"
+
+namespace m5 {
+namespace unit {
+namespace meter {
+namespace build_guard {
+
+// Defined for the setting of the library build only
+#if M5_UNIT_METER_BUS_STATS != 0
+const uint8_t bus_stats_enabled{1};
+#else
+const uint8_t bus_stats_disabled{0};
+#endif
+
+}  // namespace build_guard
+}  // namespace meter
+}  // namespace unit
+}  // namespace m5
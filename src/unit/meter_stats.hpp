@@ -0,0 +1,281 @@
+/*
+ * SPDX-FileCopyrightText: 2024 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+/*!
+  @file meter_stats.hpp
+  @brief Optional I2C access accounting and call latency for meter units
+*/
+#ifndef M5_UNIT_METER_METER_STATS_HPP
+#define M5_UNIT_METER_METER_STATS_HPP
+
+#include <M5Utility.hpp>
+#include <array>
+#include <cstdint>
+
+/*!
+  @def M5_UNIT_METER_BUS_STATS
+  @brief Non-zero to count the register accesses and measure the call latencies of each unit
+  @note Define in build flags. If zero, the accounting compiles to nothing
+  @warning It changes the layout of the units, so it must be the same for the whole build
+  (e.g. build_flags of platformio.ini, not a #define before the include). A mismatch fails to link
+  (undefined m5::unit::meter::build_guard::bus_stats_enabled or bus_stats_disabled)
+ */
+#ifndef M5_UNIT_METER_BUS_STATS
+#define M5_UNIT_METER_BUS_STATS (0)
+#endif
+
+namespace m5 {
+namespace unit {
+namespace meter {
+
+/*!
+  @enum Call
+  @brief Instrumented API calls
+ */
+enum class Call : uint8_t {
+    Begin,       //!< begin()
+    Update,      //!< update() that accessed the bus
+    Singleshot,  //!< measureSingleshot()
+};
+
+/*!
+  @struct Histogram
+  @brief Latency histogram in power-of-two microsecond buckets
+  @details bucket[0] counts less than 1 us, bucket[n] counts [2^(n-1), 2^n) us, and the last one counts the rest
+ */
+struct Histogram {
+    static constexpr uint8_t BUCKETS{16};
+    std::array<uint32_t, BUCKETS> bucket{};
+    uint32_t count{};
+    uint32_t min{};
+    uint32_t max{};
+    uint64_t total{};  //!< Sum of latencies (us)
+
+    void record(const uint32_t us)
+    {
+        uint_fast8_t b{};
+        for (uint32_t v = us; v && b < BUCKETS - 1; v >>= 1) {
+            ++b;
+        }
+        ++bucket[b];
+        min = (!count || us < min) ? us : min;
+        max = us > max ? us : max;
+        total += us;
+        ++count;
+    }
+    //! @brief Mean latency (us)
+    inline float mean() const
+    {
+        return count ? (float)total / count : 0.0f;
+    }
+};
+
+/*!
+  @struct RegisterCount
+  @brief Accesses to a register
+ */
+struct RegisterCount {
+    uint8_t reg{};
+    uint32_t reads{};
+    uint32_t writes{};
+};
+
+/*!
+  @struct BusStats
+  @brief Register access counters and call latencies of the unit
+  @tparam Enabled Count if true, otherwise empty and every function is a no-op
+ */
+template <bool Enabled>
+struct BusStats {
+    static constexpr bool enabled{false};
+
+    ///@cond
+    struct Scope {
+        ~Scope()
+        {
+        }
+    };
+    inline uint32_t mark() const
+    {
+        return 0;
+    }
+    inline void read(const uint8_t, const uint32_t, const bool, const uint32_t)
+    {
+    }
+    inline void write(const uint8_t, const uint32_t, const bool, const uint32_t)
+    {
+    }
+    inline void poll()
+    {
+    }
+    inline Scope scope(const Call)
+    {
+        return Scope{};
+    }
+    inline void reset()
+    {
+    }
+    inline void dump(const char*) const
+    {
+    }
+    ///@endcond
+};
+
+///@cond
+template <>
+struct BusStats<true> {
+    static constexpr bool enabled{true};
+    static constexpr uint8_t REGISTER_SLOTS{16};
+
+    uint32_t reads{};        //!< Register reads
+    uint32_t writes{};       //!< Register writes
+    uint32_t read_bytes{};   //!< Payload bytes read
+    uint32_t write_bytes{};  //!< Payload bytes written
+    uint32_t errors{};       //!< Failed accesses
+    uint32_t polls{};        //!< Wait loop iterations and periodic updates that found the unit not ready
+    uint64_t bus_us{};       //!< Time spent in the register accesses (us)
+    std::array<RegisterCount, REGISTER_SLOTS> registers{};  //!< Per register counters in order of first access
+    uint8_t used_slots{};
+    uint32_t unlisted{};  //!< Accesses to the registers beyond the slots
+    std::array<Histogram, 3> latency{};
+
+    //! @brief Records the call latency when it goes out of the scope
+    class Scope {
+    public:
+        Scope(Histogram& h) : _h(&h), _at((uint32_t)m5::utility::micros())
+        {
+        }
+        Scope(Scope&& o) : _h(o._h), _at(o._at)
+        {
+            o._h = nullptr;
+        }
+        Scope(const Scope&)            = delete;
+        Scope& operator=(const Scope&) = delete;
+        ~Scope()
+        {
+            if (_h) {
+                _h->record((uint32_t)m5::utility::micros() - _at);
+            }
+        }
+
+    private:
+        Histogram* _h{};
+        uint32_t _at{};
+    };
+
+    //! @brief Start of the access (us)
+    inline uint32_t mark() const
+    {
+        return (uint32_t)m5::utility::micros();
+    }
+    void read(const uint8_t reg, const uint32_t len, const bool ok, const uint32_t at)
+    {
+        ++reads;
+        read_bytes += len;
+        if (auto rc = account(reg, ok, at)) {
+            ++rc->reads;
+        }
+    }
+    void write(const uint8_t reg, const uint32_t len, const bool ok, const uint32_t at)
+    {
+        ++writes;
+        write_bytes += len;
+        if (auto rc = account(reg, ok, at)) {
+            ++rc->writes;
+        }
+    }
+    inline void poll()
+    {
+        ++polls;
+    }
+    inline Scope scope(const Call c)
+    {
+        return Scope(latency[static_cast<uint8_t>(c)]);
+    }
+    inline const Histogram& of(const Call c) const
+    {
+        return latency[static_cast<uint8_t>(c)];
+    }
+    //! @brief Find the counters of the register
+    const RegisterCount* find(const uint8_t reg) const
+    {
+        for (uint_fast8_t i = 0; i < used_slots; ++i) {
+            if (registers[i].reg == reg) {
+                return &registers[i];
+            }
+        }
+        return nullptr;
+    }
+    inline void reset()
+    {
+        *this = BusStats{};
+    }
+    void dump(const char* name) const
+    {
+        static constexpr const char* call_name[] = {"begin", "update", "singleshot"};
+        (void)name;  // Unused if the log level is lower
+        (void)call_name;
+        M5_LIB_LOGI("%s: R:%u(%uB) W:%u(%uB) E:%u P:%u bus:%llu us", name ? name : "", (unsigned)reads,
+                    (unsigned)read_bytes, (unsigned)writes, (unsigned)write_bytes, (unsigned)errors, (unsigned)polls,
+                    (unsigned long long)bus_us);
+        for (uint_fast8_t i = 0; i < used_slots; ++i) {
+            M5_LIB_LOGI("  REG:%02X R:%u W:%u", registers[i].reg, (unsigned)registers[i].reads,
+                        (unsigned)registers[i].writes);
+        }
+        for (uint_fast8_t i = 0; i < latency.size(); ++i) {
+            if (latency[i].count) {
+                M5_LIB_LOGI("  %s: n:%u min:%u max:%u mean:%.1f us", call_name[i], (unsigned)latency[i].count,
+                            (unsigned)latency[i].min, (unsigned)latency[i].max, latency[i].mean());
+            }
+        }
+    }
+
+protected:
+    RegisterCount* account(const uint8_t reg, const bool ok, const uint32_t at)
+    {
+        errors += ok ? 0 : 1;
+        bus_us += (uint32_t)m5::utility::micros() - at;
+        for (uint_fast8_t i = 0; i < used_slots; ++i) {
+            if (registers[i].reg == reg) {
+                return &registers[i];
+            }
+        }
+        if (used_slots < REGISTER_SLOTS) {
+            registers[used_slots].reg = reg;
+            return &registers[used_slots++];
+        }
+        ++unlisted;
+        return nullptr;
+    }
+};
+///@endcond
+
+//! @brief Statistics type used by the units
+using UnitBusStats = BusStats<M5_UNIT_METER_BUS_STATS != 0>;
+
+///@cond
+// Same as the guard of M5_UNIT_METER_SAMPLE_TIMESTAMP, only the symbol of the library build is defined
+// (meter_stats.cpp)
+namespace build_guard {
+#if M5_UNIT_METER_BUS_STATS != 0
+extern const uint8_t bus_stats_enabled;
+#if defined(__GNUC__)
+__attribute__((used))
+#endif
+static const uint8_t bus_stats_guard{bus_stats_enabled};
+#else
+extern const uint8_t bus_stats_disabled;
+#if defined(__GNUC__)
+__attribute__((used))
+#endif
+static const uint8_t bus_stats_guard{bus_stats_disabled};
+#endif
+}  // namespace build_guard
+///@endcond
+
+}  // namespace meter
+}  // namespace unit
+}  // namespace m5
+#endif
@@ -0,0 +1,27 @@
+/*
+ * SPDX-FileCopyrightText: 2024 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+/*!
+  @file meter_timestamp.cpp
+  @brief Link-time guard of M5_UNIT_METER_SAMPLE_TIMESTAMP
+*/
+#include "meter_timestamp.hpp"
+
+namespace m5 {
+namespace unit {
+namespace meter {
+namespace build_guard {
+
+// Defined for the setting of the library build only
+#if M5_UNIT_METER_SAMPLE_TIMESTAMP != 0
+const uint8_t sample_timestamp_enabled{1};
+#else
+const uint8_t sample_timestamp_disabled{0};
+#endif
+
+}  // namespace build_guard
+}  // namespace meter
+}  // namespace unit
+}  // namespace m5
@@ -0,0 +1,94 @@
+/*
+ * SPDX-FileCopyrightText: 2024 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+/*!
+  @file meter_timestamp.hpp
+  @brief Optional per-sample timestamp for measurement data
+*/
+#ifndef M5_UNIT_METER_METER_TIMESTAMP_HPP
+#define M5_UNIT_METER_METER_TIMESTAMP_HPP
+
+#include <cstdint>
+
+/*!
+  @def M5_UNIT_METER_SAMPLE_TIMESTAMP
+  @brief Non-zero to record the acquisition time in each measurement data
+  @note Define in build flags. The default keeps the data layout compact
+  @warning It changes the layout of the measurement data and the units, so it must be the same for the whole build
+  (e.g. build_flags of platformio.ini, not a #define before the include). A mismatch fails to link
+  (undefined m5::unit::meter::build_guard::sample_timestamp_enabled or sample_timestamp_disabled)
+ */
+#ifndef M5_UNIT_METER_SAMPLE_TIMESTAMP
+#define M5_UNIT_METER_SAMPLE_TIMESTAMP (0)
+#endif
+
+namespace m5 {
+namespace unit {
+namespace meter {
+
+/*!
+  @struct Timestamp
+  @brief Acquisition time of the sample
+  @tparam Enabled Store the time if true, otherwise empty (no storage)
+ */
+template <bool Enabled>
+struct Timestamp {
+    static constexpr bool enabled{false};
+    //! @brief Acquisition time (us), always zero if not enabled
+    inline uint32_t timestamp() const
+    {
+        return 0;
+    }
+    //! @brief Record the acquisition time (us)
+    inline void stamp(const uint32_t)
+    {
+    }
+};
+
+///@cond
+template <>
+struct Timestamp<true> {
+    static constexpr bool enabled{true};
+    inline uint32_t timestamp() const
+    {
+        return _at;
+    }
+    inline void stamp(const uint32_t us)
+    {
+        _at = us;
+    }
+
+private:
+    uint32_t _at{};
+};
+///@endcond
+
+//! @brief Timestamp type used by measurement data
+using SampleTimestamp = Timestamp<M5_UNIT_METER_SAMPLE_TIMESTAMP != 0>;
+
+///@cond
+// Each translation unit refers to the symbol of its own setting on the static initialization (so that the reference
+// is not removed by the linker), and only the one of the library build is defined (meter_timestamp.cpp)
+namespace build_guard {
+#if M5_UNIT_METER_SAMPLE_TIMESTAMP != 0
+extern const uint8_t sample_timestamp_enabled;
+#if defined(__GNUC__)
+__attribute__((used))
+#endif
+static const uint8_t sample_timestamp_guard{sample_timestamp_enabled};
+#else
+extern const uint8_t sample_timestamp_disabled;
+#if defined(__GNUC__)
+__attribute__((used))
+#endif
+static const uint8_t sample_timestamp_guard{sample_timestamp_disabled};
+#endif
+}  // namespace build_guard
+///@endcond
+
+}  // namespace meter
+}  // namespace unit
+}  // namespace m5
+#endif
@@ -26,7 +26,9 @@ bool UnitADS1113::start_periodic_measurement(const ads111x::Sampling rate, const
                                              const ads111x::ComparatorQueue)
 {
     M5_LIB_LOGW("mux, gain, and comp_que not support");
-    return writeSamplingRate(rate) && UnitADS111x::start_periodic_measurement();
+    Config c{};
+    // Sampling rate and mode in one transaction
+    return current_config(c) && UnitADS111x::start_periodic_measurement(c.dr(rate));
 }
 
 }  // namespace unit
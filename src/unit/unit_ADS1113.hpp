@@ -63,6 +63,12 @@ public:
     }
     ///@}
 
+    //!  @brief Not support @warning Not support
+    virtual bool enableConversionReady(const bool, const bool = false) override
+    {
+        return false;
+    }
+
 protected:
     virtual bool start_periodic_measurement(const ads111x::Sampling rate, const ads111x::Mux mux,
                                             const ads111x::Gain gain, const ads111x::ComparatorQueue comp_que) override;
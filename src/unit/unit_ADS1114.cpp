@@ -26,8 +26,9 @@ bool UnitADS1114::start_periodic_measurement(const ads111x::Sampling rate, const
                                              const ads111x::ComparatorQueue comp_que)
 {
     M5_LIB_LOGW("mux is not support");
-    return writeSamplingRate(_cfg.rate) && writeGain(_cfg.gain) && writeComparatorQueue(_cfg.comp_que) &&
-           UnitADS111x::start_periodic_measurement();
+    Config c{};
+    // All fields and mode in one transaction
+    return current_config(c) && UnitADS111x::start_periodic_measurement(c.dr(rate).pga(gain).comp_que(comp_que));
 }
 
 }  // namespace unit
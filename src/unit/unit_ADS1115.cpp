@@ -15,6 +15,15 @@ using namespace m5::unit::types;
 using namespace m5::unit::ads111x;
 using namespace m5::unit::ads111x::command;
 
+namespace {
+// Conversion time (us) with the tolerance of the internal oscillator (+10%) and the wake-up time
+constexpr uint32_t conversion_time_table[] = {
+    1000000UL * 11 / 10 / 8 + 100,   1000000UL * 11 / 10 / 16 + 100,  1000000UL * 11 / 10 / 32 + 100,
+    1000000UL * 11 / 10 / 64 + 100,  1000000UL * 11 / 10 / 128 + 100, 1000000UL * 11 / 10 / 250 + 100,
+    1000000UL * 11 / 10 / 475 + 100, 1000000UL * 11 / 10 / 860 + 100,
+};
+}  // namespace
+
 namespace m5 {
 namespace unit {
 // class UnitADS1115
@@ -25,8 +34,116 @@ const types::attr_t UnitADS1115::attr{attribute::AccessI2C};
 bool UnitADS1115::start_periodic_measurement(const ads111x::Sampling rate, const ads111x::Mux mux,
                                              const ads111x::Gain gain, const ads111x::ComparatorQueue comp_que)
 {
-    return writeSamplingRate(_cfg.rate) && writeMultiplexer(_cfg.mux) && writeGain(_cfg.gain) &&
-           writeComparatorQueue(_cfg.comp_que) && UnitADS111x::start_periodic_measurement();
+    Config c{};
+    // All fields and mode in one transaction
+    return current_config(c) &&
+           UnitADS111x::start_periodic_measurement(c.dr(rate).mux(mux).pga(gain).comp_que(comp_que));
+}
+
+void UnitADS1115::update(const bool force)
+{
+    if (inScan()) {
+        // Not forced, the conversion register holds the previous slot until the conversion completes
+        update_scan();
+        return;
+    }
+    UnitADS111x::update(force);
+}
+
+bool UnitADS1115::nextDue(uint32_t& at) const
+{
+    if (inScan()) {
+        at = _scan_started_at + _scan_wait;
+        return true;
+    }
+    return UnitADS111x::nextDue(at);
+}
+
+bool UnitADS1115::startScanMeasurement(const ads111x::ScanSlot* slots, const size_t num)
+{
+    if (inPeriodic() || inScan() || singleshotState() == meter::SingleshotState::Converting) {
+        M5_LIB_LOGW("Periodic, scan or single shot measurements are running");
+        return false;
+    }
+    if (!slots || !num || num > 256) {
+        M5_LIB_LOGE("Invalid scan list %p:%zu", slots, num);
+        return false;
+    }
+    if (!current_config(_scan_restore)) {
+        return false;
+    }
+
+    _scan_slots.assign(slots, slots + num);
+    _scan_data.clear();
+    for (size_t i = 0; i < num; ++i) {
+        _scan_data.emplace_back(new meter::RingBuffer<ScanData>(stored_size()));
+    }
+    _updated  = false;
+    _scanning = start_scan_slot(0);
+    return _scanning;
+}
+
+bool UnitADS1115::stopScanMeasurement()
+{
+    if (!inScan()) {
+        return false;
+    }
+    _scanning = false;
+    _updated  = false;
+    // Restore the settings and derived values at once
+    return commit_config(_scan_restore.mode(true));
+}
+
+void UnitADS1115::scanFlush()
+{
+    for (auto&& b : _scan_data) {
+        b->clear();
+    }
+}
+
+bool UnitADS1115::start_scan_slot(const uint8_t slot)
+{
+    auto& ss = _scan_slots[slot];
+    Config c{_scan_restore};
+    // Single-shot mode and start conversion in one transaction
+    c.mux(ss.mux).pga(ss.gain).dr(ss.rate).mode(true).os(true);
+    // The slot is kept even on failure, so that update_scan() retries the start of the same slot
+    _scan_idx        = slot;
+    _scan_converting = write_config(c);
+    if (_scan_converting) {
+        _scan_started_at = m5::utility::micros();
+        _scan_wait       = conversion_time_table[m5::stl::to_underlying(ss.rate)];
+    }
+    return _scan_converting;
+}
+
+void UnitADS1115::update_scan()
+{
+    _updated = false;
+    if (!_scan_converting) {
+        // The conversion has not been started, so there is nothing to read yet
+        start_scan_slot(_scan_idx);
+        return;
+    }
+    auto at = m5::utility::micros();
+    if ((uint32_t)(at - _scan_started_at) < _scan_wait) {
+        return;
+    }
+
+    ScanData sd{};
+    sd.slot = _scan_idx;
+    sd.gain = _scan_slots[_scan_idx].gain;
+    if (!read_register16(CONVERSION_REG, sd.raw)) {
+        // Retry from the same slot
+        start_scan_slot(_scan_idx);
+        return;
+    }
+    // Start the next slot immediately after reading
+    start_scan_slot((_scan_idx + 1) % _scan_slots.size());
+
+    _scan_data[sd.slot]->push_back(sd);
+    _updated = true;
+    _latest  = m5::utility::millis();
 }
 
 }  // namespace unit
@@ -11,9 +11,38 @@
 #define M5_UNIT_METER_UNIT_ADS1115_HPP
 
 #include "unit_ADS111x.hpp"
+#include <vector>
 
 namespace m5 {
 namespace unit {
+
+namespace ads111x {
+/*!
+  @struct ScanSlot
+  @brief Settings of one slot of the scan list
+ */
+struct ScanSlot {
+    Mux mux{Mux::AIN_01};              //!< Input multiplexer
+    Gain gain{Gain::PGA_2048};         //!< Programmable gain amplifier
+    Sampling rate{Sampling::Rate860};  //!< Data rate
+};
+
+/*!
+  @struct ScanData
+  @brief Measurement data of the scan
+ */
+struct ScanData {
+    uint16_t raw{};  //!< Raw data
+    uint8_t slot{};  //!< Index of the slot in the scan list
+    Gain gain{};     //!< Gain at the time of measurement
+    //! @brief ADC
+    inline int16_t adc() const
+    {
+        return static_cast<int16_t>(raw);
+    }
+};
+}  // namespace ads111x
+
 /*!
   @class m5::unit::UnitADS1115
   @brief ADS1115 unit
@@ -29,6 +58,8 @@ public:
     {
     }
 
+    virtual void update(const bool force = false) override;
+
     ///@name Configration
     ///@{
     /*! @brief Write the input multiplexer */
@@ -63,9 +94,120 @@ public:
     }
     ///@}
 
+    ///@name Scan measurement
+    ///@{
+    /*!
+      @brief Start round-robin measurement of the scan list
+      @details Each slot is measured in turn by single-shot conversion.
+      The result of a slot is read and the next slot is started in the same update()
+      @param slots Scan list
+      @param num Number of slots
+      @return True if successful
+      @note Results are stored in the per-slot buffer (stored_size each)
+      @note Periodic and single shot measurements are rejected until stopScanMeasurement()
+      @warning During periodic detection runs, an error is returned
+    */
+    bool startScanMeasurement(const ads111x::ScanSlot* slots, const size_t num);
+    /*!
+      @brief Stop the scan measurement
+      @details The config register is restored to the value before the scan
+      @return True if successful
+     */
+    bool stopScanMeasurement();
+    //! @brief In scan measurement?
+    inline bool inScan() const
+    {
+        return _scanning;
+    }
+    /*!
+      @brief Time the next update() accesses the bus
+      @param[out] at Time (us). The end of the conversion of the current slot in scan
+      @return True if update() has something to do, false if idle
+     */
+    virtual bool nextDue(uint32_t& at) const override;
+    //! @brief Gets the number of slots
+    inline size_t scanSlots() const
+    {
+        return _scan_slots.size();
+    }
+    //! @brief Gets the number of stored data of the slot
+    inline size_t scanAvailable(const uint8_t slot) const
+    {
+        return slot < _scan_data.size() ? _scan_data[slot]->size() : 0U;
+    }
+    //! @brief Is the buffer of the slot empty?
+    inline bool scanEmpty(const uint8_t slot) const
+    {
+        return scanAvailable(slot) == 0;
+    }
+    //! @brief Gets the oldest data of the slot
+    inline ads111x::ScanData scanOldest(const uint8_t slot) const
+    {
+        return !scanEmpty(slot) ? _scan_data[slot]->front().value() : ads111x::ScanData{};
+    }
+    //! @brief Gets the latest data of the slot
+    inline ads111x::ScanData scanLatest(const uint8_t slot) const
+    {
+        return !scanEmpty(slot) ? _scan_data[slot]->back().value() : ads111x::ScanData{};
+    }
+    //! @brief Discard the oldest data of the slot
+    inline void scanDiscard(const uint8_t slot)
+    {
+        if (!scanEmpty(slot)) {
+            _scan_data[slot]->pop_front();
+        }
+    }
+    //! @brief Discard the oldest data of the slot, returns the number of discarded data
+    inline size_t scanDiscard(const uint8_t slot, const size_t n)
+    {
+        return slot < _scan_data.size() ? _scan_data[slot]->pop_front(n) : 0U;
+    }
+    /*!
+      @brief Take out the oldest data of the slot
+      @param slot Slot
+      @param[out] out Output buffer
+      @param len Up to the number of data
+      @return Number of data taken out
+     */
+    inline size_t scanDrain(const uint8_t slot, ads111x::ScanData* out, const size_t len)
+    {
+        return slot < _scan_data.size() ? _scan_data[slot]->read(out, len) : 0U;
+    }
+    /*!
+      @brief Stored data of the slot from the oldest as contiguous spans, without copying
+      @return Number of the data
+      @warning The spans are valid until the buffer is modified
+     */
+    inline size_t scanSpans(const uint8_t slot, meter::Span<const ads111x::ScanData>& first,
+                            meter::Span<const ads111x::ScanData>& second) const
+    {
+        if (slot >= _scan_data.size()) {
+            first = second = meter::Span<const ads111x::ScanData>{};
+            return 0U;
+        }
+        return _scan_data[slot]->segments(first, second);
+    }
+    //! @brief Discard all data of all slots
+    void scanFlush();
+    ///@}
+
 protected:
     virtual bool start_periodic_measurement(const ads111x::Sampling rate, const ads111x::Mux mux,
                                             const ads111x::Gain gain, const ads111x::ComparatorQueue comp_que) override;
+    virtual bool in_scan() const override
+    {
+        return _scanning;
+    }
+    bool start_scan_slot(const uint8_t slot);
+    void update_scan();
+
+protected:
+    std::vector<ads111x::ScanSlot> _scan_slots{};
+    std::vector<std::unique_ptr<meter::RingBuffer<ads111x::ScanData>>> _scan_data{};
+    ads111x::Config _scan_restore{};
+    uint32_t _scan_started_at{}, _scan_wait{};  // us
+    uint8_t _scan_idx{};
+    bool _scanning{}, _scan_converting{};  // Scan running, conversion of _scan_idx started
 };
 
 }  // namespace unit
@@ -16,8 +16,10 @@ using namespace m5::unit::ads111x;
 using namespace m5::unit::ads111x::command;
 
 namespace {
-constexpr elapsed_time_t interval_table[] = {
-    1000UL / 8, 1000UL / 16, 1000UL / 32, 1000UL / 64, 1000UL / 128, 1000UL / 250, 1000UL / 475, 1000UL / 860,
+// Conversion period (us)
+constexpr uint32_t interval_table[] = {
+    1000000UL / 8,   1000000UL / 16,  1000000UL / 32,  1000000UL / 64,
+    1000000UL / 128, 1000000UL / 250, 1000000UL / 475, 1000000UL / 860,
 };
 
 constexpr float coefficient_table[] = {
@@ -55,10 +57,13 @@ const types::attr_t UnitADS111x::attr{attribute::AccessI2C};
 
 bool UnitADS111x::begin()
 {
+    auto scope = _bus_stats.scope(meter::Call::Begin);
+    clear_conversion_ready();
+
     auto ssize = stored_size();
     assert(ssize && "stored_size must be greater than zero");
     if (ssize != _data->capacity()) {
-        _data.reset(new m5::container::CircularBuffer<Data>(ssize));
+        _data.reset(new meter::RingBuffer<Data>(ssize));
         if (!_data) {
             M5_LIB_LOGE("Failed to allocate");
             return false;
@@ -71,12 +76,10 @@ bool UnitADS111x::begin()
         return false;
     }
 
-    if (!read_config(_ads_cfg)) {
+    if (!resyncConfig()) {
         M5_LIB_LOGE("Failed to get config");
         return false;
     }
-    apply_interval(_ads_cfg.dr());
-    apply_coefficient(_ads_cfg.pga());
 
     return _cfg.start_periodic ? startPeriodicMeasurement(_cfg.rate, _cfg.mux, _cfg.gain, _cfg.comp_que)
                                : stopPeriodicMeasurement();
@@ -86,19 +89,85 @@ void UnitADS111x::update(const bool force)
 {
     _updated = false;
     if (inPeriodic()) {
-        elapsed_time_t at{m5::utility::millis()};
-        if (force || !_latest || at >= _latest + _interval) {
+        const uint32_t at{(uint32_t)m5::utility::micros()};
+        bool due{};
+        if (inConversionReady()) {
+            // Read once per notified conversion
+            due = _rdy.consume();
+        } else {
+            due = _schedule.due(at);
+        }
+        if (force || due) {
+            auto scope = _bus_stats.scope(meter::Call::Update);
             // The rate of continuous conversion is equal to the programmeddata
             // rate. Data can be read at any time and always reflect the most
             // recent completed conversion.
             ads111x::Data d{};
-            _updated = read_adc_raw(d);
-            if (_updated) {
-                _latest = at;
-                _data->push_back(d);
+            if (read_adc_raw(d)) {
+                _schedule.advance(at);
+                _updated = push_data(d, at);
+                if (_updated) {
+                    _latest = m5::utility::millis();
+                }
             }
         }
+    } else if (_singleshot.pending()) {
+        // Complete the requested single shot and notify the callback
+        poll_singleshot((uint32_t)m5::utility::micros());
+    }
+}
+
+bool UnitADS111x::nextDue(uint32_t& at) const
+{
+    const uint32_t now{(uint32_t)m5::utility::micros()};
+    if (inPeriodic()) {
+        // The notified conversion is read in the next update()
+        at = inConversionReady() ? now : _schedule.next(now);
+        return true;
+    }
+    if (_singleshot.pending()) {
+        at = now + _singleshot.remaining(now);
+        return true;
+    }
+    return false;
+}
+
+bool UnitADS111x::push_data(ads111x::Data& d, const uint32_t at)
+{
+    if (_decimator.enabled()) {
+        meter::Aggregate a{};
+        if (!_decimator.push(d.adc(), a)) {
+            return false;
+        }
+        a.stamp(at);
+        _aggregate->push_back(a);
+        d.raw = static_cast<uint16_t>(a.meanRaw());
+    }
+    d.stamp(at);
+    _data->push_back(d);
+    return true;
+}
+
+bool UnitADS111x::writeDecimation(const meter::Decimation type, const uint16_t ratio)
+{
+    if (!_decimator.configure(type, ratio)) {
+        M5_LIB_LOGE("Illegal decimation %u:%u", m5::stl::to_underlying(type), ratio);
+        return false;
+    }
+    if (type == meter::Decimation::None) {
+        _aggregate.reset();
+        return true;
+    }
+    auto ssize = stored_size();
+    if (!_aggregate || _aggregate->capacity() != ssize) {
+        _aggregate.reset(new meter::RingBuffer<meter::Aggregate>(ssize));
+        if (!_aggregate) {
+            M5_LIB_LOGE("Failed to allocate");
+            _decimator.configure(meter::Decimation::None, 1);
+            return false;
+        }
     }
+    return true;
 }
 
 Gain UnitADS111x::gain() const
@@ -109,37 +178,56 @@ Gain UnitADS111x::gain() const
 bool UnitADS111x::writeSamplingRate(ads111x::Sampling rate)
 {
     Config c{};
-    if (read_config(c)) {
-        c.dr(rate);
-        if (write_config(c)) {
-            apply_interval(_ads_cfg.dr());
-            return true;
-        }
+    return current_config(c) && commit_config(c.dr(rate));
+}
+
+bool UnitADS111x::writeConfigRegister(const ads111x::Config& c)
+{
+    if (inPeriodic() && c.mode()) {
+        M5_LIB_LOGW("Periodic measurements are running");
+        return false;
     }
-    return false;
+    if (_rdy_enabled && (c.comp_que() == ComparatorQueue::Disable || c.comp_lat())) {
+        M5_LIB_LOGW("The comparator is used for the conversion-ready mode");
+        return false;
+    }
+    return commit_config(c);
 }
 
 bool UnitADS111x::start_periodic_measurement()
+{
+    Config c{};
+    return current_config(c) && start_periodic_measurement(c);
+}
+
+bool UnitADS111x::start_periodic_measurement(const ads111x::Config& c)
 {
     if (inPeriodic()) {
         return false;
     }
+    if (in_scan()) {
+        M5_LIB_LOGW("Scan measurements are running");
+        return false;
+    }
 
-    Config c{};
-    _updated = false;
-    if (read_config(c)) {
-        c.mode(false);
-        _periodic = write_config(c);
-        _latest   = 0;
-        return _periodic;
+    if (_singleshot.pending()) {
+        // The conversion in progress is overridden by the continuous mode
+        _singleshot.complete(false);
     }
-    return false;
+
+    Config cc{c};
+    _updated  = false;
+    _periodic = commit_config(cc.os(false).mode(false));
+    _latest   = 0;
+    _schedule.reset();
+    _decimator.reset();
+    return _periodic;
 }
 
 bool UnitADS111x::stop_periodic_measurement()
 {
     Config c{};
-    if (read_config(c)) {
+    if (current_config(c)) {
         c.mode(true);
         if (write_config(c)) {
             _periodic = false;
@@ -151,22 +239,58 @@ bool UnitADS111x::stop_periodic_measurement()
 
 bool UnitADS111x::measureSingleshot(ads111x::Data& d, const uint32_t timeoutMillis)
 {
-    if (inPeriodic()) {
-        M5_LIB_LOGW("Periodic measurements are running");
-        return false;
+    auto scope = _bus_stats.scope(meter::Call::Singleshot);
+    return request_singleshot((uint32_t)m5::utility::micros(), timeoutMillis) &&
+           meter::pollUntilDone([this, &d](const uint32_t now, const uint32_t, uint32_t& wait) {
+               return singleshot_step(now, wait, d);
+           });
+}
+
+bool UnitADS111x::requestSingleshot(const uint32_t timeoutMillis)
+{
+    return request_singleshot((uint32_t)m5::utility::micros(), timeoutMillis);
+}
+
+bool UnitADS111x::trySingleshotResult(ads111x::Data& d)
+{
+    poll_singleshot((uint32_t)m5::utility::micros());
+    if (_singleshot.state() == meter::SingleshotState::Completed) {
+        d = _singleshot_data;
+        _singleshot.clear();
+        return true;
     }
+    return false;
+}
 
-    if (start_single_measurement()) {
-        auto timeout_at = m5::utility::millis() + timeoutMillis;
-        bool done{};
-        do {
-            done = !in_conversion();
-        } while (!done && m5::utility::millis() <= timeout_at);
-        if (done) {
-            return read_adc_raw(d);
+void UnitADS111x::poll_singleshot(const uint32_t at, const bool notify)
+{
+    if (!_singleshot.pending()) {
+        return;
+    }
+    if (_singleshot.due(at)) {
+        Config c{};
+        if (!read_config(c)) {
+            _singleshot.complete(false);
+        } else if (c.os()) {
+            // OS reads 1 when the device is not performing a conversion
+            _singleshot_data = Data{};
+            const bool ok    = read_adc_raw(_singleshot_data);
+            if (ok) {
+                _singleshot_data.stamp(at);
+            }
+            _singleshot.complete(ok);
+        } else {
+            _bus_stats.poll();
+            _singleshot.retry(at);
         }
     }
-    return false;
+    if (_singleshot.pending() && _singleshot.expired(at)) {
+        M5_LIB_LOGE("Single shot timed out");
+        _singleshot.complete(false);
+    }
+    if (!_singleshot.pending() && notify && _singleshot_callback) {
+        _singleshot_callback(_singleshot.state() == meter::SingleshotState::Completed, _singleshot_data);
+    }
 }
 
 bool UnitADS111x::start_single_measurement()
@@ -175,9 +299,13 @@ bool UnitADS111x::start_single_measurement()
         M5_LIB_LOGW("Periodic measurements are running");
         return false;
     }
+    if (in_scan()) {
+        M5_LIB_LOGW("Scan measurements are running");
+        return false;
+    }
 
     Config c{};
-    if (read_config(c)) {
+    if (current_config(c)) {
         // This bit determines the operational status of the device. OS can
         // only be written when in power-down state and has no effect when a
         // conversion is ongoing.
@@ -193,42 +321,126 @@ bool UnitADS111x::in_conversion()
     return read_config(c) && !c.os();
 }
 
+bool UnitADS111x::request_singleshot(const uint32_t now, const uint32_t timeoutMillis)
+{
+    if (inPeriodic()) {
+        M5_LIB_LOGW("Periodic measurements are running");
+        return false;
+    }
+    if (_singleshot.pending()) {
+        M5_LIB_LOGW("Single shot is requested");
+        return false;
+    }
+    _singleshot.clear();
+    if (!start_single_measurement()) {
+        return false;
+    }
+    _singleshot.start(now, _schedule.interval(), meter::millisToMicros(timeoutMillis));
+    return true;
+}
+
+meter::Progress UnitADS111x::singleshot_step(const uint32_t now, uint32_t& wait, ads111x::Data& d)
+{
+    // Sleep until the expected conversion time instead of reading the config register
+    poll_singleshot(now, false);
+    if (_singleshot.pending()) {
+        wait = _singleshot.remaining(now);
+        return meter::Progress::Pending;
+    }
+    const bool ok = _singleshot.state() == meter::SingleshotState::Completed;
+    if (ok) {
+        d = _singleshot_data;
+    }
+    _singleshot.clear();
+    return ok ? meter::Progress::Completed : meter::Progress::Failed;
+}
+
 bool UnitADS111x::read_adc_raw(ads111x::Data& d)
 {
-    if (readRegister16BE(CONVERSION_REG, d.raw, 0)) {
+    if (read_register16(CONVERSION_REG, d.raw)) {
         return true;
     }
     return false;
 }
 
 bool UnitADS111x::generalReset()
+{
+    start_general_reset();
+    return meter::pollUntilDone(
+        [this](const uint32_t, const uint32_t elapsed, uint32_t& wait) { return general_reset_step(elapsed, wait); });
+}
+
+void UnitADS111x::start_general_reset()
 {
     uint8_t cmd{0x06};  // reset command
     generalCall(&cmd, 1);
+    _ads_cfg_dirty = true;
+    clear_conversion_ready();  // Thresholds and COMP_QUE are the default
+}
 
-    auto timeout_at = m5::utility::millis() + 10;
-    bool done{};
+meter::Progress UnitADS111x::general_reset_step(const uint32_t elapsed, uint32_t& wait)
+{
+    _bus_stats.poll();
+    // power-down mode?
     Config c{};
-    do {
-        // power-down mode?
-        if (read_config(_ads_cfg) && _ads_cfg.mode()) {
-            done = true;
-            break;
-        }
-        m5::utility::delay(1);
-    } while (!done && m5::utility::millis() <= timeout_at);
+    if (read_config(c) && c.mode()) {
+        load_config(c);
+        return meter::Progress::Completed;
+    }
+    if (elapsed > 10 * 1000U) {
+        return meter::Progress::Failed;
+    }
+    wait = 1000;
+    return meter::Progress::Pending;
+}
 
-    if (done) {
-        apply_interval(_ads_cfg.dr());
-        apply_coefficient(_ads_cfg.pga());
+#if M5_UNIT_METER_COROUTINE
+meter::Task<bool> UnitADS111x::measureSingleshotAsync(ads111x::Data& d, const uint32_t timeoutMillis)
+{
+    if (!request_singleshot(co_await meter::currentTime(), timeoutMillis)) {
+        co_return false;
     }
-    return done;
+    co_return co_await meter::pollUntilDoneAsync(
+        [this, &d](const uint32_t now, const uint32_t, uint32_t& wait) { return singleshot_step(now, wait, d); });
+}
+
+meter::Task<bool> UnitADS111x::generalResetAsync()
+{
+    start_general_reset();
+    co_return co_await meter::pollUntilDoneAsync(
+        [this](const uint32_t, const uint32_t elapsed, uint32_t& wait) { return general_reset_step(elapsed, wait); });
+}
+#endif
+
+bool UnitADS111x::resyncConfig()
+{
+    Config c{};
+    if (read_config(c)) {
+        load_config(c);
+        return true;
+    }
+    return false;
+}
+
+bool UnitADS111x::verifyConfig(bool& match)
+{
+    match = false;
+    Config c{};
+    if (read_config(c)) {
+        c.os(false);
+        match = !_ads_cfg_dirty && (c.value == _ads_cfg.value);
+        if (!match) {
+            load_config(c);
+        }
+        return true;
+    }
+    return false;
 }
 
 bool UnitADS111x::readThreshold(int16_t& high, int16_t& low)
 {
     uint16_t hh{}, ll{};
-    if (readRegister16BE(HIGH_THRESHOLD_REG, hh, 0) && readRegister16BE(LOW_THRESHOLD_REG, ll, 0)) {
+    if (read_register16(HIGH_THRESHOLD_REG, hh) && read_register16(LOW_THRESHOLD_REG, ll)) {
         high = hh;
         low  = ll;
         return true;
@@ -242,66 +454,158 @@ bool UnitADS111x::writeThreshold(const int16_t high, const int16_t low)
         M5_LIB_LOGW("high must be greater than low");
         return false;
     }
-    return writeRegister16BE(HIGH_THRESHOLD_REG, (uint16_t)high) && writeRegister16BE(LOW_THRESHOLD_REG, (uint16_t)low);
+    if (_rdy_enabled) {
+        M5_LIB_LOGW("The thresholds are used for the conversion-ready mode");
+        return false;
+    }
+    return write_register16(HIGH_THRESHOLD_REG, (uint16_t)high) && write_register16(LOW_THRESHOLD_REG, (uint16_t)low);
+}
+
+bool UnitADS111x::enableConversionReady(const bool enable, const bool activeHigh)
+{
+    Config c{};
+    if (!current_config(c)) {
+        return false;
+    }
+
+    if (enable) {
+        // Save the comparator settings to restore on disable (kept if already enabled)
+        uint16_t high{}, low{};
+        if (!_rdy_enabled) {
+            if (!read_register16(HIGH_THRESHOLD_REG, high) || !read_register16(LOW_THRESHOLD_REG, low)) {
+                return false;
+            }
+            _rdy_saved_high = high;
+            _rdy_saved_low  = low;
+            _rdy_saved      = c;
+        }
+        // Hi_thresh MSB = 1 and Lo_thresh MSB = 0 for RDY, COMP_QUE other than Disable is required
+        c.comp_que(ComparatorQueue::One).comp_pol(activeHigh).comp_lat(false);
+        if (write_register16(HIGH_THRESHOLD_REG, 0x8000) && write_register16(LOW_THRESHOLD_REG, 0x0000) &&
+            write_config(c)) {
+            _rdy_enabled = true;
+            _rdy.reset();
+            return true;
+        }
+        return false;
+    }
+
+    // Restore the settings before enabling, or the default values if not enabled
+    const uint16_t high = _rdy_enabled ? _rdy_saved_high : 0x7FFF;
+    const uint16_t low  = _rdy_enabled ? _rdy_saved_low : 0x8000;
+    if (_rdy_enabled) {
+        c.comp_que(_rdy_saved.comp_que()).comp_pol(_rdy_saved.comp_pol()).comp_lat(_rdy_saved.comp_lat());
+    } else {
+        c.comp_que(ComparatorQueue::Disable);
+    }
+    if (write_register16(HIGH_THRESHOLD_REG, high) && write_register16(LOW_THRESHOLD_REG, low) && write_config(c)) {
+        clear_conversion_ready();
+        return true;
+    }
+    return false;
 }
 
 //
 bool UnitADS111x::read_config(ads111x::Config& c)
 {
-    return readRegister16BE(CONFIG_REG, c.value, 0);
+    return read_register16(CONFIG_REG, c.value);
 }
 
 bool UnitADS111x::write_config(const ads111x::Config& c)
 {
-    if (writeRegister16BE(CONFIG_REG, c.value)) {
+    if (write_register16(CONFIG_REG, c.value)) {
         _ads_cfg = c;
+        // OS is a trigger, not a state. Do not carry it over to the following writes
+        _ads_cfg.os(false);
+        _ads_cfg_dirty = false;
         return true;
     }
+    // Unknown whether the device has accepted it or not
+    _ads_cfg_dirty = true;
     return false;
 }
 
+bool UnitADS111x::current_config(ads111x::Config& c)
+{
+    if (_ads_cfg_dirty && !resyncConfig()) {
+        return false;
+    }
+    c = _ads_cfg;
+    return true;
+}
+
+bool UnitADS111x::commit_config(const ads111x::Config& c)
+{
+    if (write_config(c)) {
+        apply_interval(_ads_cfg.dr());
+        apply_coefficient(_ads_cfg.pga());
+        _decimator.reset();  // Do not mix samples of different settings
+        return true;
+    }
+    return false;
+}
+
+void UnitADS111x::load_config(const ads111x::Config& c)
+{
+    _ads_cfg = c;
+    _ads_cfg.os(false);
+    _ads_cfg_dirty = false;
+    apply_interval(_ads_cfg.dr());
+    apply_coefficient(_ads_cfg.pga());
+}
+
 void UnitADS111x::apply_interval(const ads111x::Sampling rate)
 {
     auto idx = m5::stl::to_underlying(rate);
     assert(idx < m5::stl::size(interval_table) && "Illegal value");
-    _interval = interval_table[idx];
-    M5_LIB_LOGV("interval %u", _interval);
+    _schedule.interval(interval_table[idx]);
+    _interval = (interval_table[idx] + 999) / 1000;
+    M5_LIB_LOGV("interval %u us", interval_table[idx]);
 }
 
-void UnitADS111x::apply_coefficient(const ads111x::Gain gain)
+size_t UnitADS111x::drainADC(int16_t* out, const size_t len)
+{
+    return _data->consume(len, [out](const Data* p, const size_t n, const size_t offset) {
+        convertADC(out + offset, p, n);
+    });
+}
+
+void UnitADS111x::convertADC(int16_t* out, const ads111x::Data* in, const size_t len)
+{
+    for (size_t i = 0; i < len; ++i) {
+        out[i] = in[i].adc();
+    }
+}
+
+float UnitADS111x::coefficientOf(const ads111x::Gain gain)
 {
     auto idx = m5::stl::to_underlying(gain);
     assert(idx < m5::stl::size(coefficient_table) && "Illegal value");
-    _coefficient = coefficient_table[idx];
+    return coefficient_table[idx];
+}
+
+void UnitADS111x::apply_coefficient(const ads111x::Gain gain)
+{
+    _coefficient = coefficientOf(gain);
 }
 
 bool UnitADS111x::write_multiplexer(const ads111x::Mux mux)
 {
     Config c{};
-    if (read_config(c)) {
-        c.mux(mux);
-        return write_config(c);
-    }
-    return false;
+    // Input changes, and the decimation block must not mix the inputs
+    return current_config(c) && commit_config(c.mux(mux));
 }
 
 bool UnitADS111x::write_gain(const ads111x::Gain gain)
 {
     Config c{};
-    if (read_config(c)) {
-        c.pga(gain);
-        if (write_config(c)) {
-            apply_coefficient(_ads_cfg.pga());
-            return true;
-        }
-    }
-    return false;
+    return current_config(c) && commit_config(c.pga(gain));
 }
 
 bool UnitADS111x::write_comparator_mode(const bool b)
 {
     Config c{};
-    if (read_config(c)) {
+    if (current_config(c)) {
         c.comp_mode(b);
         return write_config(c);
     }
@@ -311,7 +615,7 @@ bool UnitADS111x::write_comparator_mode(const bool b)
 bool UnitADS111x::write_comparator_polarity(const bool b)
 {
     Config c{};
-    if (read_config(c)) {
+    if (current_config(c)) {
         c.comp_pol(b);
         return write_config(c);
     }
@@ -320,8 +624,12 @@ bool UnitADS111x::write_comparator_polarity(const bool b)
 
 bool UnitADS111x::write_latching_comparator(const bool b)
 {
+    if (_rdy_enabled) {
+        M5_LIB_LOGW("The latching comparator is used for the conversion-ready mode");
+        return false;
+    }
     Config c{};
-    if (read_config(c)) {
+    if (current_config(c)) {
         c.comp_lat(b);
         return write_config(c);
     }
@@ -330,12 +638,33 @@ bool UnitADS111x::write_latching_comparator(const bool b)
 
 bool UnitADS111x::write_comparator_queue(const ads111x::ComparatorQueue q)
 {
+    if (_rdy_enabled) {
+        M5_LIB_LOGW("The comparator queue is used for the conversion-ready mode");
+        return false;
+    }
     Config c{};
-    if (read_config(c)) {
+    if (current_config(c)) {
         c.comp_que(q);
         return write_config(c);
     }
     return false;
 }
+
+bool UnitADS111x::read_register16(const uint8_t reg, uint16_t& v)
+{
+    const uint32_t at{_bus_stats.mark()};
+    const bool ok{readRegister16BE(reg, v, 0)};
+    _bus_stats.read(reg, 2, ok, at);
+    return ok;
+}
+
+bool UnitADS111x::write_register16(const uint8_t reg, const uint16_t v)
+{
+    const uint32_t at{_bus_stats.mark()};
+    const bool ok{writeRegister16BE(reg, v)};
+    _bus_stats.write(reg, 2, ok, at);
+    return ok;
+}
+
 }  // namespace unit
 }  // namespace m5
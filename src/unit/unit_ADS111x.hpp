@@ -10,10 +10,16 @@
 #ifndef M5_UNIT_METER_UNIT_ADS111X_HPP
 #define M5_UNIT_METER_UNIT_ADS111X_HPP
 
+#include "meter_schedule.hpp"
+#include "meter_timestamp.hpp"
+#include "meter_decimator.hpp"
+#include "meter_stats.hpp"
+#include "meter_ring_buffer.hpp"
+#include "meter_coroutine.hpp"
 #include <M5UnitComponent.hpp>
 #include <m5_utility/stl/extension.hpp>
-#include <m5_utility/container/circular_buffer.hpp>
 #include <limits>
+#include <functional>
 
 namespace m5 {
 namespace unit {
@@ -82,7 +88,16 @@ enum class ComparatorQueue : uint8_t {
               //!< default
 };
 
-///@cond
+/*!
+  @struct Config
+  @brief Accessor for the config register
+  @details Setters can be chained to compose every field in memory before a single write
+  @code
+  auto c = unit.configRegister();
+  c.dr(Sampling::Rate475).mux(Mux::GND_0).pga(Gain::PGA_1024);
+  unit.writeConfigRegister(c);  // One transaction
+  @endcode
+ */
 struct Config {
     inline bool os() const
     {
@@ -120,51 +135,59 @@ struct Config {
     {
         return static_cast<ComparatorQueue>(value & 0x03);
     }
-    inline void os(const bool b)
+    inline Config& os(const bool b)
     {
         value = (value & ~(1U << 15)) | ((b ? 1U : 0) << 15);
+        return *this;
     }
-    inline void mux(const Mux m)
+    inline Config& mux(const Mux m)
     {
         value = (value & ~(0x07 << 12)) | ((m5::stl::to_underlying(m) & 0x07) << 12);
+        return *this;
     }
-    inline void pga(const Gain g)
+    inline Config& pga(const Gain g)
     {
         value = (value & ~(0x07 << 9)) | ((m5::stl::to_underlying(g) & 0x07) << 9);
+        return *this;
     }
-    inline void mode(const bool b)
+    inline Config& mode(const bool b)
     {
         value = (value & ~(1U << 8)) | ((b ? 1U : 0) << 8);
+        return *this;
     }
-    inline void dr(const Sampling r)
+    inline Config& dr(const Sampling r)
     {
         value = (value & ~(0x07 << 5)) | ((m5::stl::to_underlying(r) & 0x07) << 5);
+        return *this;
     }
-    inline void comp_mode(const bool b)
+    inline Config& comp_mode(const bool b)
     {
         value = (value & ~(1U << 4)) | ((b ? 1U : 0) << 4);
+        return *this;
     }
-    inline void comp_pol(const bool b)
+    inline Config& comp_pol(const bool b)
     {
         value = (value & ~(1U << 3)) | ((b ? 1U : 0) << 3);
+        return *this;
     }
-    inline void comp_lat(const bool b)
+    inline Config& comp_lat(const bool b)
     {
         value = (value & ~(1U << 2)) | ((b ? 1U : 0) << 2);
+        return *this;
     }
-    inline void comp_que(const ComparatorQueue c)
+    inline Config& comp_que(const ComparatorQueue c)
     {
         value = (value & ~0x03U) | (m5::stl::to_underlying(c) & 0x03);
+        return *this;
     }
     uint16_t value{};
 };
-///@endcond
 
 /*!
   @struct Data
   @brief Measurement data group
  */
-struct Data {
+struct Data : meter::SampleTimestamp {
     uint16_t raw{};
     //! @brief ADC
     inline int16_t adc() const
@@ -201,7 +224,7 @@ public:
     };
 
     explicit UnitADS111x(const uint8_t addr = DEFAULT_ADDRESS)
-        : Component(addr), _data{new m5::container::CircularBuffer<ads111x::Data>(1)}
+        : Component(addr), _data{new meter::RingBuffer<ads111x::Data>(1)}
     {
         auto ccfg  = component_config();
         ccfg.clock = 400 * 1000U;
@@ -238,6 +261,28 @@ public:
     {
         return _coefficient;
     }
+    //! @brief Coefficient value of the gain (mV per LSB)
+    static float coefficientOf(const ads111x::Gain gain);
+    //! @brief Periodic interval in microseconds
+    inline uint32_t intervalMicros() const
+    {
+        return _schedule.interval();
+    }
+    /*!
+      @brief Effective sample rate (Hz) of the periodic measurement
+      @return Measured rate since the periodic measurement started, or zero if not yet known
+    */
+    inline float effectiveSamplingRate() const
+    {
+        return _schedule.effectiveRate();
+    }
+    /*!
+      @brief Time the next update() accesses the bus
+      @param[out] at Time (us). Now if it waits for the conversion-ready notification
+      @return True if update() has something to do, false if idle
+      @note For the bus scheduler to order the units by the deadline
+    */
+    virtual bool nextDue(uint32_t& at) const;
     ///@}
 
     ///@name Measurement data by periodic
@@ -249,6 +294,137 @@ public:
     }
     ///@}
 
+    ///@name Bulk access to the measurement data
+    ///@{
+    /*!
+      @brief Take out the oldest data
+      @param[out] out Output buffer
+      @param len Up to the number of data
+      @return Number of data taken out
+     */
+    inline size_t drain(ads111x::Data* out, const size_t len)
+    {
+        return _data->read(out, len);
+    }
+    /*!
+      @brief Stored data from the oldest as contiguous spans, without copying
+      @param[out] first Oldest part
+      @param[out] second Wrapped part, empty if not wrapped
+      @return Number of the data
+      @warning The spans are valid until the buffer is modified (update(), discard(), flush() etc.)
+     */
+    inline size_t spans(meter::Span<const ads111x::Data>& first, meter::Span<const ads111x::Data>& second) const
+    {
+        return _data->segments(first, second);
+    }
+    using PeriodicMeasurementAdapter<UnitADS111x, ads111x::Data>::discard;
+    /*!
+      @brief Discard the oldest data
+      @param n Up to the number of data
+      @return Number of discarded data
+     */
+    inline size_t discard(const size_t n)
+    {
+        return _data->pop_front(n);
+    }
+    //! @brief Take out the oldest ADC values
+    size_t drainADC(int16_t* out, const size_t len);
+    //! @brief Convert the data to the ADC values
+    static void convertADC(int16_t* out, const ads111x::Data* in, const size_t len);
+    ///@}
+
+    ///@name Decimation
+    ///@{
+    /*!
+      @brief Set the decimation stage between the ADC read and the buffer
+      @details Each N samples are aggregated into one record (mean, min, max and count).
+      The measurement data buffer then holds the rounded mean of each record, and the aggregated records are stored in
+      their own buffer
+      @param type Filter (None to disable)
+      @param ratio Decimation ratio N (2 or more, up to Decimator::MAX_CIC2_RATIO for CIC2)
+      @return True if successful
+      @note The filter state is cleared at the start of the periodic measurement and when the config changes
+     */
+    bool writeDecimation(const meter::Decimation type, const uint16_t ratio);
+    //! @brief Decimation filter
+    inline meter::Decimation decimation() const
+    {
+        return _decimator.type();
+    }
+    //! @brief Decimation ratio
+    inline uint16_t decimationRatio() const
+    {
+        return _decimator.ratio();
+    }
+    //! @brief Gets the number of stored aggregated records
+    inline size_t aggregateAvailable() const
+    {
+        return _aggregate ? _aggregate->size() : 0;
+    }
+    //! @brief Is the aggregated record buffer empty?
+    inline bool aggregateEmpty() const
+    {
+        return !aggregateAvailable();
+    }
+    //! @brief Oldest aggregated record
+    inline meter::Aggregate oldestAggregate() const
+    {
+        return !aggregateEmpty() ? _aggregate->front().value() : meter::Aggregate{};
+    }
+    //! @brief Latest aggregated record
+    inline meter::Aggregate latestAggregate() const
+    {
+        return !aggregateEmpty() ? _aggregate->back().value() : meter::Aggregate{};
+    }
+    //! @brief Discard the oldest aggregated record
+    inline void discardAggregate()
+    {
+        if (!aggregateEmpty()) {
+            _aggregate->pop_front();
+        }
+    }
+    /*!
+      @brief Discard the oldest aggregated records
+      @param n Up to the number of records
+      @return Number of discarded records
+     */
+    inline size_t discardAggregate(const size_t n)
+    {
+        return _aggregate ? _aggregate->pop_front(n) : 0U;
+    }
+    /*!
+      @brief Take out the oldest aggregated records
+      @param[out] out Output buffer
+      @param len Up to the number of records
+      @return Number of records taken out
+     */
+    inline size_t drainAggregate(meter::Aggregate* out, const size_t len)
+    {
+        return _aggregate ? _aggregate->read(out, len) : 0U;
+    }
+    /*!
+      @brief Stored aggregated records from the oldest as contiguous spans, without copying
+      @return Number of the records
+      @warning The spans are valid until the buffer is modified (update(), discardAggregate(), flushAggregate() etc.)
+     */
+    inline size_t aggregateSpans(meter::Span<const meter::Aggregate>& first,
+                                 meter::Span<const meter::Aggregate>& second) const
+    {
+        if (!_aggregate) {
+            first = second = meter::Span<const meter::Aggregate>{};
+            return 0U;
+        }
+        return _aggregate->segments(first, second);
+    }
+    //! @brief Discard all aggregated records
+    inline void flushAggregate()
+    {
+        if (_aggregate) {
+            _aggregate->clear();
+        }
+    }
+    ///@}
+
     ///@name Periodic measurement
     ///@{
     /*!
@@ -345,10 +521,30 @@ public:
     virtual bool writeComparatorMode(const bool b) = 0;
     //! @brief Write the comparator polarity
     virtual bool writeComparatorPolarity(const bool b) = 0;
-    //! @brief Write the latching comparator
+    /*!
+      @brief Write the latching comparator
+      @warning Rejected in the conversion-ready mode
+     */
     virtual bool writeLatchingComparator(const bool b) = 0;
-    //! @brief Write the comparator queue
+    /*!
+      @brief Write the comparator queue
+      @warning Rejected in the conversion-ready mode
+     */
     virtual bool writeComparatorQueue(const ads111x::ComparatorQueue c) = 0;
+    //! @brief Gets the value of the config register (shadow)
+    inline ads111x::Config configRegister() const
+    {
+        return _ads_cfg;
+    }
+    /*!
+      @brief Write the config register at once
+      @details Every field is written in one transaction, and the interval and coefficient are updated once
+      @param c Value to be written
+      @return True if successful
+      @warning Fields not supported by the chip are written as they are
+      @warning During periodic detection runs, an error is returned if it changes the operating mode
+    */
+    bool writeConfigRegister(const ads111x::Config& c);
     ///@}
 
     ///@name Single shot measurement
@@ -357,7 +553,7 @@ public:
       @brief Measurement single shot
       @details Measuring in the current settings
       @param[out] data Measuerd data
-      @param timeoutMillis Timeout for measure
+      @param timeoutMillis Timeout for measure (up to meter::MAX_SPAN_MILLIS, longer is clamped)
       @return True if successful
       @warning During periodic detection runs, an error is returned
       @warning Until it can be measured, it will be blocked until the timeout
@@ -366,6 +562,64 @@ public:
     bool measureSingleshot(ads111x::Data& d, const uint32_t timeoutMillis = 1000U);
     ///@}
 
+    ///@name Asynchronous single shot measurement
+    ///@{
+    /*!
+      @brief Callback on completion of the requested single shot
+      @param ok True if successful, false if failed or timed out
+      @param d Measured data (valid if ok)
+     */
+    using singleshot_callback_t = std::function<void(const bool ok, const ads111x::Data& d)>;
+    /*!
+      @brief Request the single shot measurement without waiting
+      @details Start the conversion in the current settings and return.
+      The result is obtained by trySingleshotResult(), or notified by the callback from update()
+      @param timeoutMillis Timeout for measure (up to meter::MAX_SPAN_MILLIS, longer is clamped)
+      @return True if successful
+      @warning During periodic detection runs or while the previous request is converting, an error is returned
+     */
+    bool requestSingleshot(const uint32_t timeoutMillis = 1000U);
+    /*!
+      @brief Try to get the result of the requested single shot
+      @details The bus is not accessed until the expected conversion time has passed
+      @param[out] d Measured data
+      @return True if the result is obtained
+      @note If false, singleshotState() tells whether it is still converting or failed
+     */
+    bool trySingleshotResult(ads111x::Data& d);
+    //! @brief State of the requested single shot
+    inline meter::SingleshotState singleshotState() const
+    {
+        return _singleshot.state();
+    }
+    //! @brief Set the callback on completion (nullptr to clear)
+    inline void setSingleshotCallback(singleshot_callback_t cb)
+    {
+        _singleshot_callback = cb;
+    }
+    ///@}
+
+#if M5_UNIT_METER_COROUTINE
+    ///@name Coroutine (C++20)
+    ///@{
+    /*!
+      @brief Awaitable single shot measurement
+      @details Same as measureSingleshot(), but the task sleeps until the expected conversion time instead of blocking
+      @param[out] d Measured data
+      @param timeoutMillis Timeout for measure (up to meter::MAX_SPAN_MILLIS, longer is clamped)
+      @return Task resulting true if successful
+      @warning The data must outlive the task
+     */
+    meter::Task<bool> measureSingleshotAsync(ads111x::Data& d, const uint32_t timeoutMillis = 1000U);
+    /*!
+      @brief Awaitable general reset
+      @return Task resulting true if successful
+      @sa generalReset
+     */
+    meter::Task<bool> generalResetAsync();
+    ///@}
+#endif
+
     ///@name Threshold
     ///@{
     /*!
@@ -381,10 +635,51 @@ public:
       @param low lower threshold value
       @return True if successful
       @warning The high value must always be greater than the low value
+      @warning Rejected in the conversion-ready mode, disable it first
     */
     bool writeThreshold(const int16_t high, const int16_t low);
     ///@}
 
+    ///@name Conversion ready
+    ///@{
+    /*!
+      @brief Enable or disable the conversion-ready mode
+      @details Set the MSB of Hi_thresh to 1 and the MSB of Lo_thresh to 0 so that
+      the ALERT/RDY pin signals the end of each conversion.
+      While enabled, periodic update() reads the conversion register only after onConversionReady() has been called
+      @param enable Enable if true
+      @param activeHigh RDY pin is active high if true
+      @return True if successful
+      @note If disabled, the thresholds and the comparator settings (queue, polarity and latching) before enabling
+      are restored. If not enabled, the thresholds and the comparator queue are set to the default
+      @note Reset by generalReset() and begin()
+      @warning Not supported on ADS1113 (It does not have the ALERT/RDY pin)
+     */
+    virtual bool enableConversionReady(const bool enable, const bool activeHigh = false);
+    //! @brief In the conversion-ready mode?
+    inline bool inConversionReady() const
+    {
+        return _rdy_enabled;
+    }
+    /*!
+      @brief Notify the edge of the ALERT/RDY pin
+      @details Only counts the edge, safe to call from ISR. The conversion is read in the next update()
+      @note It can also be called by a simulated pin on the host
+     */
+    inline void onConversionReady()
+    {
+        _rdy.notify();
+    }
+    /*!
+      @brief Gets the number of conversions that were notified but not read
+      @details Counted when update() could not keep up with the notification
+    */
+    inline uint32_t conversionReadyOverruns() const
+    {
+        return _rdy.overruns();
+    }
+    ///@}
+
     /*!
       @brief General reset
       @details Reset using I2C general call
@@ -392,18 +687,84 @@ public:
      */
     bool generalReset();
 
+    ///@name Shadow register
+    ///@{
+    /*!
+      @brief Is the shadow of the config register not trusted?
+      @details Setters compose the new value from the shadow and write it in one transaction.
+      If the shadow is dirty, the config register is read back once before composing
+      @note Dirty at construction and after a failed write (the device state is unknown)
+     */
+    inline bool isConfigDirty() const
+    {
+        return _ads_cfg_dirty;
+    }
+    /*!
+      @brief Read the config register and refresh the shadow
+      @return True if successful
+      @note Interval and coefficient are also updated
+     */
+    bool resyncConfig();
+    /*!
+      @brief Verify that the config register matches the shadow
+      @param[out] match True if matched (OS bit is ignored)
+      @return True if successful
+      @note If it does not match, the shadow is refreshed by the value read
+     */
+    bool verifyConfig(bool& match);
+    ///@}
+
+    ///@name Bus statistics
+    ///@{
+    /*!
+      @brief Register access counters and call latencies
+      @note Counted only if M5_UNIT_METER_BUS_STATS is non-zero, otherwise empty
+     */
+    inline const meter::UnitBusStats& busStats() const
+    {
+        return _bus_stats;
+    }
+    //! @brief Clear the bus statistics
+    inline void resetBusStats()
+    {
+        _bus_stats.reset();
+    }
+    ///@}
+
 protected:
     bool start_periodic_measurement();
+    bool start_periodic_measurement(const ads111x::Config& c);
     virtual bool start_periodic_measurement(const ads111x::Sampling rate, const ads111x::Mux mux,
                                             const ads111x::Gain gain, const ads111x::ComparatorQueue comp_que) = 0;
     bool stop_periodic_measurement();
 
     bool read_adc_raw(ads111x::Data& d);
+    bool push_data(ads111x::Data& d, const uint32_t at);
     bool start_single_measurement();
+    // Is the round-robin scan (UnitADS1115) running? It owns the config register while running
+    virtual bool in_scan() const
+    {
+        return false;
+    }
     bool in_conversion();
+    // The device has been reset or re-begun, not in the conversion-ready mode anymore
+    inline void clear_conversion_ready()
+    {
+        _rdy_enabled = false;
+        _rdy.reset();
+    }
+    void poll_singleshot(const uint32_t at, const bool notify = true);
+    // Shared by the blocking functions and the *Async() counterparts (now in us)
+    bool request_singleshot(const uint32_t now, const uint32_t timeoutMillis);
+    meter::Progress singleshot_step(const uint32_t now, uint32_t& wait, ads111x::Data& d);
+    void start_general_reset();
+    meter::Progress general_reset_step(const uint32_t elapsed, uint32_t& wait);
 
     bool read_config(ads111x::Config& c);
     bool write_config(const ads111x::Config& c);
+    bool current_config(ads111x::Config& c);
+    bool commit_config(const ads111x::Config& c);
+    void load_config(const ads111x::Config& c);
     void apply_interval(const ads111x::Sampling rate);
     virtual void apply_coefficient(const ads111x::Gain gain);
 
@@ -414,13 +775,35 @@ protected:
     bool write_latching_comparator(const bool b);
     bool write_comparator_queue(const ads111x::ComparatorQueue c);
 
+    bool read_register16(const uint8_t reg, uint16_t& v);
+    bool write_register16(const uint8_t reg, const uint16_t v);
+
     M5_UNIT_COMPONENT_PERIODIC_MEASUREMENT_ADAPTER_HPP_BUILDER(UnitADS111x, ads111x::Data);
 
 protected:
-    std::unique_ptr<m5::container::CircularBuffer<ads111x::Data>> _data{};
+    std::unique_ptr<meter::RingBuffer<ads111x::Data>> _data{};
     float _coefficient{};
-    ads111x::Config _ads_cfg{};
+    ads111x::Config _ads_cfg{};  // Shadow of the config register (OS bit is always cleared)
+    bool _ads_cfg_dirty{true};
     config_t _cfg{};
+    meter::Schedule _schedule{};
+
+    // Decimation
+    meter::Decimator _decimator{};
+    std::unique_ptr<meter::RingBuffer<meter::Aggregate>> _aggregate{};
+
+    // Conversion ready
+    meter::ReadyNotifier _rdy{};
+    bool _rdy_enabled{};
+    ads111x::Config _rdy_saved{};  // Comparator settings before enabling
+    uint16_t _rdy_saved_high{}, _rdy_saved_low{};
+
+    // Asynchronous single shot
+    meter::SingleshotRequest _singleshot{};
+    ads111x::Data _singleshot_data{};
+    singleshot_callback_t _singleshot_callback{};
+
+    meter::UnitBusStats _bus_stats{};
 };
 
 ///@cond
@@ -21,11 +21,5 @@ const char UnitAmeter::name[] = "UnitAmeter";
 const types::uid_t UnitAmeter::uid{"UnitAmeter"_mmh3};
 const types::attr_t UnitAmeter::attr{attribute::AccessI2C};
 
-void UnitAmeter::apply_coefficient(const ads111x::Gain gain)
-{
-    UnitADS111x::apply_coefficient(gain);
-    _correction = resolution() * calibrationFactor();
-}
-
 }  // namespace unit
 }  // namespace m5
@@ -29,6 +29,9 @@ constexpr uint8_t reg_internal_temperature_table[] = {
     INTERNAL_TEMPERATURE_FAHRENHEIT_REG,
 };
 
+// Status poll interval while the firmware is busy on periodic measurement (same as the single shot)
+constexpr uint32_t STATUS_POLL_INTERVAL_US{1000};
+
 }  // namespace
 
 namespace m5 {
@@ -40,10 +43,12 @@ const types::attr_t UnitDualKmeter::attr{attribute::AccessI2C};
 
 bool UnitDualKmeter::begin()
 {
+    auto scope = _bus_stats.scope(meter::Call::Begin);
+
     auto ssize = stored_size();
     assert(ssize && "stored_size must be greater than zero");
     if (ssize != _data->capacity()) {
-        _data.reset(new m5::container::CircularBuffer<Data>(ssize));
+        _data.reset(new meter::RingBuffer<Data>(ssize));
         if (!_data) {
             M5_LIB_LOGE("Failed to allocate");
             return false;
@@ -57,45 +62,102 @@ bool UnitDualKmeter::begin()
     }
     M5_LIB_LOGD("FW:%02X", ver);
 
-    return _cfg.start_periodic
-               ? startPeriodicMeasurement(_cfg.interval, _cfg.measurement_channel, _cfg.measurement_unit)
-               : true;
+    if (!_cfg.start_periodic) {
+        return true;
+    }
+    return _cfg.alternate ? startAlternatingMeasurement(_cfg.interval, _cfg.measurement_unit)
+                          : startPeriodicMeasurement(_cfg.interval, _cfg.measurement_channel, _cfg.measurement_unit);
 }
 
 void UnitDualKmeter::update(const bool force)
 {
     _updated = false;
     if (inPeriodic()) {
-        elapsed_time_t at{m5::utility::millis()};
-        if (force || !_latest || at >= _latest + _interval) {
+        const uint32_t at{(uint32_t)m5::utility::micros()};
+        if (force || _schedule.due(at)) {
+            auto scope = _bus_stats.scope(meter::Call::Update);
             Data d{};
-            _updated = is_data_ready() && read_measurement(d, _munit);
+            const bool ready{is_data_ready()};
+            _updated = ready && read_measurement(d, _munit);
+            if (!ready) {
+                _bus_stats.poll();
+                _settling = _switched;
+                // Poll the status again later rather than on every update while the firmware is busy
+                _schedule.retry(at, STATUS_POLL_INTERVAL_US);
+            }
             if (_updated) {
                 _latest   = m5::utility::millis();
                 d.channel = _channel;
+                _schedule.advance(at);
+                d.stamp(at);
                 _data->push_back(d);
+                if (_alternating) {
+                    alternate_channel(d, at);
+                }
             }
         }
     }
 }
 
+void UnitDualKmeter::alternate_channel(const Data& d, const uint32_t at)
+{
+    const auto idx = m5::stl::to_underlying(d.channel) & 1;
+    // Only if it was busy after the switch, otherwise it would be the time until the poll, not the settle latency
+    if (_settling) {
+        _settle[idx].record(at - _switched_at);
+    }
+    _channel_data[idx]->push_back(d);
+
+    const Channel next{d.channel == Channel::One ? Channel::Two : Channel::One};
+    _switched    = writeCurrentChannel(next);
+    _switched_at = (uint32_t)m5::utility::micros();
+    _settling    = false;
+    if (!_switched) {
+        // Measure the same channel again and switch after the next sample
+        M5_LIB_LOGW("Failed to switch the channel");
+        return;
+    }
+    // The status is busy until the switched channel settles, so do not poll it before the shortest settle latency
+    const auto& h = _settle[m5::stl::to_underlying(next)];
+    if (h.count && h.min > STATUS_POLL_INTERVAL_US) {
+        _schedule.retry(_switched_at, h.min - STATUS_POLL_INTERVAL_US);
+    }
+}
+
+bool UnitDualKmeter::nextDue(uint32_t& at) const
+{
+    if (!inPeriodic()) {
+        return false;
+    }
+    at = _schedule.next((uint32_t)m5::utility::micros());
+    return true;
+}
+
 bool UnitDualKmeter::start_periodic_measurement()
 {
     if (inPeriodic()) {
         M5_LIB_LOGD("Periodic measurements are running");
         return false;
     }
-    _periodic = true;
-    _latest   = 0;
+    _periodic    = true;
+    _latest      = 0;
+    _alternating = false;
+    _schedule.reset();
+    _schedule.interval(meter::millisToMicros(_interval));
     return _periodic;
 }
 
 bool UnitDualKmeter::start_periodic_measurement(const uint32_t interval, const Channel channel,
                                                 const MeasurementUnit munit)
 {
+    if (interval > meter::MAX_SPAN_MILLIS) {
+        M5_LIB_LOGE("Interval too long %u (up to %u)", interval, meter::MAX_SPAN_MILLIS);
+        return false;
+    }
     if (writeCurrentChannel(channel) && start_periodic_measurement()) {
         _interval = interval;
         _munit    = munit;
+        _schedule.interval(meter::millisToMicros(interval));
         return true;
     }
     return false;
@@ -103,10 +165,49 @@ bool UnitDualKmeter::start_periodic_measurement(const uint32_t interval, const C
 
 bool UnitDualKmeter::stop_periodic_measurement()
 {
-    _periodic = _updated = false;
+    _periodic = _updated = _alternating = false;
     return true;
 }
 
+bool UnitDualKmeter::startAlternatingMeasurement(const uint32_t interval, const MeasurementUnit munit)
+{
+    if (inPeriodic()) {
+        M5_LIB_LOGD("Periodic measurements are running");
+        return false;
+    }
+    for (auto&& buf : _channel_data) {
+        if (!buf || buf->capacity() != stored_size()) {
+            buf.reset(new meter::RingBuffer<Data>(stored_size()));
+            if (!buf) {
+                M5_LIB_LOGE("Failed to allocate");
+                return false;
+            }
+        }
+        buf->clear();
+    }
+    for (auto&& h : _settle) {
+        h = meter::Histogram{};
+    }
+
+    if (start_periodic_measurement(interval, Channel::One, munit)) {
+        _alternating = true;
+        _switched    = false;  // Channel::One may have been selected already
+        _settling    = false;
+        _switched_at = (uint32_t)m5::utility::micros();
+        return true;
+    }
+    return false;
+}
+
+void UnitDualKmeter::channelFlush()
+{
+    for (auto&& buf : _channel_data) {
+        if (buf) {
+            buf->clear();
+        }
+    }
+}
+
 bool UnitDualKmeter::readStatus(uint8_t& status)
 {
     status = 0xFF;
@@ -121,6 +222,30 @@ bool UnitDualKmeter::readFirmwareVersion(uint8_t& ver)
 
 bool UnitDualKmeter::measureSingleshot(dual_kmeter::Data& d, const dual_kmeter::Channel channel,
                                        const dual_kmeter::MeasurementUnit munit, const uint32_t timeoutMs)
+{
+    auto scope = _bus_stats.scope(meter::Call::Singleshot);
+    auto step  = [this, timeoutMs](const uint32_t, const uint32_t elapsed, uint32_t& wait) {
+        return data_ready_step(elapsed, wait, timeoutMs);
+    };
+    dual_kmeter::Channel prev_ch{};
+    return start_singleshot(d, channel, prev_ch) && meter::pollUntilDone(step) && read_measurement(d, munit) &&
+           writeCurrentChannel(prev_ch);
+}
+
+bool UnitDualKmeter::measureInternalSingleshot(dual_kmeter::Data& d, const dual_kmeter::Channel channel,
+                                               const dual_kmeter::MeasurementUnit munit, const uint32_t timeoutMs)
+{
+    auto scope = _bus_stats.scope(meter::Call::Singleshot);
+    auto step  = [this, timeoutMs](const uint32_t, const uint32_t elapsed, uint32_t& wait) {
+        return data_ready_step(elapsed, wait, timeoutMs);
+    };
+    dual_kmeter::Channel prev_ch{};
+    return start_singleshot(d, channel, prev_ch) && meter::pollUntilDone(step) &&
+           read_internal_measurement(d, munit) && writeCurrentChannel(prev_ch);
+}
+
+bool UnitDualKmeter::start_singleshot(dual_kmeter::Data& d, const dual_kmeter::Channel channel,
+                                      dual_kmeter::Channel& prev_ch)
 {
     if (inPeriodic()) {
         M5_LIB_LOGD("Periodic measurements are running");
@@ -128,44 +253,54 @@ bool UnitDualKmeter::measureSingleshot(dual_kmeter::Data& d, const dual_kmeter::
     }
 
     d.channel = channel;
+    prev_ch   = _channel;
+    return writeCurrentChannel(channel);
+}
 
-    auto prev_ch = _channel;
-    if (writeCurrentChannel(channel)) {
-        auto timeout_at = m5::utility::millis() + timeoutMs;
-        do {
-            if (is_data_ready()) {
-                return read_measurement(d, munit) && writeCurrentChannel(prev_ch);
-            }
-            m5::utility::delay(1);
-        } while (m5::utility::millis() <= timeout_at);
+meter::Progress UnitDualKmeter::data_ready_step(const uint32_t elapsed, uint32_t& wait, const uint32_t timeoutMs)
+{
+    _bus_stats.poll();
+    if (is_data_ready()) {
+        return meter::Progress::Completed;
+    }
+    if (elapsed > meter::millisToMicros(timeoutMs)) {
         M5_LIB_LOGW("Failed due to timeout");
+        return meter::Progress::Failed;
     }
-    return false;
+    wait = STATUS_POLL_INTERVAL_US;
+    return meter::Progress::Pending;
 }
 
-bool UnitDualKmeter::measureInternalSingleshot(dual_kmeter::Data& d, const dual_kmeter::Channel channel,
-                                               const dual_kmeter::MeasurementUnit munit, const uint32_t timeoutMs)
+#if M5_UNIT_METER_COROUTINE
+meter::Task<bool> UnitDualKmeter::measureSingleshotAsync(dual_kmeter::Data& d, const dual_kmeter::Channel channel,
+                                                         const dual_kmeter::MeasurementUnit munit,
+                                                         const uint32_t timeoutMs)
 {
-    if (inPeriodic()) {
-        M5_LIB_LOGD("Periodic measurements are running");
-        return false;
+    auto step = [this, timeoutMs](const uint32_t, const uint32_t elapsed, uint32_t& wait) {
+        return data_ready_step(elapsed, wait, timeoutMs);
+    };
+    dual_kmeter::Channel prev_ch{};
+    if (!start_singleshot(d, channel, prev_ch) || !co_await meter::pollUntilDoneAsync(step)) {
+        co_return false;
     }
+    co_return read_measurement(d, munit) && writeCurrentChannel(prev_ch);
+}
 
-    d.channel = channel;
-
-    auto prev_ch = _channel;
-    if (writeCurrentChannel(channel)) {
-        auto timeout_at = m5::utility::millis() + timeoutMs;
-        do {
-            if (is_data_ready()) {
-                return read_internal_measurement(d, munit) && writeCurrentChannel(prev_ch);
-            }
-            m5::utility::delay(1);
-        } while (m5::utility::millis() <= timeout_at);
-        M5_LIB_LOGW("Failed due to timeout");
+meter::Task<bool> UnitDualKmeter::measureInternalSingleshotAsync(dual_kmeter::Data& d,
+                                                                 const dual_kmeter::Channel channel,
+                                                                 const dual_kmeter::MeasurementUnit munit,
+                                                                 const uint32_t timeoutMs)
+{
+    auto step = [this, timeoutMs](const uint32_t, const uint32_t elapsed, uint32_t& wait) {
+        return data_ready_step(elapsed, wait, timeoutMs);
+    };
+    dual_kmeter::Channel prev_ch{};
+    if (!start_singleshot(d, channel, prev_ch) || !co_await meter::pollUntilDoneAsync(step)) {
+        co_return false;
     }
-    return false;
+    co_return read_internal_measurement(d, munit) && writeCurrentChannel(prev_ch);
 }
+#endif
 
 bool UnitDualKmeter::readCurrentChannel(dual_kmeter::Channel& channel)
 {
@@ -179,7 +314,7 @@ bool UnitDualKmeter::readCurrentChannel(dual_kmeter::Channel& channel)
 
 bool UnitDualKmeter::writeCurrentChannel(const dual_kmeter::Channel channel)
 {
-    if (writeRegister8(CHANNEL_REG, m5::stl::to_underlying(channel))) {
+    if (write_register8(CHANNEL_REG, m5::stl::to_underlying(channel))) {
         _channel = channel;
         return true;
     }
@@ -197,5 +332,23 @@ bool UnitDualKmeter::read_internal_measurement(Data& d, const dual_kmeter::Measu
     return read_register(reg_internal_temperature_table[m5::stl::to_underlying(munit)], d.raw.data(), d.raw.size());
 }
 
+size_t UnitDualKmeter::drainTemperature(float* out, const size_t len)
+{
+    return _data->consume(len, [out](const Data* p, const size_t n, const size_t offset) {
+        convertTemperature(out + offset, p, n);
+    });
+}
+
+void UnitDualKmeter::convertTemperature(float* out, const dual_kmeter::Data* in, const size_t len)
+{
+    // Unpack the little-endian 32-bit values without branches
+    for (size_t i = 0; i < len; ++i) {
+        const auto& r = in[i].raw;
+        out[i] = static_cast<int32_t>(((uint32_t)r[3] << 24) | ((uint32_t)r[2] << 16) | ((uint32_t)r[1] << 8) |
+                                      ((uint32_t)r[0] << 0)) *
+                 0.01f;
+    }
+}
+
 }  // namespace unit
 }  // namespace m5
@@ -10,8 +10,12 @@
 #ifndef M5_UNIT_METER_UNIT_DUAL_KMETER_HPP
 #define M5_UNIT_METER_UNIT_DUAL_KMETER_HPP
 
+#include "meter_schedule.hpp"
+#include "meter_timestamp.hpp"
+#include "meter_stats.hpp"
+#include "meter_ring_buffer.hpp"
+#include "meter_coroutine.hpp"
 #include <M5UnitComponent.hpp>
-#include <m5_utility/container/circular_buffer.hpp>
 #include <limits>  // NaN
 #include <array>
 
@@ -46,7 +50,7 @@ enum class MeasurementUnit : uint8_t {
   @struct Data
   @brief Measurement data group
  */
-struct Data {
+struct Data : meter::SampleTimestamp {
     std::array<uint8_t, 4> raw{};  //!< Raw data
     Channel channel{};             //!< Which channel?
 
@@ -103,10 +107,12 @@ public:
         dual_kmeter::Channel measurement_channel{dual_kmeter::Channel::One};
         //! //!< measurement unit if start on begin
         dual_kmeter::MeasurementUnit measurement_unit{dual_kmeter::MeasurementUnit::Celsius};
+        //! Alternate the channels if start on begin (measurement_channel is ignored)
+        bool alternate{false};
     };
 
     explicit UnitDualKmeter(const uint8_t addr = DEFAULT_ADDRESS)
-        : Component(addr), _data{new m5::container::CircularBuffer<dual_kmeter::Data>(1)}
+        : Component(addr), _data{new meter::RingBuffer<dual_kmeter::Data>(1)}
     {
         auto ccfg  = component_config();
         ccfg.clock = 100 * 1000U;
@@ -150,6 +156,26 @@ public:
     {
         _munit = munit;
     }
+    //! @brief Periodic interval in microseconds
+    inline uint32_t intervalMicros() const
+    {
+        return _schedule.interval();
+    }
+    /*!
+      @brief Effective sample rate (Hz) of the periodic measurement
+      @return Measured rate since the periodic measurement started, or zero if not yet known
+    */
+    inline float effectiveSamplingRate() const
+    {
+        return _schedule.effectiveRate();
+    }
+    /*!
+      @brief Time the next update() accesses the bus
+      @param[out] at Time (us)
+      @return True if update() has something to do, false if idle
+      @note For the bus scheduler to order the units by the deadline
+    */
+    bool nextDue(uint32_t& at) const;
     ///@}
 
     ///@name Measurement data by periodic
@@ -161,6 +187,45 @@ public:
     }
     ///@}
 
+    ///@name Bulk access to the measurement data
+    ///@{
+    /*!
+      @brief Take out the oldest data
+      @param[out] out Output buffer
+      @param len Up to the number of data
+      @return Number of data taken out
+     */
+    inline size_t drain(dual_kmeter::Data* out, const size_t len)
+    {
+        return _data->read(out, len);
+    }
+    /*!
+      @brief Stored data from the oldest as contiguous spans, without copying
+      @param[out] first Oldest part
+      @param[out] second Wrapped part, empty if not wrapped
+      @return Number of the data
+      @warning The spans are valid until the buffer is modified (update(), discard(), flush() etc.)
+     */
+    inline size_t spans(meter::Span<const dual_kmeter::Data>& first, meter::Span<const dual_kmeter::Data>& second) const
+    {
+        return _data->segments(first, second);
+    }
+    using PeriodicMeasurementAdapter<UnitDualKmeter, dual_kmeter::Data>::discard;
+    /*!
+      @brief Discard the oldest data
+      @param n Up to the number of data
+      @return Number of discarded data
+     */
+    inline size_t discard(const size_t n)
+    {
+        return _data->pop_front(n);
+    }
+    //! @brief Take out the oldest temperatures
+    size_t drainTemperature(float* out, const size_t len);
+    //! @brief Convert the data to the temperatures
+    static void convertTemperature(float* out, const dual_kmeter::Data* in, const size_t len);
+    ///@}
+
     ///@name Periodic measurement
     ///@{
     /*!
@@ -174,7 +239,7 @@ public:
     /*!
       @brief Start periodic measurement
       @oaram channel Channel to be measured
-      @param interval Periodic interval(ms)
+      @param interval Periodic interval(ms), up to meter::MAX_SPAN_MILLIS
       @param munit Measurement unit
       @return True if successful
     */
@@ -252,14 +317,143 @@ public:
     bool writeCurrentChannel(const dual_kmeter::Channel channel);
     ///@}
 
+    ///@name Alternating measurement
+    ///@{
+    /*!
+      @brief Start periodic measurement alternating Channel::One and Channel::Two
+      @details update() switches the channel after each sample, and reads the next sample when the firmware has
+      completed the conversion of the switched channel. The samples are stored in the buffer of each channel, and also
+      in the measurement data buffer in order of the acquisition
+      @param interval Periodic interval of the samples (ms, up to meter::MAX_SPAN_MILLIS), zero for the highest rate
+      the firmware allows
+      @param munit Measurement unit
+      @return True if successful
+      @note Each channel is sampled at most every two intervals, and at most once per settle latency
+      @note Stop by stopPeriodicMeasurement()
+    */
+    bool startAlternatingMeasurement(const uint32_t interval,
+                                     const dual_kmeter::MeasurementUnit munit = dual_kmeter::MeasurementUnit::Celsius);
+    //! @brief In alternating measurement?
+    inline bool inAlternating() const
+    {
+        return inPeriodic() && _alternating;
+    }
+    //! @brief Gets the number of stored data of the channel
+    inline size_t channelAvailable(const dual_kmeter::Channel ch) const
+    {
+        auto& buf = _channel_data[m5::stl::to_underlying(ch) & 1];
+        return buf ? buf->size() : 0U;
+    }
+    //! @brief Is the buffer of the channel empty?
+    inline bool channelEmpty(const dual_kmeter::Channel ch) const
+    {
+        return channelAvailable(ch) == 0;
+    }
+    //! @brief Gets the oldest data of the channel
+    inline dual_kmeter::Data channelOldest(const dual_kmeter::Channel ch) const
+    {
+        return !channelEmpty(ch) ? _channel_data[m5::stl::to_underlying(ch) & 1]->front().value() : dual_kmeter::Data{};
+    }
+    //! @brief Gets the latest data of the channel
+    inline dual_kmeter::Data channelLatest(const dual_kmeter::Channel ch) const
+    {
+        return !channelEmpty(ch) ? _channel_data[m5::stl::to_underlying(ch) & 1]->back().value() : dual_kmeter::Data{};
+    }
+    //! @brief Discard the oldest data of the channel
+    inline void channelDiscard(const dual_kmeter::Channel ch)
+    {
+        if (!channelEmpty(ch)) {
+            _channel_data[m5::stl::to_underlying(ch) & 1]->pop_front();
+        }
+    }
+    //! @brief Discard the oldest data of the channel, returns the number of discarded data
+    inline size_t channelDiscard(const dual_kmeter::Channel ch, const size_t n)
+    {
+        auto& buf = _channel_data[m5::stl::to_underlying(ch) & 1];
+        return buf ? buf->pop_front(n) : 0U;
+    }
+    /*!
+      @brief Stored data of the channel from the oldest as contiguous spans, without copying
+      @return Number of the data
+      @warning The spans are valid until the buffer is modified
+     */
+    inline size_t channelSpans(const dual_kmeter::Channel ch, meter::Span<const dual_kmeter::Data>& first,
+                               meter::Span<const dual_kmeter::Data>& second) const
+    {
+        auto& buf = _channel_data[m5::stl::to_underlying(ch) & 1];
+        if (!buf) {
+            first = second = meter::Span<const dual_kmeter::Data>{};
+            return 0U;
+        }
+        return buf->segments(first, second);
+    }
+    //! @brief Discard all data of both channels
+    void channelFlush();
+    /*!
+      @brief Settle latency of the channel
+      @details Time from the channel switch to the completion of the conversion of the channel (us),
+      at the resolution of the status poll
+      @note Recorded only for the samples whose status was busy after the switch. If the interval is longer than the
+      settle latency, the status is already ready at the first poll and nothing is recorded
+     */
+    inline const meter::Histogram& settleLatency(const dual_kmeter::Channel ch) const
+    {
+        return _settle[m5::stl::to_underlying(ch) & 1];
+    }
+    ///@}
+
+#if M5_UNIT_METER_COROUTINE
+    ///@name Coroutine (C++20)
+    ///@warning The data must outlive the task
+    ///@{
+    //! @brief Awaitable measureSingleshot(), the task sleeps between the status polls
+    meter::Task<bool> measureSingleshotAsync(
+        dual_kmeter::Data& d, const dual_kmeter::Channel channel,
+        const dual_kmeter::MeasurementUnit munit = dual_kmeter::MeasurementUnit::Celsius,
+        const uint32_t timeoutMs                 = 100);
+    //! @brief Awaitable measureInternalSingleshot(), the task sleeps between the status polls
+    meter::Task<bool> measureInternalSingleshotAsync(
+        dual_kmeter::Data& d, const dual_kmeter::Channel channel,
+        const dual_kmeter::MeasurementUnit munit = dual_kmeter::MeasurementUnit::Celsius,
+        const uint32_t timeoutMs                 = 100);
+    ///@}
+#endif
+
+    ///@name Bus statistics
+    ///@{
+    /*!
+      @brief Register access counters and call latencies
+      @note Counted only if M5_UNIT_METER_BUS_STATS is non-zero, otherwise empty
+     */
+    inline const meter::UnitBusStats& busStats() const
+    {
+        return _bus_stats;
+    }
+    //! @brief Clear the bus statistics
+    inline void resetBusStats()
+    {
+        _bus_stats.reset();
+    }
+    ///@}
+
 protected:
     inline bool read_register(const uint8_t reg, uint8_t* rbuf, const uint32_t len)
     {
-        return readRegister(reg, rbuf, len, 0, false);
+        const uint32_t at{_bus_stats.mark()};
+        const bool ok{readRegister(reg, rbuf, len, 0, false)};
+        _bus_stats.read(reg, len, ok, at);
+        return ok;
     }
     inline bool read_register8(const uint8_t reg, uint8_t& v)
     {
-        return readRegister8(reg, v, 0, false);
+        return read_register(reg, &v, 1);
+    }
+    inline bool write_register8(const uint8_t reg, const uint8_t v)
+    {
+        const uint32_t at{_bus_stats.mark()};
+        const bool ok{writeRegister8(reg, v)};
+        _bus_stats.write(reg, 1, ok, at);
+        return ok;
     }
 
     bool start_periodic_measurement();
@@ -268,6 +462,7 @@ protected:
     bool stop_periodic_measurement();
 
     bool read_measurement(dual_kmeter::Data& d, const dual_kmeter::MeasurementUnit munit);
+    void alternate_channel(const dual_kmeter::Data& d, const uint32_t at);
     bool read_internal_measurement(dual_kmeter::Data& d, const dual_kmeter::MeasurementUnit munit);
 
     bool is_data_ready()
@@ -275,13 +470,26 @@ protected:
         uint8_t s{};
         return readStatus(s) && (s == 0U);
     }
+
+    // Shared by the blocking functions and the *Async() counterparts (elapsed in us)
+    bool start_singleshot(dual_kmeter::Data& d, const dual_kmeter::Channel channel, dual_kmeter::Channel& prev_ch);
+    meter::Progress data_ready_step(const uint32_t elapsed, uint32_t& wait, const uint32_t timeoutMs);
+
     M5_UNIT_COMPONENT_PERIODIC_MEASUREMENT_ADAPTER_HPP_BUILDER(UnitDualKmeter, dual_kmeter::Data);
 
 protected:
-    std::unique_ptr<m5::container::CircularBuffer<dual_kmeter::Data>> _data{};
+    std::unique_ptr<meter::RingBuffer<dual_kmeter::Data>> _data{};
     dual_kmeter::MeasurementUnit _munit{dual_kmeter::MeasurementUnit::Celsius};
     dual_kmeter::Channel _channel{}, _current_channel{};
     config_t _cfg{};
+    meter::Schedule _schedule{};
+    meter::UnitBusStats _bus_stats{};
+
+    std::array<std::unique_ptr<meter::RingBuffer<dual_kmeter::Data>>, 2> _channel_data{};
+    std::array<meter::Histogram, 2> _settle{};
+    uint32_t _switched_at{};  // us
+    bool _alternating{}, _switched{};
+    bool _settling{};  // Status was busy after the switch
 };
 
 namespace dual_kmeter {
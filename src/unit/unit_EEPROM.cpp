@@ -9,13 +9,15 @@
 */
 #include "unit_EEPROM.hpp"
 #include <M5Utility.h>
+#include <algorithm>
 
 using namespace m5::utility::mmh3;
 using namespace m5::unit::ads111x;
 using namespace m5::unit::types;
 
 namespace {
-constexpr uint8_t DATA_ADDRESS{0xD0};
+constexpr uint8_t DATA_ADDRESS{0xD0};  // 0xD0..0xFF
+constexpr uint8_t RECORD_SIZE{8};      // Per gain
 constexpr Gain gain_table[] = {
     Gain::PGA_6144, Gain::PGA_4096, Gain::PGA_2048, Gain::PGA_1024, Gain::PGA_512, Gain::PGA_256,
 };
@@ -31,49 +33,91 @@ const types::attr_t UnitEEPROM::attr{attribute::AccessI2C};
 
 bool UnitEEPROM::readCalibration()
 {
-    int idx{};
     _calibration.fill({});
+    _valid = 0;
+    _hash  = 0;
 
+    // One pointer write and one sequential read of the whole block
+    std::array<uint8_t, RECORD_SIZE * m5::stl::size(gain_table)> block{};
+    const bool bulk = writeWithTransaction(DATA_ADDRESS, nullptr, 0U) == m5::hal::error::error_t::OK &&
+                      readWithTransaction(block.data(), block.size()) == m5::hal::error::error_t::OK;
+    if (!bulk) {
+        M5_LIB_LOGW("Failed to read the block, read each gain");
+    }
+
+    bool all{true};
     for (auto&& e : gain_table) {
-        assert(idx < _calibration.size() && "illegal index");
-        if (!read_calibration(e, _calibration[idx].hope, _calibration[idx].actual)) {
-            M5_LIB_LOGE("Failed to read calibration");
-            return false;
+        const auto idx = m5::stl::to_underlying(e);
+        uint8_t* rec   = block.data() + idx * RECORD_SIZE;
+        auto& c        = _calibration[idx];
+        const bool got = bulk || read_record(e, rec);
+        all            = all && got;
+        if (got && parse_calibration(rec, c)) {
+            _valid |= 1U << idx;
+        } else {
+            c = Calibration{};
+            M5_LIB_LOGE("Invalid calibration %u", idx);
         }
-        M5_LIB_LOGV("Calibration[%u]: %d,%d", e, _calibration[idx].hope, _calibration[idx].actual);
-        ++idx;
+        M5_LIB_LOGV("Calibration[%u]: %d,%d", idx, c.hope, c.actual);
     }
     _calibration[6] = _calibration[7] = _calibration[5];  // 6,7 are the same as 5. see also Gain
-    return true;
+    _valid |= (_valid & (1U << 5)) ? 0xC0 : 0x00;
+    _hash = all ? fnv1a32(block.data(), block.size()) : 0;
+    return _valid == 0xFF;
 }
 
-bool UnitEEPROM::read_calibration(const Gain gain, int16_t& hope, int16_t& actual)
+void UnitEEPROM::exportCalibration(CalibrationRecord& rec) const
 {
-    uint8_t reg = DATA_ADDRESS + m5::stl::to_underlying(gain) * 8;
-    std::array<uint8_t, 8> buf{};
-    hope = actual = 1;
+    rec       = CalibrationRecord{};
+    rec.valid = _valid;
+    rec.hash  = _hash;
+    std::copy(_calibration.begin(), _calibration.end(), rec.gain.begin());
+}
 
+void UnitEEPROM::importCalibration(const CalibrationRecord& rec)
+{
+    _valid = rec.valid;
+    _hash  = rec.hash;
+    std::copy(rec.gain.begin(), rec.gain.end(), _calibration.begin());
+}
+
+bool UnitEEPROM::read_record(const Gain gain, uint8_t* rec)
+{
+    uint8_t reg = DATA_ADDRESS + m5::stl::to_underlying(gain) * RECORD_SIZE;
     if (writeWithTransaction(reg, nullptr, 0U) != m5::hal::error::error_t::OK) {
         M5_LIB_LOGE("Failed to write");
         return false;
     }
-    if (readWithTransaction(buf.data(), buf.size()) != m5::hal::error::error_t::OK) {
+    return readWithTransaction(rec, RECORD_SIZE) == m5::hal::error::error_t::OK;
+}
+
+bool UnitEEPROM::read_calibration(const Gain gain, int16_t& hope, int16_t& actual)
+{
+    std::array<uint8_t, RECORD_SIZE> buf{};
+    Calibration c{};
+    hope = actual = 1;
+    if (!read_record(gain, buf.data()) || !parse_calibration(buf.data(), c)) {
         return false;
     }
+    hope   = c.hope;
+    actual = c.actual;
+    return true;
+}
 
+bool UnitEEPROM::parse_calibration(const uint8_t* rec, Calibration& c)
+{
     uint8_t xorchk{};
     for (int_fast8_t i = 0; i < 5; ++i) {
-        xorchk ^= buf[i];
+        xorchk ^= rec[i];
     }
-    if (xorchk != buf[5]) {
+    if (xorchk != rec[5]) {
         return false;
     }
 
-    m5::types::big_uint16_t hh(buf[1], buf[2]);
-    m5::types::big_uint16_t aa(buf[3], buf[4]);
-    hope   = (int16_t)hh.get();
-    actual = (int16_t)aa.get();
-
+    m5::types::big_uint16_t hh(rec[1], rec[2]);
+    m5::types::big_uint16_t aa(rec[3], rec[4]);
+    c.hope   = (int16_t)hh.get();
+    c.actual = (int16_t)aa.get();
     return true;
 }
 
@@ -11,12 +11,16 @@
 #define M5_UNIT_METER_UNIT_EEPROM_HPP
 
 #include "unit_ADS111x.hpp"
+#include "meter_calibration_cache.hpp"
 #include <M5UnitComponent.hpp>
 #include <m5_utility/stl/extension.hpp>
 #include <array>
 
 namespace m5 {
 namespace unit {
+
+class UnitAVmeterBase;
+
 /*!
   @namespace meter
   @brief namespace for Meter
@@ -51,18 +55,50 @@ public:
     {
         return actual(gain) ? (float)hope(gain) / actual(gain) : 1.0f;
     }
+    //! @brief Is the calibration of the gain read and its checksum valid?
+    inline bool validCalibration(m5::unit::ads111x::Gain gain) const
+    {
+        return _valid & (1U << m5::stl::to_underlying(gain));
+    }
 
+    /*!
+      @brief Read the calibration of all gains
+      @details Reads the whole calibration block in one sequential read and validates the checksum of each gain in
+      memory. If the sequential read fails, each gain is read separately
+      @return True if the calibration of every gain is valid
+      @note The gain whose calibration is invalid is not calibrated (the factor is 1.0)
+     */
     bool readCalibration();
 
+    ///@name Cache
+    ///@{
+    /*!
+      @brief Content hash of the calibration block
+      @return Hash of the block read by readCalibration(), zero if not read entirely
+     */
+    inline uint32_t calibrationHash() const
+    {
+        return _hash;
+    }
+    //! @brief Export the calibration to the record
+    void exportCalibration(CalibrationRecord& rec) const;
+    //! @brief Import the calibration from the record instead of reading the EEPROM
+    void importCalibration(const CalibrationRecord& rec);
+    ///@}
+
 protected:
+    using Calibration = GainCalibration;
+
+    bool read_record(const m5::unit::ads111x::Gain gain, uint8_t* rec);
     bool read_calibration(const m5::unit::ads111x::Gain gain, int16_t& hope, int16_t& actual);
+    static bool parse_calibration(const uint8_t* rec, Calibration& c);
 
 private:
-    struct Calibration {
-        int16_t hope{1};
-        int16_t actual{1};
-    };
+    friend class m5::unit::UnitAVmeterBase;  // Assigns the adapter as the parent
+
     std::array<Calibration, 8 /*Gain*/> _calibration{};
+    uint32_t _hash{};
+    uint8_t _valid{};  // Bit per gain
 };
 
 }  // namespace meter
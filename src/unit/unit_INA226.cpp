@@ -22,6 +22,8 @@ namespace {
 constexpr uint16_t MANUFACTURER_ID{0X5449};
 constexpr uint16_t DIE_ID{0x2260};
 constexpr uint16_t DEFAULT_CONFIG_VALUE{0x4127};
+// Data-ready poll interval when the conversion is not yet completed at the deadline (fraction of the interval)
+constexpr uint32_t DATA_READY_POLL_DIVISOR{16};
 
 constexpr Mode mode_table[] = {
     Mode::PowerDown, Mode::ShuntVoltageSingle, Mode::BusVoltageSingle, Mode::ShuntAndBusSingle,
@@ -231,7 +233,8 @@ uint16_t caluculate_calibration(const float shuntRes, const float maxCur, const
     return (0.00512f / (curLSB * shuntRes));
 }
 
-uint32_t calculate_interval(const uint16_t v /* config bits*/)
+// Conversion period (us)
+uint32_t calculate_interval_us(const uint16_t v /* config bits*/)
 {
     static constexpr uint16_t rate_table[8] = {1, 4, 16, 64, 128, 256, 512, 1024};
     static constexpr uint16_t conv_table[8] = {140, 204, 332, 588, 1100, 2116, 4156, 8244};  // us
@@ -260,7 +263,13 @@ uint32_t calculate_interval(const uint16_t v /* config bits*/)
             us = 0;
             break;
     }
-    return (us + (smp * overhead_per_sample_us) + 999) / 1000;
+    return us + (smp * overhead_per_sample_us);
+}
+
+// Conversion period rounded up (ms)
+uint32_t calculate_interval(const uint16_t v /* config bits*/)
+{
+    return (calculate_interval_us(v) + 999) / 1000;
 }
 
 }  // namespace
@@ -275,7 +284,7 @@ const types::attr_t UnitINA226::attr{attribute::AccessI2C};
 
 UnitINA226::UnitINA226(const float shuntRes, const float maxCurA, const float curLSB, const uint8_t addr)
     : Component(addr),
-      _data{new m5::container::CircularBuffer<ina226::Data>(1)},
+      _data{new meter::RingBuffer<ina226::Data>(1)},
       _shuntRes(shuntRes),
       _maxCurrentA{maxCurA},
       _currentLSB{curLSB}
@@ -290,10 +299,12 @@ UnitINA226::UnitINA226(const float shuntRes, const float maxCurA, const float cu
 
 bool UnitINA226::begin()
 {
+    auto scope = _bus_stats.scope(meter::Call::Begin);
+
     auto ssize = stored_size();
     assert(ssize && "stored_size must be greater than zero");
     if (ssize != _data->capacity()) {
-        _data.reset(new m5::container::CircularBuffer<Data>(ssize));
+        _data.reset(new meter::RingBuffer<Data>(ssize));
         if (!_data) {
             M5_LIB_LOGE("Failed to allocate");
             return false;
@@ -309,11 +320,11 @@ bool UnitINA226::begin()
 
     // Check unit
     uint16_t mid{}, did{};
-    if (!readRegister16BE(MANUFACTURER_ID_REG, mid, 0)) {
+    if (!read_register16(MANUFACTURER_ID_REG, mid)) {
         M5_LIB_LOGE("Failed to read Manufacturer ID %x", mid);
         return false;
     }
-    if (!readRegister16BE(DIE_ID_REG, did, 0)) {
+    if (!read_register16(DIE_ID_REG, did)) {
         M5_LIB_LOGE("Failed to read Die ID %x", did);
         return false;
     }
@@ -347,24 +358,67 @@ void UnitINA226::update(const bool force)
 {
     _updated = false;
     if (inPeriodic()) {
-        elapsed_time_t at{m5::utility::millis()};
-        if (force || !_latest || at >= _latest + _interval) {
+        const uint32_t at{(uint32_t)m5::utility::micros()};
+        bool due{};
+        if (inConversionReady()) {
+            // Read once per notified conversion
+            due = _rdy.consume();
+        } else {
+            due = _schedule.due(at);
+        }
+        if (force || due) {
+            auto scope = _bus_stats.scope(meter::Call::Update);
+            // In the conversion-ready mode, the Mask register read also releases the Alert pin
+            const bool check{_cfg.data_ready_check || inConversionReady()};
+            const bool ready{!check || is_data_ready()};
             Data d{};
-            _updated = is_data_ready() && read_measurement(d);
+            _updated = ready && read_measurement(d);
+            if (!ready) {
+                _bus_stats.poll();
+                if (!inConversionReady()) {
+                    // Poll again later rather than on every update until the conversion completes
+                    _schedule.retry(at, _schedule.interval() / DATA_READY_POLL_DIVISOR);
+                }
+            }
             if (_updated) {
                 _latest = m5::utility::millis();
+                _schedule.advance(at);
+                accumulate(d, at);
+                d.stamp(at);
                 _data->push_back(d);
             }
         }
+    } else if (_singleshot.pending()) {
+        // Complete the requested single shot and notify the callback
+        poll_singleshot((uint32_t)m5::utility::micros());
     }
 }
 
+bool UnitINA226::nextDue(uint32_t& at) const
+{
+    const uint32_t now{(uint32_t)m5::utility::micros()};
+    if (inPeriodic()) {
+        // The notified conversion is read in the next update()
+        at = inConversionReady() ? now : _schedule.next(now);
+        return true;
+    }
+    if (_singleshot.pending()) {
+        at = now + _singleshot.remaining(now);
+        return true;
+    }
+    return false;
+}
+
 bool UnitINA226::start_periodic_measurement(const bool current, const bool voltage, const bool power)
 {
     if (inPeriodic()) {
         M5_LIB_LOGE("Periodic measurements are running");
         return false;
     }
+    if (_singleshot.pending()) {
+        // The triggered conversion is overridden by the continuous mode
+        _singleshot.complete(false);
+    }
 
     _measureBits = (current ? 8 : 0) | (voltage ? 2 : 0) | (power ? 4 : 0) | ((current || power) ? 1 : 0);
     if (!_measureBits) {
@@ -378,6 +432,11 @@ bool UnitINA226::start_periodic_measurement(const bool current, const bool volta
             _periodic = true;
             _latest   = 0;
             _interval = calculate_interval(mc.v);
+            _schedule.interval(calculate_interval_us(mc.v));
+            _acc_continued = false;
+            // The first read waits for the first conversion, so that the deadlines follow the conversions
+            // (Otherwise each deadline precedes the conversion and the flag check polls until it is ready)
+            _schedule.reset((uint32_t)m5::utility::micros() + _schedule.interval());
         }
     }
     return _periodic;
@@ -406,11 +465,73 @@ bool UnitINA226::stop_periodic_measurement()
 }
 
 bool UnitINA226::measureSingleshot(ina226::Data& data, const bool current, const bool voltage, const bool power)
+{
+    auto scope = _bus_stats.scope(meter::Call::Singleshot);
+    return request_singleshot((uint32_t)m5::utility::micros(), current, voltage, power) &&
+           meter::pollUntilDone([this, &data](const uint32_t now, const uint32_t, uint32_t& wait) {
+               return singleshot_step(now, wait, data);
+           });
+}
+
+bool UnitINA226::measureSingleshot(ina226::Data& data, const ina226::Sampling rate, const ina226::ConversionTime sct,
+                                   const ina226::ConversionTime bct, const bool current, const bool voltage,
+                                   const bool power)
+{
+    ModeCfg mc{};
+    if (!read_configuration(mc.v)) {
+        return false;
+    }
+    mc.sampling(rate);
+    mc.shuntConversionTime(sct);
+    mc.busConversionTime(bct);
+    return write_configuration(mc.v) && measureSingleshot(data, current, voltage, power);
+}
+
+bool UnitINA226::requestSingleshot(const bool current, const bool voltage, const bool power)
+{
+    return request_singleshot((uint32_t)m5::utility::micros(), current, voltage, power);
+}
+
+bool UnitINA226::requestSingleshot(const ina226::Sampling rate, const ina226::ConversionTime sct,
+                                   const ina226::ConversionTime bct, const bool current, const bool voltage,
+                                   const bool power)
+{
+    if (inPeriodic() || _singleshot.pending()) {
+        M5_LIB_LOGW("Periodic or single shot measurements are running");
+        return false;
+    }
+    ModeCfg mc{};
+    if (!read_configuration(mc.v)) {
+        return false;
+    }
+    mc.sampling(rate);
+    mc.shuntConversionTime(sct);
+    mc.busConversionTime(bct);
+    return write_configuration(mc.v) && requestSingleshot(current, voltage, power);
+}
+
+bool UnitINA226::trySingleshotResult(ina226::Data& data)
+{
+    poll_singleshot((uint32_t)m5::utility::micros());
+    if (_singleshot.state() == meter::SingleshotState::Completed) {
+        data = _singleshot_data;
+        _singleshot.clear();
+        return true;
+    }
+    return false;
+}
+
+bool UnitINA226::request_singleshot(const uint32_t now, const bool current, const bool voltage, const bool power)
 {
     if (inPeriodic()) {
         M5_LIB_LOGW("Periodic measurements are running");
         return false;
     }
+    if (_singleshot.pending()) {
+        M5_LIB_LOGW("Single shot is requested");
+        return false;
+    }
+    _singleshot.clear();
 
     _measureBits = (current ? 8 : 0) | (voltage ? 2 : 0) | (power ? 4 : 0) | ((current || power) ? 1 : 0);
     if (!_measureBits) {
@@ -421,33 +542,60 @@ bool UnitINA226::measureSingleshot(ina226::Data& data, const bool current, const
     ModeCfg mc{};
     if (read_configuration(mc.v)) {
         mc.mode(single_operation_table[_measureBits]);
-        auto waitMs = calculate_interval(mc.v);
         if (write_configuration(mc.v)) {
-            m5::utility::delay(waitMs);
-            auto timeout_at = m5::utility::millis() + 1000;
-            do {
-                if (is_data_ready() && read_measurement(data)) {
-                    return true;
-                }
-                m5::utility::delay(1);
-            } while (m5::utility::millis() <= timeout_at);
+            // Writing the configuration triggers the conversion, check once at the computed deadline
+            const uint32_t expected = calculate_interval_us(mc.v);
+            _singleshot.start(now, expected, expected + 1000 * 1000U);
+            return true;
         }
     }
     return false;
 }
 
-bool UnitINA226::measureSingleshot(ina226::Data& data, const ina226::Sampling rate, const ina226::ConversionTime sct,
-                                   const ina226::ConversionTime bct, const bool current, const bool voltage,
-                                   const bool power)
+meter::Progress UnitINA226::singleshot_step(const uint32_t now, uint32_t& wait, ina226::Data& data)
 {
-    ModeCfg mc{};
-    if (!read_configuration(mc.v)) {
-        return false;
+    // Sleep until the computed conversion time instead of polling the Mask register
+    poll_singleshot(now, false);
+    if (_singleshot.pending()) {
+        wait = _singleshot.remaining(now);
+        return meter::Progress::Pending;
+    }
+    const bool ok = _singleshot.state() == meter::SingleshotState::Completed;
+    if (ok) {
+        data = _singleshot_data;
+    }
+    _singleshot.clear();
+    return ok ? meter::Progress::Completed : meter::Progress::Failed;
+}
+
+void UnitINA226::poll_singleshot(const uint32_t at, const bool notify)
+{
+    if (!_singleshot.pending()) {
+        return;
+    }
+    if (_singleshot.due(at)) {
+        Mask mask{};
+        if (!read_mask(mask.v)) {
+            _singleshot.complete(false);
+        } else if (mask.CVRF()) {
+            _singleshot_data = Data{};
+            const bool ok    = !mask.OVF() && read_measurement(_singleshot_data);
+            if (ok) {
+                _singleshot_data.stamp(at);
+            }
+            _singleshot.complete(ok);
+        } else {
+            _bus_stats.poll();
+            _singleshot.retry(at);
+        }
+    }
+    if (_singleshot.pending() && _singleshot.expired(at)) {
+        M5_LIB_LOGE("Single shot timed out");
+        _singleshot.complete(false);
+    }
+    if (!_singleshot.pending() && notify && _singleshot_callback) {
+        _singleshot_callback(_singleshot.state() == meter::SingleshotState::Completed, _singleshot_data);
     }
-    mc.sampling(rate);
-    mc.shuntConversionTime(sct);
-    mc.busConversionTime(bct);
-    return write_configuration(mc.v) && measureSingleshot(data, current, voltage, power);
 }
 
 bool UnitINA226::readMode(ina226::Mode& mode)
@@ -551,34 +699,34 @@ bool UnitINA226::writeShuntVoltageConversionTime(const ina226::ConversionTime ct
 
 bool UnitINA226::read_mask(uint16_t& m)
 {
-    return readRegister16BE(MASK_REG, m, 0);
+    return read_register16(MASK_REG, m);
 }
 
 bool UnitINA226::write_mask(const uint16_t m)
 {
-    return writeRegister16BE(MASK_REG, m);
+    return write_register16(MASK_REG, m);
 }
 
 bool UnitINA226::read_configuration(uint16_t& v)
 {
     v = 0;
-    return readRegister16BE(CONFIGURATION_REG, v, 0);
+    return read_register16(CONFIGURATION_REG, v);
 }
 
 bool UnitINA226::write_configuration(const uint16_t v)
 {
-    return writeRegister16BE(CONFIGURATION_REG, v);
+    return write_register16(CONFIGURATION_REG, v);
 }
 
 bool UnitINA226::readCalibration(uint16_t& cal)
 {
     cal = 0;
-    return readRegister16BE(CALIBRATION_REG, cal, 0);
+    return read_register16(CALIBRATION_REG, cal);
 }
 
 bool UnitINA226::writeCalibration(const uint16_t cal)
 {
-    return writeRegister16BE(CALIBRATION_REG, cal);
+    return write_register16(CALIBRATION_REG, cal);
 }
 
 bool UnitINA226::powerDown()
@@ -591,27 +739,69 @@ bool UnitINA226::powerDown()
 }
 
 bool UnitINA226::softReset(const bool all)
+{
+    return start_soft_reset() &&
+           meter::pollUntilDone([this](const uint32_t, const uint32_t elapsed, uint32_t& wait) {
+               return soft_reset_step(elapsed, wait);
+           });
+}
+
+bool UnitINA226::start_soft_reset()
 {
     ModeCfg mc{};
-    uint16_t cal{};
     _periodic = false;
 
     if (read_configuration(mc.v)) {
         mc.reset(true);
         if (write_configuration(mc.v)) {
-            m5::utility::delay(2);
-            if (read_configuration(mc.v) && mc.v == DEFAULT_CONFIG_VALUE && readCalibration(cal) && cal == 0) {
-                _periodic = true;  // Default config register value is 0x4127 (measn Mode ShuntAndBus)
-                return true;
-            }
+            // The reset also clears Mask/Enable, so CNVR no longer drives the pin
+            clear_conversion_ready();
+            return true;
         }
     }
     return false;
 }
 
+meter::Progress UnitINA226::soft_reset_step(const uint32_t elapsed, uint32_t& wait)
+{
+    if (elapsed < 2000) {
+        wait = 2000 - elapsed;
+        return meter::Progress::Pending;
+    }
+    ModeCfg mc{};
+    uint16_t cal{};
+    if (read_configuration(mc.v) && mc.v == DEFAULT_CONFIG_VALUE && readCalibration(cal) && cal == 0) {
+        _periodic = true;  // Default config register value is 0x4127 (measn Mode ShuntAndBus)
+        return meter::Progress::Completed;
+    }
+    return meter::Progress::Failed;
+}
+
+#if M5_UNIT_METER_COROUTINE
+meter::Task<bool> UnitINA226::measureSingleshotAsync(ina226::Data& data, const bool current, const bool voltage,
+                                                     const bool power)
+{
+    if (!request_singleshot(co_await meter::currentTime(), current, voltage, power)) {
+        co_return false;
+    }
+    co_return co_await meter::pollUntilDoneAsync([this, &data](const uint32_t now, const uint32_t, uint32_t& wait) {
+        return singleshot_step(now, wait, data);
+    });
+}
+
+meter::Task<bool> UnitINA226::softResetAsync()
+{
+    if (!start_soft_reset()) {
+        co_return false;
+    }
+    co_return co_await meter::pollUntilDoneAsync(
+        [this](const uint32_t, const uint32_t elapsed, uint32_t& wait) { return soft_reset_step(elapsed, wait); });
+}
+#endif
+
 bool UnitINA226::readAlertLimit(uint16_t& limit)
 {
-    return readRegister16BE(ALERT_LIMIT_REG, limit, 0);
+    return read_register16(ALERT_LIMIT_REG, limit);
 }
 
 bool UnitINA226::writeAlertLimit(const uint16_t limit)
@@ -620,7 +810,7 @@ bool UnitINA226::writeAlertLimit(const uint16_t limit)
         M5_LIB_LOGW("Periodic measurements are running");
         return false;
     }
-    return writeRegister16BE(ALERT_LIMIT_REG, limit);
+    return write_register16(ALERT_LIMIT_REG, limit);
 }
 
 bool UnitINA226::readAlertOccurred(bool& alert)
@@ -704,7 +894,28 @@ bool UnitINA226::writeAlert(const ina226::Alert type, const uint16_t limit, cons
             return false;
         }
         mask.LEN(latch);
-        return writeAlertLimit(limit) && write_mask(mask.v);
+        if (writeAlertLimit(limit) && write_mask(mask.v)) {
+            clear_conversion_ready();  // Replaced by this alert
+            return true;
+        }
+        return false;
+    }
+    return false;
+}
+
+bool UnitINA226::enableConversionReady(const bool enable, const bool activeHigh)
+{
+    Mask mask{};
+    if (read_mask(mask.v)) {
+        mask.v &= ~Mask::ALERT_BITS_MASK;
+        mask.CNVR(enable);
+        mask.APOL(enable && activeHigh);
+        mask.LEN(false);
+        if (write_mask(mask.v)) {
+            _rdy_enabled = enable;
+            _rdy.reset();
+            return true;
+        }
     }
     return false;
 }
@@ -718,17 +929,55 @@ bool UnitINA226::is_data_ready()
 
 bool UnitINA226::read_measurement(ina226::Data& d)
 {
+    // INA226 has no pointer auto-increment, so each register needs its own pointer write and read
     bool ret{true};
     uint8_t reg{SHUNT_VOLTAGE_REG};  // 0x01
     for (uint_fast8_t i = 0; i < 4; ++i) {
         if (_measureBits & (1U << i)) {
-            ret &= readRegister16BE((uint8_t)(reg + i), d.raw[i], 0);  // reg 0x01 - 0x04
+            ret &= read_register16((uint8_t)(reg + i), d.raw[i]);  // reg 0x01 - 0x04
         }
     }
     d.currentLSB = _currentLSB;
     return _measureBits && ret;
 }
 
+void UnitINA226::accumulate(const ina226::Data& d, const uint32_t at)
+{
+    // The first sample after the start covers one conversion period, and the following ones cover the time
+    // since the previous sample, including the time the update() call is late for
+    const uint32_t dt = _acc_continued ? at - _acc_at : _schedule.interval();
+    _acc_at           = at;
+    _acc_continued    = true;
+
+    if (_measureBits & 0x08) {
+        _accumulation.charge += (int64_t)(int16_t)d.raw[3] * dt;
+    }
+    if (_measureBits & 0x04) {
+        _accumulation.energy += (int64_t)d.raw[2] * dt;
+    }
+    _accumulation.duration += dt;
+    ++_accumulation.samples;
+    _accumulation.currentLSB = _currentLSB;
+}
+
+bool UnitINA226::read_register16(const uint8_t reg, uint16_t& v)
+{
+    const uint32_t at{_bus_stats.mark()};
+    // Pointer write and read with repeated start
+    // (The pointer is not cached, since readRegister/writeRegister of the component also move it)
+    const bool ok{readRegister16BE(reg, v, 0, false)};
+    _bus_stats.read(reg, 2, ok, at);
+    return ok;
+}
+
+bool UnitINA226::write_register16(const uint8_t reg, const uint16_t v)
+{
+    const uint32_t at{_bus_stats.mark()};
+    const bool ok{writeRegister16BE(reg, v)};
+    _bus_stats.write(reg, 2, ok, at);
+    return ok;
+}
+
 // class UnitINA226_10A
 const char UnitINA226_10A::name[] = "UnitINA226_10A";
 const types::uid_t UnitINA226_10A::uid{"UnitINA226_10A"_mmh3};
@@ -739,5 +988,40 @@ const char UnitINA226_1A::name[] = "UnitINA226_1A";
 const types::uid_t UnitINA226_1A::uid{"UnitINA226_1A"_mmh3};
 const types::attr_t UnitINA226_1A::attr{attribute::AccessI2C};
 
+size_t UnitINA226::drainCurrent(float* out, const size_t len)
+{
+    return _data->consume(len, [out](const Data* p, const size_t n, const size_t offset) {
+        convertCurrent(out + offset, p, n);
+    });
+}
+
+void UnitINA226::convertShuntVoltage(float* out, const ina226::Data* in, const size_t len)
+{
+    for (size_t i = 0; i < len; ++i) {
+        out[i] = in[i].shuntVoltage();
+    }
+}
+
+void UnitINA226::convertVoltage(float* out, const ina226::Data* in, const size_t len)
+{
+    for (size_t i = 0; i < len; ++i) {
+        out[i] = in[i].voltage();
+    }
+}
+
+void UnitINA226::convertPower(float* out, const ina226::Data* in, const size_t len)
+{
+    for (size_t i = 0; i < len; ++i) {
+        out[i] = in[i].power();
+    }
+}
+
+void UnitINA226::convertCurrent(float* out, const ina226::Data* in, const size_t len)
+{
+    for (size_t i = 0; i < len; ++i) {
+        out[i] = in[i].current();
+    }
+}
+
 }  // namespace unit
 }  // namespace m5
@@ -10,8 +10,14 @@
 #ifndef M5_UNIT_METER_UNIT_INA226_HPP
 #define M5_UNIT_METER_UNIT_INA226_HPP
 
+#include "meter_schedule.hpp"
+#include "meter_timestamp.hpp"
+#include "meter_stats.hpp"
+#include "meter_ring_buffer.hpp"
+#include "meter_coroutine.hpp"
 #include <M5UnitComponent.hpp>
 #include <limits>  // NaN
+#include <functional>
 
 namespace m5 {
 namespace unit {
@@ -82,14 +88,14 @@ enum class Alert : int8_t {
   @struct Data
   @brief Measurement data group
  */
-struct Data {
+struct Data : meter::SampleTimestamp {
     std::array<uint16_t, 4> raw{};  //!< Raw data 0:Shunt 1:Bus 2:Power 3:Current
     float currentLSB{};             //!< currentLSB
 
     //@brirf Sunt voltage (mV)
     inline float shuntVoltage() const
     {
-        return raw[0] * 0.0025f;
+        return (int16_t)raw[0] * 0.0025f;
     }
     // @brief Bus voltage (mV)
     inline float voltage() const
@@ -108,6 +114,30 @@ struct Data {
     }
 };
 
+/*!
+  @struct Accumulation
+  @brief Integrated charge and energy of the periodic measurement
+  @details Accumulated as raw LSB x microseconds in 64-bit integers, so that no rounding error builds up
+ */
+struct Accumulation {
+    int64_t charge{};     //!< Sum of current raw x duration (currentLSB x us)
+    int64_t energy{};     //!< Sum of power raw x duration (25 x currentLSB x us)
+    uint64_t duration{};  //!< Integrated duration (us)
+    uint32_t samples{};   //!< Number of integrated samples
+    float currentLSB{};   //!< currentLSB
+
+    //! @brief Charge (mAh)
+    inline double mAh() const
+    {
+        return (double)charge * currentLSB / 3600000.0;  // A x us -> mAh
+    }
+    //! @brief Energy (Wh)
+    inline double Wh() const
+    {
+        return (double)energy * currentLSB * 25.0 / 3600000000.0;  // W x us -> Wh
+    }
+};
+
 }  // namespace ina226
 
 /*!
@@ -137,6 +167,8 @@ public:
         ina226::ConversionTime shunt_conversion_time{ina226::ConversionTime::US_1100};
         //! Bus conversion time
         ina226::ConversionTime bus_conversion_time{ina226::ConversionTime::US_1100};
+        //! Check the conversion ready flag before reading on periodic?
+        bool data_ready_check{true};
     };
 
 protected:
@@ -187,6 +219,119 @@ public:
     {
         return _currentLSB;
     }
+    //! @brief Periodic interval in microseconds
+    inline uint32_t intervalMicros() const
+    {
+        return _schedule.interval();
+    }
+    /*!
+      @brief Effective sample rate (Hz) of the periodic measurement
+      @return Measured rate since the periodic measurement started, or zero if not yet known
+    */
+    inline float effectiveSamplingRate() const
+    {
+        return _schedule.effectiveRate();
+    }
+    /*!
+      @brief Time the next update() accesses the bus
+      @param[out] at Time (us). Now if it waits for the conversion-ready notification
+      @return True if update() has something to do, false if idle
+      @note For the bus scheduler to order the units by the deadline
+    */
+    bool nextDue(uint32_t& at) const;
+    ///@}
+
+    ///@name Data ready check
+    ///@{
+    //! @brief Is the conversion ready flag checked before reading on periodic?
+    inline bool dataReadyCheck() const
+    {
+        return _cfg.data_ready_check;
+    }
+    /*!
+      @brief Enable/disable the conversion ready flag check on periodic
+      @details If disabled, update() reads only by the schedule of the conversion time and skips the Mask register
+      read, which also clears the flags as a side effect
+      @warning The measured values may be repeated if the conversion is slower than the calculated time
+     */
+    inline void setDataReadyCheck(const bool enable)
+    {
+        _cfg.data_ready_check = enable;
+    }
+    ///@}
+
+    ///@name Conversion ready
+    ///@{
+    /*!
+      @brief Enable or disable the conversion-ready (CNVR) alert mode
+      @details The Alert pin is asserted when each conversion completes.
+      While enabled, periodic update() reads the measurement only after onConversionReady() has been called,
+      instead of polling the conversion ready flag
+      @param enable Enable if true
+      @param activeHigh Alert pin is active high if true
+      @return True if successful
+      @note The other alert functions are disabled while enabled
+      @note The Alert pin is released by the Mask register read in update(), so that it can signal the next conversion
+     */
+    bool enableConversionReady(const bool enable, const bool activeHigh = false);
+    //! @brief In the conversion-ready mode?
+    inline bool inConversionReady() const
+    {
+        return _rdy_enabled;
+    }
+    /*!
+      @brief Notify that the Alert pin has been asserted
+      @details Only counts the edge, safe to call from ISR. The measurement is read in the next update()
+      @note It can also be called by a simulated alert line on the host
+     */
+    inline void onConversionReady()
+    {
+        _rdy.notify();
+    }
+    /*!
+      @brief Gets the number of conversions that were notified but not read
+      @details Counted when update() could not keep up with the notification
+    */
+    inline uint32_t conversionReadyOverruns() const
+    {
+        return _rdy.overruns();
+    }
+    ///@}
+
+    ///@name Accumulation
+    ///@{
+    /*!
+      @brief Gets the charge and energy integrated from every acquired sample
+      @note Integrated in update(), independent of the buffered data
+      @note Charge requires the current measurement and energy requires the power measurement
+     */
+    inline ina226::Accumulation accumulation() const
+    {
+        return _accumulation;
+    }
+    //! @brief Clear the accumulated charge and energy
+    inline void resetAccumulation()
+    {
+        _accumulation            = ina226::Accumulation{};
+        _accumulation.currentLSB = _currentLSB;
+    }
+    ///@}
+
+    ///@name Bus statistics
+    ///@{
+    /*!
+      @brief Register access counters and call latencies
+      @note Counted only if M5_UNIT_METER_BUS_STATS is non-zero, otherwise empty
+     */
+    inline const meter::UnitBusStats& busStats() const
+    {
+        return _bus_stats;
+    }
+    //! @brief Clear the bus statistics
+    inline void resetBusStats()
+    {
+        _bus_stats.reset();
+    }
     ///@}
 
     ///@name Measurement data by periodic
@@ -213,6 +358,51 @@ public:
     }
     ///@}
 
+    ///@name Bulk access to the measurement data
+    ///@{
+    /*!
+      @brief Take out the oldest data
+      @param[out] out Output buffer
+      @param len Up to the number of data
+      @return Number of data taken out
+     */
+    inline size_t drain(ina226::Data* out, const size_t len)
+    {
+        return _data->read(out, len);
+    }
+    /*!
+      @brief Stored data from the oldest as contiguous spans, without copying
+      @param[out] first Oldest part
+      @param[out] second Wrapped part, empty if not wrapped
+      @return Number of the data
+      @warning The spans are valid until the buffer is modified (update(), discard(), flush() etc.)
+     */
+    inline size_t spans(meter::Span<const ina226::Data>& first, meter::Span<const ina226::Data>& second) const
+    {
+        return _data->segments(first, second);
+    }
+    using PeriodicMeasurementAdapter<UnitINA226, ina226::Data>::discard;
+    /*!
+      @brief Discard the oldest data
+      @param n Up to the number of data
+      @return Number of discarded data
+     */
+    inline size_t discard(const size_t n)
+    {
+        return _data->pop_front(n);
+    }
+    //! @brief Take out the oldest currents (mA)
+    size_t drainCurrent(float* out, const size_t len);
+    //! @brief Convert the data to the shunt voltages (mV)
+    static void convertShuntVoltage(float* out, const ina226::Data* in, const size_t len);
+    //! @brief Convert the data to the bus voltages (mV)
+    static void convertVoltage(float* out, const ina226::Data* in, const size_t len);
+    //! @brief Convert the data to the powers (mW)
+    static void convertPower(float* out, const ina226::Data* in, const size_t len);
+    //! @brief Convert the data to the currents (mA)
+    static void convertCurrent(float* out, const ina226::Data* in, const size_t len);
+    ///@}
+
     ///@name Periodic measurement
     ///@{
     /*!
@@ -288,6 +478,85 @@ public:
 
     ///@}
 
+    ///@name Asynchronous single shot measurement
+    ///@{
+    /*!
+      @brief Callback on completion of the requested single shot
+      @param ok True if successful, false if failed or timed out
+      @param d Measured data (valid if ok)
+     */
+    using singleshot_callback_t = std::function<void(const bool ok, const ina226::Data& d)>;
+    /*!
+      @brief Request the single shot measurement without waiting
+      @details Trigger the conversion in the current settings and return.
+      The result is obtained by trySingleshotResult(), or notified by the callback from update()
+      @param current Measure current if true
+      @param voltage Measure bus voltage if true
+      @param power Measure power if true
+      @return True if successful
+      @warning During periodic detection runs or while the previous request is converting, an error is returned
+      @note It times out if not ready one second after the computed conversion time
+     */
+    bool requestSingleshot(const bool current = true, const bool voltage = true, const bool power = true);
+    /*!
+      @brief Request the single shot measurement without waiting
+      @param rate Sampling Sampling rate
+      @param sct Shunt conversion time
+      @param bct Bus conversion time
+      @param current Measure current if true
+      @param voltage Measure bus voltage if true
+      @param power Measure power if true
+      @return True if successful
+      @warning During periodic detection runs or while the previous request is converting, an error is returned
+     */
+    bool requestSingleshot(const ina226::Sampling rate, const ina226::ConversionTime sct,
+                           const ina226::ConversionTime bct, const bool current = true, const bool voltage = true,
+                           const bool power = true);
+    /*!
+      @brief Try to get the result of the requested single shot
+      @details The bus is not accessed until the conversion time computed from the settings has passed,
+      so that a task can drive several units in the triggered mode
+      @param[out] data Measured data
+      @return True if the result is obtained
+      @note If false, singleshotState() tells whether it is still converting or failed
+     */
+    bool trySingleshotResult(ina226::Data& data);
+    //! @brief State of the requested single shot
+    inline meter::SingleshotState singleshotState() const
+    {
+        return _singleshot.state();
+    }
+    //! @brief Set the callback on completion (nullptr to clear)
+    inline void setSingleshotCallback(singleshot_callback_t cb)
+    {
+        _singleshot_callback = cb;
+    }
+    ///@}
+
+#if M5_UNIT_METER_COROUTINE
+    ///@name Coroutine (C++20)
+    ///@{
+    /*!
+      @brief Awaitable single shot measurement
+      @details Same as measureSingleshot(), but the task sleeps until the computed conversion time instead of blocking
+      @param[out] data Measured data
+      @param current Measure current if true
+      @param voltage Measure bus voltage if true
+      @param power Measure power if true
+      @return Task resulting true if successful
+      @warning The data must outlive the task
+     */
+    meter::Task<bool> measureSingleshotAsync(ina226::Data& data, const bool current = true, const bool voltage = true,
+                                             const bool power = true);
+    /*!
+      @brief Awaitable software reset
+      @return Task resulting true if successful
+      @sa softReset
+     */
+    meter::Task<bool> softResetAsync();
+    ///@}
+#endif
+
     ///@name Settings
     ///@{
     /*!
@@ -402,6 +671,7 @@ public:
       @param all Rewrite calibration value if false
       @return True if successful
       @warning All register values are changed to their initial values
+      @note The conversion-ready mode is also left, since the reset clears Mask/Enable
      */
     bool softReset(const bool all = false);
 
@@ -420,14 +690,46 @@ protected:
 
     bool is_data_ready();
     bool read_measurement(ina226::Data& d);
+    void poll_singleshot(const uint32_t at, const bool notify = true);
+    // Shared by the blocking functions and the *Async() counterparts (now in us)
+    bool request_singleshot(const uint32_t now, const bool current, const bool voltage, const bool power);
+    meter::Progress singleshot_step(const uint32_t now, uint32_t& wait, ina226::Data& data);
+    bool start_soft_reset();
+    meter::Progress soft_reset_step(const uint32_t elapsed, uint32_t& wait);
+    void accumulate(const ina226::Data& d, const uint32_t at);
+
+    bool read_register16(const uint8_t reg, uint16_t& v);
+    bool write_register16(const uint8_t reg, const uint16_t v);
+
+    //! @brief Leave the conversion-ready mode (the chip no longer drives the pin by CNVR)
+    inline void clear_conversion_ready()
+    {
+        _rdy_enabled = false;
+        _rdy.reset();
+    }
 
     M5_UNIT_COMPONENT_PERIODIC_MEASUREMENT_ADAPTER_HPP_BUILDER(UnitINA226, ina226::Data);
 
 private:
-    std::unique_ptr<m5::container::CircularBuffer<ina226::Data>> _data{};
+    std::unique_ptr<meter::RingBuffer<ina226::Data>> _data{};
     config_t _cfg{};
     float _shuntRes{}, _maxCurrentA{}, _currentLSB{};
     uint8_t _measureBits{};  // LSB 0:Shunt 1:Bus 2:Power 3:Current MSB
+    meter::Schedule _schedule{};
+
+    meter::ReadyNotifier _rdy{};
+    bool _rdy_enabled{};
+
+    ina226::Accumulation _accumulation{};
+    uint32_t _acc_at{};  // Time of the last integrated sample (us)
+    bool _acc_continued{};
+
+    // Asynchronous single shot
+    meter::SingleshotRequest _singleshot{};
+    ina226::Data _singleshot_data{};
+    singleshot_callback_t _singleshot_callback{};
+
+    meter::UnitBusStats _bus_stats{};
 };
 
 /*!
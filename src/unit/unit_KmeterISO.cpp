@@ -28,6 +28,9 @@ constexpr uint8_t reg_internal_temperature_table[] = {
     INTERNAL_TEMPERATURE_FAHRENHEIT_REG,
 };
 
+// Status poll interval while the firmware is busy on periodic measurement (same as the single shot)
+constexpr uint32_t STATUS_POLL_INTERVAL_US{1000};
+
 }  // namespace
 
 namespace m5 {
@@ -39,10 +42,12 @@ const types::attr_t UnitKmeterISO::attr{attribute::AccessI2C};
 
 bool UnitKmeterISO::begin()
 {
+    auto scope = _bus_stats.scope(meter::Call::Begin);
+
     auto ssize = stored_size();
     assert(ssize && "stored_size must be greater than zero");
     if (ssize != _data->capacity()) {
-        _data.reset(new m5::container::CircularBuffer<Data>(ssize));
+        _data.reset(new meter::RingBuffer<Data>(ssize));
         if (!_data) {
             M5_LIB_LOGE("Failed to allocate");
             return false;
@@ -61,18 +66,36 @@ void UnitKmeterISO::update(const bool force)
 {
     _updated = false;
     if (inPeriodic()) {
-        elapsed_time_t at{m5::utility::millis()};
-        if (force || !_latest || at >= _latest + _interval) {
+        const uint32_t at{(uint32_t)m5::utility::micros()};
+        if (force || _schedule.due(at)) {
+            auto scope = _bus_stats.scope(meter::Call::Update);
             Data d{};
-            _updated = is_data_ready() && read_measurement(d, _munit);
+            const bool ready{is_data_ready()};
+            _updated = ready && read_measurement(d, _munit);
+            if (!ready) {
+                _bus_stats.poll();
+                // Poll the status again later rather than on every update while the firmware is busy
+                _schedule.retry(at, STATUS_POLL_INTERVAL_US);
+            }
             if (_updated) {
                 _latest = m5::utility::millis();
+                _schedule.advance(at);
+                d.stamp(at);
                 _data->push_back(d);
             }
         }
     }
 }
 
+bool UnitKmeterISO::nextDue(uint32_t& at) const
+{
+    if (!inPeriodic()) {
+        return false;
+    }
+    at = _schedule.next((uint32_t)m5::utility::micros());
+    return true;
+}
+
 bool UnitKmeterISO::start_periodic_measurement()
 {
     if (inPeriodic()) {
@@ -81,14 +104,21 @@ bool UnitKmeterISO::start_periodic_measurement()
     }
     _periodic = true;
     _latest   = 0;
+    _schedule.reset();
+    _schedule.interval(meter::millisToMicros(_interval));
     return true;
 }
 
 bool UnitKmeterISO::start_periodic_measurement(const uint32_t interval, const MeasurementUnit munit)
 {
+    if (interval > meter::MAX_SPAN_MILLIS) {
+        M5_LIB_LOGE("Interval too long %u (up to %u)", interval, meter::MAX_SPAN_MILLIS);
+        return false;
+    }
     if (start_periodic_measurement()) {
         _interval = interval;
         _munit    = munit;
+        _schedule.interval(meter::millisToMicros(interval));
         return true;
     }
     return false;
@@ -103,55 +133,66 @@ bool UnitKmeterISO::stop_periodic_measurement()
 bool UnitKmeterISO::readStatus(uint8_t& status)
 {
     status = 0xFF;
-    return readRegister8(STATUS_REG, status, 0);
+    return read_register8(STATUS_REG, status);
 }
 
 bool UnitKmeterISO::readFirmwareVersion(uint8_t& ver)
 {
-    return readRegister8(FIRMWARE_VERSION_REG, ver, 0);
+    return read_register8(FIRMWARE_VERSION_REG, ver);
 }
 
 bool UnitKmeterISO::measureSingleshot(kmeter_iso::Data& d, const kmeter_iso::MeasurementUnit munit,
                                       const uint32_t timeoutMs)
 {
-    if (inPeriodic()) {
-        M5_LIB_LOGD("Periodic measurements are running");
-        return false;
-    }
-
-    auto timeout_at = m5::utility::millis() + timeoutMs;
-    do {
-        if (is_data_ready()) {
-            return read_measurement(d, munit);
-        }
-        m5::utility::delay(1);
-    } while (m5::utility::millis() <= timeout_at);
-
-    M5_LIB_LOGW("Failed due to timeout");
-    return false;
+    auto scope = _bus_stats.scope(meter::Call::Singleshot);
+    auto step  = [this, timeoutMs](const uint32_t, const uint32_t elapsed, uint32_t& wait) {
+        return data_ready_step(elapsed, wait, timeoutMs);
+    };
+    return can_singleshot() && meter::pollUntilDone(step) && read_measurement(d, munit);
 }
 
 bool UnitKmeterISO::measureInternalSingleshot(kmeter_iso::Data& d, const kmeter_iso::MeasurementUnit munit,
                                               const uint32_t timeoutMs)
+{
+    auto scope = _bus_stats.scope(meter::Call::Singleshot);
+    auto step  = [this, timeoutMs](const uint32_t, const uint32_t elapsed, uint32_t& wait) {
+        return data_ready_step(elapsed, wait, timeoutMs);
+    };
+    return can_singleshot() && meter::pollUntilDone(step) && read_internal_measurement(d, munit);
+}
+
+bool UnitKmeterISO::changeI2CAddress(const uint8_t i2c_address)
+{
+    auto step = [this, i2c_address](const uint32_t, const uint32_t elapsed, uint32_t& wait) {
+        return address_changed_step(elapsed, wait, i2c_address);
+    };
+    return start_change_address(i2c_address) && meter::pollUntilDone(step);
+}
+
+bool UnitKmeterISO::can_singleshot() const
 {
     if (inPeriodic()) {
         M5_LIB_LOGD("Periodic measurements are running");
         return false;
     }
+    return true;
+}
 
-    auto timeout_at = m5::utility::millis() + timeoutMs;
-    do {
-        if (is_data_ready()) {
-            return read_internal_measurement(d, munit);
-        }
-        m5::utility::delay(1);
-    } while (m5::utility::millis() <= timeout_at);
-
-    M5_LIB_LOGW("Failed due to timeout");
-    return false;
+meter::Progress UnitKmeterISO::data_ready_step(const uint32_t elapsed, uint32_t& wait, const uint32_t timeoutMs)
+{
+    _bus_stats.poll();
+    if (is_data_ready()) {
+        return meter::Progress::Completed;
+    }
+    if (elapsed > meter::millisToMicros(timeoutMs)) {
+        M5_LIB_LOGW("Failed due to timeout");
+        return meter::Progress::Failed;
+    }
+    wait = STATUS_POLL_INTERVAL_US;
+    return meter::Progress::Pending;
 }
 
-bool UnitKmeterISO::changeI2CAddress(const uint8_t i2c_address)
+bool UnitKmeterISO::start_change_address(const uint8_t i2c_address)
 {
     if (inPeriodic()) {
         M5_LIB_LOGD("Periodic measurements are running");
@@ -162,34 +203,110 @@ bool UnitKmeterISO::changeI2CAddress(const uint8_t i2c_address)
         M5_LIB_LOGE("Invalid address : %02X", i2c_address);
         return false;
     }
-    if (writeRegister8(I2C_ADDRESS_REG, i2c_address) && changeAddress(i2c_address)) {
-        // Wait wakeup
-        uint8_t v{};
-        bool done{};
-        auto timeout_at = m5::utility::millis() + 1000;
-        do {
-            m5::utility::delay(1);
-            done = readRegister8(I2C_ADDRESS_REG, v, 0) && v == i2c_address;
-        } while (!done && m5::utility::millis() <= timeout_at);
-        return done;
+    return write_register8(I2C_ADDRESS_REG, i2c_address) && changeAddress(i2c_address);
+}
+
+meter::Progress UnitKmeterISO::address_changed_step(const uint32_t elapsed, uint32_t& wait, const uint8_t i2c_address)
+{
+    // Wait wakeup, the first read is after one interval
+    uint8_t v{};
+    _bus_stats.poll();
+    if (elapsed && read_register8(I2C_ADDRESS_REG, v) && v == i2c_address) {
+        return meter::Progress::Completed;
+    }
+    if (elapsed > 1000 * 1000U) {
+        return meter::Progress::Failed;
     }
-    return false;
+    wait = 1000;
+    return meter::Progress::Pending;
+}
+
+#if M5_UNIT_METER_COROUTINE
+meter::Task<bool> UnitKmeterISO::measureSingleshotAsync(kmeter_iso::Data& d, const kmeter_iso::MeasurementUnit munit,
+                                                        const uint32_t timeoutMs)
+{
+    auto step = [this, timeoutMs](const uint32_t, const uint32_t elapsed, uint32_t& wait) {
+        return data_ready_step(elapsed, wait, timeoutMs);
+    };
+    if (!can_singleshot() || !co_await meter::pollUntilDoneAsync(step)) {
+        co_return false;
+    }
+    co_return read_measurement(d, munit);
+}
+
+meter::Task<bool> UnitKmeterISO::measureInternalSingleshotAsync(kmeter_iso::Data& d,
+                                                                const kmeter_iso::MeasurementUnit munit,
+                                                                const uint32_t timeoutMs)
+{
+    auto step = [this, timeoutMs](const uint32_t, const uint32_t elapsed, uint32_t& wait) {
+        return data_ready_step(elapsed, wait, timeoutMs);
+    };
+    if (!can_singleshot() || !co_await meter::pollUntilDoneAsync(step)) {
+        co_return false;
+    }
+    co_return read_internal_measurement(d, munit);
+}
+
+meter::Task<bool> UnitKmeterISO::changeI2CAddressAsync(const uint8_t i2c_address)
+{
+    auto step = [this, i2c_address](const uint32_t, const uint32_t elapsed, uint32_t& wait) {
+        return address_changed_step(elapsed, wait, i2c_address);
+    };
+    if (!start_change_address(i2c_address)) {
+        co_return false;
+    }
+    co_return co_await meter::pollUntilDoneAsync(step);
 }
+#endif
 
 bool UnitKmeterISO::readI2CAddress(uint8_t& i2c_address)
 {
-    return readRegister8(I2C_ADDRESS_REG, i2c_address, 1);
+    return read_register8(I2C_ADDRESS_REG, i2c_address, 1);
 }
 
 //
 bool UnitKmeterISO::read_measurement(Data& d, const kmeter_iso::MeasurementUnit munit)
 {
-    return readRegister(reg_temperature_table[m5::stl::to_underlying(munit)], d.raw.data(), d.raw.size(), 0);
+    return read_register(reg_temperature_table[m5::stl::to_underlying(munit)], d.raw.data(), d.raw.size());
 }
 
 bool UnitKmeterISO::read_internal_measurement(Data& d, const kmeter_iso::MeasurementUnit munit)
 {
-    return readRegister(reg_internal_temperature_table[m5::stl::to_underlying(munit)], d.raw.data(), d.raw.size(), 0);
+    return read_register(reg_internal_temperature_table[m5::stl::to_underlying(munit)], d.raw.data(), d.raw.size());
+}
+
+bool UnitKmeterISO::read_register(const uint8_t reg, uint8_t* rbuf, const uint32_t len, const uint32_t delayMs)
+{
+    const uint32_t at{_bus_stats.mark()};
+    const bool ok{readRegister(reg, rbuf, len, delayMs)};
+    _bus_stats.read(reg, len, ok, at);
+    return ok;
+}
+
+bool UnitKmeterISO::write_register8(const uint8_t reg, const uint8_t v)
+{
+    const uint32_t at{_bus_stats.mark()};
+    const bool ok{writeRegister8(reg, v)};
+    _bus_stats.write(reg, 1, ok, at);
+    return ok;
+}
+
+size_t UnitKmeterISO::drainTemperature(float* out, const size_t len)
+{
+    return _data->consume(len, [out](const Data* p, const size_t n, const size_t offset) {
+        convertTemperature(out + offset, p, n);
+    });
+}
+
+void UnitKmeterISO::convertTemperature(float* out, const kmeter_iso::Data* in, const size_t len)
+{
+    // Unpack the little-endian 32-bit values without branches
+    for (size_t i = 0; i < len; ++i) {
+        const auto& r = in[i].raw;
+        out[i] = static_cast<int32_t>(((uint32_t)r[3] << 24) | ((uint32_t)r[2] << 16) | ((uint32_t)r[1] << 8) |
+                                      ((uint32_t)r[0] << 0)) *
+                 0.01f;
+    }
 }
 
 }  // namespace unit
@@ -10,8 +10,12 @@
 #ifndef M5_UNIT_METER_UNIT_KMETERISO_HPP
 #define M5_UNIT_METER_UNIT_KMETERISO_HPP
 
+#include "meter_schedule.hpp"
+#include "meter_timestamp.hpp"
+#include "meter_stats.hpp"
+#include "meter_ring_buffer.hpp"
+#include "meter_coroutine.hpp"
 #include <M5UnitComponent.hpp>
-#include <m5_utility/container/circular_buffer.hpp>
 #include <limits>  // NaN
 #include <array>
 
@@ -33,7 +37,7 @@ enum class MeasurementUnit : uint8_t {
   @struct Data
   @brief Measurement data group
  */
-struct Data {
+struct Data : meter::SampleTimestamp {
     std::array<uint8_t, 4> raw{};  //!< Raw data
 
     //@note Unit depends on setting
@@ -68,7 +72,7 @@ public:
     };
 
     explicit UnitKmeterISO(const uint8_t addr = DEFAULT_ADDRESS)
-        : Component(addr), _data{new m5::container::CircularBuffer<kmeter_iso::Data>(1)}
+        : Component(addr), _data{new meter::RingBuffer<kmeter_iso::Data>(1)}
     {
         auto ccfg  = component_config();
         ccfg.clock = 100 * 1000U;
@@ -107,6 +111,26 @@ public:
     {
         _munit = munit;
     }
+    //! @brief Periodic interval in microseconds
+    inline uint32_t intervalMicros() const
+    {
+        return _schedule.interval();
+    }
+    /*!
+      @brief Effective sample rate (Hz) of the periodic measurement
+      @return Measured rate since the periodic measurement started, or zero if not yet known
+    */
+    inline float effectiveSamplingRate() const
+    {
+        return _schedule.effectiveRate();
+    }
+    /*!
+      @brief Time the next update() accesses the bus
+      @param[out] at Time (us)
+      @return True if update() has something to do, false if idle
+      @note For the bus scheduler to order the units by the deadline
+    */
+    bool nextDue(uint32_t& at) const;
     ///@}
 
     ///@name Measurement data by periodic
@@ -118,6 +142,45 @@ public:
     }
     ///@}
 
+    ///@name Bulk access to the measurement data
+    ///@{
+    /*!
+      @brief Take out the oldest data
+      @param[out] out Output buffer
+      @param len Up to the number of data
+      @return Number of data taken out
+     */
+    inline size_t drain(kmeter_iso::Data* out, const size_t len)
+    {
+        return _data->read(out, len);
+    }
+    /*!
+      @brief Stored data from the oldest as contiguous spans, without copying
+      @param[out] first Oldest part
+      @param[out] second Wrapped part, empty if not wrapped
+      @return Number of the data
+      @warning The spans are valid until the buffer is modified (update(), discard(), flush() etc.)
+     */
+    inline size_t spans(meter::Span<const kmeter_iso::Data>& first, meter::Span<const kmeter_iso::Data>& second) const
+    {
+        return _data->segments(first, second);
+    }
+    using PeriodicMeasurementAdapter<UnitKmeterISO, kmeter_iso::Data>::discard;
+    /*!
+      @brief Discard the oldest data
+      @param n Up to the number of data
+      @return Number of discarded data
+     */
+    inline size_t discard(const size_t n)
+    {
+        return _data->pop_front(n);
+    }
+    //! @brief Take out the oldest temperatures
+    size_t drainTemperature(float* out, const size_t len);
+    //! @brief Convert the data to the temperatures
+    static void convertTemperature(float* out, const kmeter_iso::Data* in, const size_t len);
+    ///@}
+
     ///@name Periodic measurement
     ///@{
     /*!
@@ -130,7 +193,7 @@ public:
     }
     /*!
       @brief Start periodic measurement
-      @param interval Periodic interval(ms)
+      @param interval Periodic interval(ms), up to meter::MAX_SPAN_MILLIS
       @param munit Measurement unit
       @return True if successful
     */
@@ -207,7 +270,48 @@ public:
     bool readI2CAddress(uint8_t& i2c_address);
     ///@}
 
+#if M5_UNIT_METER_COROUTINE
+    ///@name Coroutine (C++20)
+    ///@warning The data must outlive the task
+    ///@{
+    //! @brief Awaitable measureSingleshot(), the task sleeps between the status polls
+    meter::Task<bool> measureSingleshotAsync(
+        kmeter_iso::Data& d, const kmeter_iso::MeasurementUnit munit = kmeter_iso::MeasurementUnit::Celsius,
+        const uint32_t timeoutMs = 100);
+    //! @brief Awaitable measureInternalSingleshot(), the task sleeps between the status polls
+    meter::Task<bool> measureInternalSingleshotAsync(
+        kmeter_iso::Data& d, const kmeter_iso::MeasurementUnit munit = kmeter_iso::MeasurementUnit::Celsius,
+        const uint32_t timeoutMs = 100);
+    //! @brief Awaitable changeI2CAddress(), the task sleeps while the unit restarts
+    meter::Task<bool> changeI2CAddressAsync(const uint8_t i2c_address);
+    ///@}
+#endif
+
+    ///@name Bus statistics
+    ///@{
+    /*!
+      @brief Register access counters and call latencies
+      @note Counted only if M5_UNIT_METER_BUS_STATS is non-zero, otherwise empty
+     */
+    inline const meter::UnitBusStats& busStats() const
+    {
+        return _bus_stats;
+    }
+    //! @brief Clear the bus statistics
+    inline void resetBusStats()
+    {
+        _bus_stats.reset();
+    }
+    ///@}
+
 protected:
+    bool read_register(const uint8_t reg, uint8_t* rbuf, const uint32_t len, const uint32_t delayMs = 0);
+    inline bool read_register8(const uint8_t reg, uint8_t& v, const uint32_t delayMs = 0)
+    {
+        return read_register(reg, &v, 1, delayMs);
+    }
+    bool write_register8(const uint8_t reg, const uint8_t v);
+
     bool start_periodic_measurement();
     bool start_periodic_measurement(const uint32_t interval, const kmeter_iso::MeasurementUnit munit);
     bool stop_periodic_measurement();
@@ -220,12 +324,21 @@ protected:
         uint8_t s{};
         return readStatus(s) && (s == 0U);
     }
+
+    // Shared by the blocking functions and the *Async() counterparts (elapsed in us)
+    bool can_singleshot() const;
+    meter::Progress data_ready_step(const uint32_t elapsed, uint32_t& wait, const uint32_t timeoutMs);
+    bool start_change_address(const uint8_t i2c_address);
+    meter::Progress address_changed_step(const uint32_t elapsed, uint32_t& wait, const uint8_t i2c_address);
+
     M5_UNIT_COMPONENT_PERIODIC_MEASUREMENT_ADAPTER_HPP_BUILDER(UnitKmeterISO, kmeter_iso::Data);
 
 protected:
-    std::unique_ptr<m5::container::CircularBuffer<kmeter_iso::Data>> _data{};
+    std::unique_ptr<meter::RingBuffer<kmeter_iso::Data>> _data{};
     kmeter_iso::MeasurementUnit _munit{kmeter_iso::MeasurementUnit::Celsius};
     config_t _cfg{};
+    meter::Schedule _schedule{};
+    meter::UnitBusStats _bus_stats{};
 };
 
 namespace kmeter_iso {
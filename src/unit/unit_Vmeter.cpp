@@ -21,11 +21,5 @@ const char UnitVmeter::name[] = "UnitVmeter";
 const types::uid_t UnitVmeter::uid{"UnitVmeter"_mmh3};
 const types::attr_t UnitVmeter::attr{attribute::AccessI2C};
 
-void UnitVmeter::apply_coefficient(const ads111x::Gain gain)
-{
-    UnitADS111x::apply_coefficient(gain);
-    _correction = resolution() * _eeprom.calibrationFactor(gain);
-}
-
 }  // namespace unit
 }  // namespace m5
@@ -35,29 +35,25 @@ public:
     {
     }
 
-    //! @brief Resolution of 1 LSB
-    inline float resolution() const
-    {
-        return coefficient() / PRESSURE_COEFFICIENT;
-    }
-
-    //! @brief Gets the correction value
-    inline float correction() const
-    {
-        return _correction;
-    }
-
     //! @brief Oldest voltage (mV)
     inline float voltage() const
     {
         return !empty() ? correction() * adc() : std::numeric_limits<float>::quiet_NaN();
     }
+    /*!
+      @brief Oldest voltage (uV) by the fixed-point conversion
+      @return Value, or std::numeric_limits<int32_t>::min() if empty
+     */
+    inline int32_t voltageMicro() const
+    {
+        return !empty() ? toMicro(adc()) : std::numeric_limits<int32_t>::min();
+    }
 
 protected:
-    virtual void apply_coefficient(const ads111x::Gain gain) override;
-
-private:
-    float _correction{1.0f};
+    virtual float pressure_coefficient() const override
+    {
+        return PRESSURE_COEFFICIENT;
+    }
 };
 }  // namespace unit
 }  // namespace m5
@@ -37,21 +37,136 @@ bool UnitAVmeterBase::begin()
         M5_LIB_LOGE("Child unit is invalid %x", _eeprom.address());
         return false;
     }
+    if (!load_calibration()) {
+        return false;
+    }
+    // Calibration will be applied with the coefficient
+    return UnitADS111x::begin();
+}
+
+void UnitAVmeterBase::setCalibrationCache(meter::CalibrationCache* cache, const uint8_t bus)
+{
+    _cache     = cache;
+    _cache_bus = bus;
+}
+
+bool UnitAVmeterBase::verifyCalibration()
+{
+    meter::CalibrationRecord applied{};
+    _eeprom.exportCalibration(applied);
     if (!_eeprom.readCalibration()) {
+        M5_LIB_LOGW("Failed to verify the calibration");
+        _eeprom.importCalibration(applied);
         return false;
     }
-    apply_calibration(_ads_cfg.pga());
+    _from_cache = false;
+    if (_eeprom.calibrationHash() != applied.hash) {
+        M5_LIB_LOGW("Calibration has been changed");
+        store_calibration();
+        build_scale_table();
+        apply_coefficient(_ads_cfg.pga());
+    }
+    return true;
+}
 
-    return UnitADS111x::begin();
+bool UnitAVmeterBase::load_calibration()
+{
+    _from_cache = false;
+
+    if (_cache) {
+        char key[meter::CalibrationCache::KEY_SIZE]{};
+        meter::CalibrationCache::makeKey(key, _cache_bus, _eeprom.address());
+        meter::CalibrationRecord rec{};
+        if (_cache->read(key, rec) && rec.valid == 0xFF) {
+            M5_LIB_LOGD("Calibration from the cache %s", key);
+            _eeprom.importCalibration(rec);
+            _from_cache = true;
+            build_scale_table();
+            return true;
+        }
+    }
+    if (!_eeprom.readCalibration()) {
+        return false;
+    }
+    store_calibration();  // The unit works without the cache
+    build_scale_table();
+    return true;
+}
+
+bool UnitAVmeterBase::store_calibration()
+{
+    if (!_cache) {
+        return false;
+    }
+    char key[meter::CalibrationCache::KEY_SIZE]{};
+    meter::CalibrationCache::makeKey(key, _cache_bus, _eeprom.address());
+    meter::CalibrationRecord rec{};
+    _eeprom.exportCalibration(rec);
+    if (!_cache->write(key, rec)) {
+        M5_LIB_LOGW("Failed to store the calibration %s", key);
+        return false;
+    }
+    return true;
+}
+
+void UnitAVmeterBase::toMicro(int32_t* out, const ads111x::Data* data, const size_t len) const
+{
+    const int32_t s = _scale;
+    for (size_t i = 0; i < len; ++i) {
+        out[i] = meter::applyScale(data[i].adc(), s);
+    }
+}
+
+void UnitAVmeterBase::toMilli(float* out, const ads111x::Data* data, const size_t len) const
+{
+    const int32_t s = _scale;
+    for (size_t i = 0; i < len; ++i) {
+        out[i] = meter::applyScale(data[i].adc(), s) * 0.001f;
+    }
+}
+
+size_t UnitAVmeterBase::drain(float* out, const size_t len)
+{
+    return _data->consume(len, [this, out](const Data* p, const size_t n, const size_t offset) {
+        convert(out + offset, p, n);
+    });
+}
+
+size_t UnitAVmeterBase::drainMicro(int32_t* out, const size_t len)
+{
+    return _data->consume(len, [this, out](const Data* p, const size_t n, const size_t offset) {
+        toMicro(out + offset, p, n);
+    });
 }
 
-bool UnitAVmeterBase::writeGain(const ads111x::Gain gain)
+void UnitAVmeterBase::convert(float* out, const ads111x::Data* in, const size_t len) const
 {
-    if (UnitADS1115::writeGain(gain)) {
-        apply_calibration(gain);
-        return true;
+    const float c = _correction;
+    for (size_t i = 0; i < len; ++i) {
+        out[i] = c * in[i].adc();
     }
-    return false;
+}
+
+float UnitAVmeterBase::correction_of(const ads111x::Gain gain) const
+{
+    // mA(mV) per LSB = mV per LSB / pressure coefficient * calibration
+    return coefficientOf(gain) / pressure_coefficient() * _eeprom.calibrationFactor(gain);
+}
+
+void UnitAVmeterBase::build_scale_table()
+{
+    // uA(uV) per LSB
+    for (uint8_t i = 0; i < _scale_table.size(); ++i) {
+        _scale_table[i] = meter::makeScale(correction_of(static_cast<Gain>(i)) * 1000.0f);
+    }
+}
+
+void UnitAVmeterBase::apply_coefficient(const ads111x::Gain gain)
+{
+    apply_calibration(gain);
+    _correction = correction_of(gain);
+    _scale      = scale(gain);
+    UnitADS1115::apply_coefficient(gain);
 }
 
 std::shared_ptr<Adapter> UnitAVmeterBase::ensure_adapter(const uint8_t ch)
@@ -69,6 +184,11 @@ std::shared_ptr<Adapter> UnitAVmeterBase::ensure_adapter(const uint8_t ch)
     return ad ? std::shared_ptr<Adapter>(ad->duplicate(unit->address())) : std::make_shared<Adapter>();
 }
 
+void UnitAVmeterBase::assign_eeprom_adapter(std::shared_ptr<Adapter> adapter)
+{
+    _eeprom._adapter = adapter ? adapter : std::make_shared<Adapter>();
+}
+
 void UnitAVmeterBase::apply_calibration(const Gain gain)
 {
     _calibrationFactor = _eeprom.calibrationFactor(gain);
@@ -12,6 +12,8 @@
 
 #include "unit_ADS1115.hpp"
 #include "unit_EEPROM.hpp"
+#include "meter_fixed_point.hpp"
+#include <array>
 
 namespace m5 {
 namespace unit {
@@ -35,22 +37,129 @@ public:
     {
         return _calibrationFactor;
     }
+    //! @brief Resolution of 1 LSB without the calibration (milli-unit)
+    inline float resolution() const
+    {
+        return coefficient() / pressure_coefficient();
+    }
+    //! @brief Gets the correction value (milli-unit per LSB of the current gain, with the calibration)
+    inline float correction() const
+    {
+        return _correction;
+    }
 
-    virtual bool writeGain(const ads111x::Gain gain) override;
+    ///@name Fixed-point conversion
+    ///@{
+    /*!
+      @brief Scale of the current gain
+      @return Micro-unit (uA on Ameter, uV on Vmeter) per LSB as Q16.16, including the calibration
+      @note Built for every gain when the calibration is read, and selected when the gain changes
+     */
+    inline int32_t scale() const
+    {
+        return _scale;
+    }
+    //! @brief Scale of the gain
+    inline int32_t scale(const ads111x::Gain gain) const
+    {
+        return _scale_table[m5::stl::to_underlying(gain) & 0x07];
+    }
+    //! @brief Convert the raw value to the micro-unit by the current gain without the FPU
+    inline int32_t toMicro(const int16_t adc) const
+    {
+        return meter::applyScale(adc, _scale);
+    }
+    //! @brief Convert the raw values to the micro-unit by the current gain without the FPU
+    inline void toMicro(int32_t* out, const int16_t* adc, const size_t len) const
+    {
+        meter::applyScale(out, adc, len, _scale);
+    }
+    //! @brief Convert the data to the micro-unit by the current gain without the FPU
+    void toMicro(int32_t* out, const ads111x::Data* data, const size_t len) const;
+    //! @brief Convert the data to the milli-unit (mA on Ameter, mV on Vmeter) in float
+    void toMilli(float* out, const ads111x::Data* data, const size_t len) const;
+    ///@}
+
+    ///@name Bulk access to the measurement data
+    ///@{
+    using UnitADS111x::drain;
+    /*!
+      @brief Take out the oldest values in the milli-unit (mA on Ameter, mV on Vmeter)
+      @param[out] out Output buffer
+      @param len Up to the number of values
+      @return Number of values taken out
+      @note Same values as current() / voltage()
+     */
+    size_t drain(float* out, const size_t len);
+    //! @brief Take out the oldest values in the micro-unit without the FPU
+    size_t drainMicro(int32_t* out, const size_t len);
+    //! @brief Convert the data to the milli-unit, same as current() / voltage()
+    void convert(float* out, const ads111x::Data* in, const size_t len) const;
+    ///@}
+
+    ///@name Calibration cache
+    ///@{
+    /*!
+      @brief Set the calibration cache
+      @details If the cache has the calibration of the unit, begin() applies it without reading the EEPROM.
+      Otherwise begin() reads the EEPROM and stores the calibration to the cache
+      @param cache Cache (nullptr to disable), it must outlive the unit
+      @param bus Identifier of the bus (e.g. the port number), the key is made with it and the EEPROM address
+      @note Call before begin()
+      @note The cached calibration is not verified automatically. Call verifyCalibration() when the application can
+      afford it (See also calibrationFromCache())
+     */
+    void setCalibrationCache(meter::CalibrationCache* cache, const uint8_t bus = 0);
+    /*!
+      @brief Verify the applied calibration against the EEPROM
+      @details Reads the EEPROM, and if its content differs from the applied one, applies it and updates the cache
+      @return True if the EEPROM has been read and the calibration is valid
+      @note If failed, the applied calibration is kept
+      @warning Blocking read of the whole calibration (48 bytes) from the EEPROM.
+      Call it outside the time-critical loop, e.g. after begin() or in an idle slot
+     */
+    bool verifyCalibration();
+    //! @brief Is the applied calibration from the cache and not yet verified?
+    inline bool calibrationFromCache() const
+    {
+        return _from_cache;
+    }
+    ///@}
 
 protected:
     std::shared_ptr<Adapter> ensure_adapter(const uint8_t ch);
+    // Assign the adapter of the EEPROM child directly (UnitUnified assigns it with ensure_adapter on add)
+    void assign_eeprom_adapter(std::shared_ptr<Adapter> adapter);
+    // Calibration factor is applied before the coefficient
+    virtual void apply_coefficient(const ads111x::Gain gain) override;
     void apply_calibration(const ads111x::Gain gain);
     bool validChild() const
     {
         return _valid;
     }
+    bool load_calibration();
+    bool store_calibration();
+    // Pressure coefficient of the front end (mV at ADC per output milli-unit)
+    virtual float pressure_coefficient() const
+    {
+        return 1.0f;
+    }
+    // Correction of the gain (milli-unit per LSB), the single definition for correction(), convert() and the scale
+    float correction_of(const ads111x::Gain gain) const;
+    void build_scale_table();
 
 protected:
     m5::unit::meter::UnitEEPROM _eeprom{};
 
+    meter::CalibrationCache* _cache{};
+    uint8_t _cache_bus{};
+    bool _from_cache{};
+
 private:
     float _calibrationFactor{1.0f};
+    float _correction{1.0f};  // Current gain
+    std::array<int32_t, 8> _scale_table{};  // Per gain
+    int32_t _scale{};                       // Current gain
     bool _valid{};  // Did the constructor correctly add the child unit?
 };
 
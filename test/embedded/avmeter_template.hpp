@@ -267,10 +267,78 @@ TEST_P(TestADS1115, Configration)
     }
 }
 
+TEST_P(TestADS1115, ShadowRegister)
+{
+    SCOPED_TRACE(ustr);
+
+    EXPECT_TRUE(unit->stopPeriodicMeasurement());
+    EXPECT_FALSE(unit->isConfigDirty());
+
+    bool match{};
+    EXPECT_TRUE(unit->writeMultiplexer(Mux::GND_2));
+    EXPECT_TRUE(unit->writeGain(Gain::PGA_1024));
+    EXPECT_TRUE(unit->writeSamplingRate(Sampling::Rate250));
+    EXPECT_TRUE(unit->verifyConfig(match));
+    EXPECT_TRUE(match);
+
+    // Rewrite behind the shadow
+    uint16_t v{};
+    EXPECT_TRUE(unit->readRegister16BE(command::CONFIG_REG, v, 0));
+    Config c{};
+    c.value = v;
+    c.os(false);
+    c.mux(Mux::AIN_13);
+    c.pga(Gain::PGA_4096);
+    EXPECT_TRUE(unit->writeRegister16BE(command::CONFIG_REG, c.value));
+
+    EXPECT_TRUE(unit->verifyConfig(match));
+    EXPECT_FALSE(match);
+    EXPECT_EQ(unit->multiplexer(), Mux::AIN_13);
+    EXPECT_EQ(unit->gain(), Gain::PGA_4096);
+    EXPECT_EQ(unit->samplingRate(), Sampling::Rate250);
+
+    EXPECT_TRUE(unit->verifyConfig(match));
+    EXPECT_TRUE(match);
+
+    EXPECT_TRUE(unit->resyncConfig());
+    EXPECT_FALSE(unit->isConfigDirty());
+    EXPECT_EQ(unit->multiplexer(), Mux::AIN_13);
+}
+
+TEST_P(TestADS1115, ConfigTransaction)
+{
+    SCOPED_TRACE(ustr);
+
+    EXPECT_TRUE(unit->stopPeriodicMeasurement());
+
+    auto c = unit->configRegister();
+    c.dr(Sampling::Rate475).mux(Mux::GND_1).pga(Gain::PGA_512).comp_que(ComparatorQueue::Two);
+    EXPECT_TRUE(unit->writeConfigRegister(c));
+
+    EXPECT_EQ(unit->samplingRate(), Sampling::Rate475);
+    EXPECT_EQ(unit->multiplexer(), Mux::GND_1);
+    EXPECT_EQ(unit->gain(), Gain::PGA_512);
+    EXPECT_EQ(unit->comparatorQueue(), ComparatorQueue::Two);
+
+    uint16_t v{};
+    EXPECT_TRUE(unit->readRegister16BE(command::CONFIG_REG, v, 0));
+    EXPECT_EQ(v & 0x7FFF, c.value & 0x7FFF);
+
+    EXPECT_TRUE(unit->startPeriodicMeasurement(Sampling::Rate860, Mux::AIN_01, Gain::PGA_2048, ComparatorQueue::Disable));
+    EXPECT_TRUE(unit->inPeriodic());
+    EXPECT_EQ(unit->samplingRate(), Sampling::Rate860);
+    EXPECT_EQ(unit->multiplexer(), Mux::AIN_01);
+    EXPECT_EQ(unit->gain(), Gain::PGA_2048);
+    EXPECT_EQ(unit->comparatorQueue(), ComparatorQueue::Disable);
+    EXPECT_TRUE(unit->stopPeriodicMeasurement());
+}
+
 TEST_P(TestADS1115, Periodic)
 {
     SCOPED_TRACE(ustr);
 
+    constexpr uint32_t rate_table[] = {8, 16, 32, 64, 128, 250, 475, 860};
+
     std::tuple<const char*, Sampling> table[] = {
         {"8sps", Sampling::Rate8},     {"16sps", Sampling::Rate16},   {"32sps", Sampling::Rate32},
         {"64sps", Sampling::Rate64},   {"128sps", Sampling::Rate128}, {"250sps", Sampling::Rate250},
@@ -293,7 +361,10 @@ TEST_P(TestADS1115, Periodic)
             EXPECT_TRUE(unit->startPeriodicMeasurement());
             EXPECT_TRUE(unit->inPeriodic());
 
+            EXPECT_EQ(unit->intervalMicros(), 1000000U / rate_table[m5::stl::to_underlying(rate)]);
+
             test_periodic_measurement(unit.get(), 4, check_measurement_values);
+            EXPECT_GT(unit->effectiveSamplingRate(), 0.0f);
 
             EXPECT_TRUE(unit->stopPeriodicMeasurement());
             EXPECT_FALSE(unit->inPeriodic());
@@ -305,6 +376,140 @@ TEST_P(TestADS1115, Periodic)
     }
 }
 
+TEST_P(TestADS1115, ConversionReady)
+{
+    SCOPED_TRACE(ustr);
+
+    EXPECT_TRUE(unit->enableConversionReady(true));
+    EXPECT_TRUE(unit->inConversionReady());
+    EXPECT_NE(unit->comparatorQueue(), ComparatorQueue::Disable);
+
+    uint16_t hh{}, ll{};
+    EXPECT_TRUE(unit->readRegister16BE(command::HIGH_THRESHOLD_REG, hh, 0));
+    EXPECT_TRUE(unit->readRegister16BE(command::LOW_THRESHOLD_REG, ll, 0));
+    EXPECT_TRUE(hh & 0x8000);
+    EXPECT_FALSE(ll & 0x8000);
+
+    EXPECT_TRUE(unit->inPeriodic());
+    unit->flush();
+
+    // Not read without notification
+    for (int i = 0; i < 8; ++i) {
+        m5::utility::delay(2);
+        unit->update();
+        EXPECT_FALSE(unit->updated());
+    }
+    EXPECT_TRUE(unit->empty());
+
+    // Read once per notification
+    unit->onConversionReady();
+    unit->update();
+    EXPECT_TRUE(unit->updated());
+    unit->update();
+    EXPECT_FALSE(unit->updated());
+    EXPECT_EQ(unit->available(), 1U);
+
+    unit->onConversionReady();
+    unit->onConversionReady();
+    unit->update();
+    EXPECT_TRUE(unit->updated());
+    EXPECT_EQ(unit->conversionReadyOverruns(), 1U);
+
+    EXPECT_TRUE(unit->enableConversionReady(false));
+    EXPECT_FALSE(unit->inConversionReady());
+    EXPECT_EQ(unit->comparatorQueue(), ComparatorQueue::Disable);
+    int16_t high{}, low{};
+    EXPECT_TRUE(unit->readThreshold(high, low));
+    EXPECT_EQ(high, 0x7FFF);
+    EXPECT_EQ(low, (int16_t)0x8000);
+}
+
+TEST_P(TestADS1115, Decimation)
+{
+    SCOPED_TRACE(ustr);
+
+    EXPECT_TRUE(unit->stopPeriodicMeasurement());
+
+    EXPECT_FALSE(unit->writeDecimation(meter::Decimation::Boxcar, 1));
+    EXPECT_FALSE(unit->writeDecimation(meter::Decimation::CIC2, meter::Decimator::MAX_CIC2_RATIO + 1));
+    EXPECT_EQ(unit->decimation(), meter::Decimation::None);
+
+    for (auto&& type : {meter::Decimation::Boxcar, meter::Decimation::CIC2}) {
+        SCOPED_TRACE(m5::stl::to_underlying(type));
+        EXPECT_TRUE(unit->writeDecimation(type, 8));
+        EXPECT_EQ(unit->decimation(), type);
+        EXPECT_EQ(unit->decimationRatio(), 8U);
+
+        EXPECT_TRUE(unit->startPeriodicMeasurement(Sampling::Rate860, Mux::AIN_01, Gain::PGA_2048,
+                                                   ComparatorQueue::Disable));
+        unit->flush();
+        unit->flushAggregate();
+
+        test_periodic_measurement(unit.get(), 4, check_measurement_values);
+        EXPECT_TRUE(unit->stopPeriodicMeasurement());
+
+        EXPECT_EQ(unit->aggregateAvailable(), unit->available());
+        while (!unit->aggregateEmpty()) {
+            auto a = unit->oldestAggregate();
+            EXPECT_EQ(a.count, 8U);
+            EXPECT_LE(a.min, a.max);
+            EXPECT_LE(a.min, a.meanRaw());
+            EXPECT_GE(a.max, a.meanRaw());
+            EXPECT_EQ(a.meanRaw(), unit->adc());
+            unit->discardAggregate();
+            unit->discard();
+        }
+    }
+
+    EXPECT_TRUE(unit->writeDecimation(meter::Decimation::None, 0));
+    EXPECT_EQ(unit->decimation(), meter::Decimation::None);
+    EXPECT_EQ(unit->aggregateAvailable(), 0U);
+}
+
+TEST_P(TestADS1115, Scan)
+{
+    SCOPED_TRACE(ustr);
+
+    constexpr ScanSlot slots[] = {
+        {Mux::AIN_01, Gain::PGA_2048, Sampling::Rate860},
+        {Mux::GND_0, Gain::PGA_4096, Sampling::Rate475},
+        {Mux::GND_1, Gain::PGA_1024, Sampling::Rate860},
+    };
+
+    EXPECT_FALSE(unit->startScanMeasurement(slots, m5::stl::size(slots)));  // In periodic
+    EXPECT_TRUE(unit->stopPeriodicMeasurement());
+    auto prev = unit->configRegister();
+
+    EXPECT_FALSE(unit->startScanMeasurement(slots, 0));
+    EXPECT_TRUE(unit->startScanMeasurement(slots, m5::stl::size(slots)));
+    EXPECT_TRUE(unit->inScan());
+    EXPECT_EQ(unit->scanSlots(), m5::stl::size(slots));
+
+    auto timeout_at = m5::utility::millis() + 1000;
+    bool done{};
+    do {
+        unit->update();
+        done = true;
+        for (uint8_t i = 0; i < m5::stl::size(slots); ++i) {
+            done &= (unit->scanAvailable(i) == 4U);
+        }
+    } while (!done && m5::utility::millis() <= timeout_at);
+    EXPECT_TRUE(done);
+
+    EXPECT_TRUE(unit->stopScanMeasurement());
+    EXPECT_FALSE(unit->inScan());
+    EXPECT_EQ(unit->configRegister().value, prev.value);
+
+    for (uint8_t i = 0; i < m5::stl::size(slots); ++i) {
+        while (!unit->scanEmpty(i)) {
+            auto d = unit->scanOldest(i);
+            EXPECT_EQ(d.slot, i);
+            EXPECT_EQ(d.gain, slots[i].gain);
+            unit->scanDiscard(i);
+        }
+    }
+}
+
 TEST_P(TestADS1115, SingleShot)
 {
     SCOPED_TRACE(ustr);
@@ -479,3 +479,112 @@ TEST_P(TestINA226, Periodic)
 }
 
 #endif
+
+TEST_P(TestINA226, WithoutDataReadyCheck)
+{
+    SCOPED_TRACE(ustr);
+
+    EXPECT_TRUE(unit->stopPeriodicMeasurement());
+    EXPECT_TRUE(unit->dataReadyCheck());
+    unit->setDataReadyCheck(false);
+    EXPECT_FALSE(unit->dataReadyCheck());
+
+    EXPECT_TRUE(unit->startPeriodicMeasurement(Sampling::Rate1, ConversionTime::US_588, ConversionTime::US_588, true,
+                                               true, true));
+    EXPECT_TRUE(unit->inPeriodic());
+
+    // The first read waits for the first conversion
+    unit->update();
+    EXPECT_FALSE(unit->updated());
+
+    test_periodic_measurement(unit.get(), STORED_SIZE, 1);
+    EXPECT_TRUE(unit->stopPeriodicMeasurement());
+    EXPECT_EQ(unit->available(), STORED_SIZE);
+    while (unit->available()) {
+        EXPECT_TRUE(std::isfinite(unit->shuntVoltage()));
+        EXPECT_TRUE(std::isfinite(unit->voltage()));
+        EXPECT_TRUE(std::isfinite(unit->power()));
+        EXPECT_TRUE(std::isfinite(unit->current()));
+        unit->discard();
+    }
+    EXPECT_GT(unit->effectiveSamplingRate(), 0.0f);
+
+    unit->setDataReadyCheck(true);
+}
+
+TEST_P(TestINA226, ConversionReady)
+{
+    SCOPED_TRACE(ustr);
+
+    EXPECT_TRUE(unit->stopPeriodicMeasurement());
+    EXPECT_TRUE(unit->enableConversionReady(true));
+    EXPECT_TRUE(unit->inConversionReady());
+
+    Alert type{};
+    EXPECT_TRUE(unit->readAlert(type));
+    EXPECT_EQ(type, Alert::ConversionReady);
+
+    EXPECT_TRUE(unit->startPeriodicMeasurement(Sampling::Rate1, ConversionTime::US_588, ConversionTime::US_588, true,
+                                               true, true));
+    unit->flush();
+
+    // Not read without notification
+    for (int i = 0; i < 8; ++i) {
+        m5::utility::delay(2);
+        unit->update();
+        EXPECT_FALSE(unit->updated());
+    }
+    EXPECT_TRUE(unit->empty());
+
+    // Read once per notification (simulated alert line)
+    unit->onConversionReady();
+    unit->update();
+    EXPECT_TRUE(unit->updated());
+    unit->update();
+    EXPECT_FALSE(unit->updated());
+    EXPECT_EQ(unit->available(), 1U);
+
+    m5::utility::delay(2);
+    unit->onConversionReady();
+    unit->onConversionReady();
+    unit->update();
+    EXPECT_TRUE(unit->updated());
+    EXPECT_EQ(unit->conversionReadyOverruns(), 1U);
+
+    EXPECT_TRUE(unit->stopPeriodicMeasurement());
+    EXPECT_TRUE(unit->enableConversionReady(false));
+    EXPECT_FALSE(unit->inConversionReady());
+    EXPECT_TRUE(unit->readAlert(type));
+    EXPECT_EQ(type, Alert::None);
+}
+
+TEST_P(TestINA226, Accumulation)
+{
+    SCOPED_TRACE(ustr);
+
+    EXPECT_TRUE(unit->stopPeriodicMeasurement());
+    unit->resetAccumulation();
+    auto acc = unit->accumulation();
+    EXPECT_EQ(acc.samples, 0U);
+    EXPECT_EQ(acc.duration, 0U);
+    EXPECT_EQ(acc.charge, 0);
+    EXPECT_EQ(acc.energy, 0);
+
+    EXPECT_TRUE(unit->startPeriodicMeasurement(Sampling::Rate1, ConversionTime::US_588, ConversionTime::US_588, true,
+                                               true, true));
+    // Integrated even if the buffer overflows
+    test_periodic_measurement(unit.get(), STORED_SIZE * 2, 1);
+    EXPECT_TRUE(unit->stopPeriodicMeasurement());
+    EXPECT_TRUE(unit->full());
+
+    acc = unit->accumulation();
+    EXPECT_EQ(acc.samples, STORED_SIZE * 2);
+    EXPECT_GT(acc.duration, 0U);
+    EXPECT_FLOAT_EQ(acc.currentLSB, unit->currentLSB());
+    EXPECT_TRUE(std::isfinite(acc.mAh()));
+    EXPECT_TRUE(std::isfinite(acc.Wh()));
+    EXPECT_GE(acc.Wh(), 0.0);
+
+    unit->resetAccumulation();
+    EXPECT_EQ(unit->accumulation().samples, 0U);
+}
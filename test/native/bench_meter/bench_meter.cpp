@@ -0,0 +1,305 @@
+/*
+ * SPDX-FileCopyrightText: 2024 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+/*
+  Throughput benchmark of the meter units with the simulated devices (native)
+
+  For each unit and configuration, runs update() with a consumer that drains the buffer periodically and reports
+  - configured and achieved samples/s
+  - conversions the device completed but were never read, and samples overwritten in the buffer before consumed
+  - modelled bus time per sample at the unit clock, and measured update() latency
+  - consumer latency (acquisition to consumption)
+  as JSON to stdout, and to the file named by M5_UNIT_METER_BENCH_JSON if set.
+  Configurations whose period is longer than MAX_PERIOD_US are not run.
+*/
+#if !M5_UNIT_METER_BUS_STATS || !M5_UNIT_METER_SAMPLE_TIMESTAMP
+#error "Build with -DM5_UNIT_METER_BUS_STATS=1 -DM5_UNIT_METER_SAMPLE_TIMESTAMP=1"
+#endif
+
+#include <gtest/gtest.h>
+#include <M5UnitComponent.hpp>
+#include <unit/unit_ADS1115.hpp>
+#include <unit/unit_INA226.hpp>
+#include <unit/unit_KmeterISO.hpp>
+#include <unit/unit_DualKmeter.hpp>
+#include "../sim/sim_ads1115.hpp"
+#include "../sim/sim_ina226.hpp"
+#include "../sim/sim_kmeter.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+using namespace m5::unit;
+
+namespace {
+
+constexpr uint32_t STORED_SIZE{16};
+constexpr uint32_t CONSUMER_PERIOD_MS{10};
+constexpr uint32_t MIN_DURATION_MS{250};
+constexpr uint32_t MIN_PERIODS{8};
+constexpr uint32_t MAX_PERIOD_US{125 * 1000U};
+
+struct Result {
+    std::string unit{};
+    std::string config{};  // JSON object
+    double configured_sps{};
+    double achieved_sps{};
+    uint32_t samples{};
+    int64_t unread_conversions{-1};  // -1: Not known
+    uint32_t buffer_drops{};
+    double bus_us_per_sample{};
+    double update_us_mean{};
+    uint32_t update_us_max{};
+    uint32_t polls{};
+    double consumer_latency_us_mean{};
+    uint32_t consumer_latency_us_max{};
+};
+
+std::vector<Result> results{};
+
+inline uint32_t duration_ms(const uint32_t period_us)
+{
+    const uint32_t ms = period_us * MIN_PERIODS / 1000;
+    return ms > MIN_DURATION_MS ? ms : MIN_DURATION_MS;
+}
+
+// Run the unit with the periodic consumer
+template <class U>
+Result run(U& unit, sim::Bus& bus, const uint32_t period_us)
+{
+    Result r{};
+    r.configured_sps = 1000000.0 / period_us;
+
+    unit.resetBusStats();
+    bus.resetStats();
+    while (unit.available()) {
+        unit.discard();
+    }
+
+    uint32_t pushed{}, consumed{};
+    uint64_t latency_sum{};
+    const auto start_at = m5::utility::millis();
+    const auto end_at   = start_at + duration_ms(period_us);
+    auto consume_at     = start_at + CONSUMER_PERIOD_MS;
+    auto now            = start_at;
+    do {
+        bus.tick();
+        unit.update();
+        pushed += unit.updated() ? 1 : 0;
+
+        now = m5::utility::millis();
+        if (now >= consume_at) {
+            consume_at += CONSUMER_PERIOD_MS;
+            const uint32_t t = (uint32_t)m5::utility::micros();
+            while (unit.available()) {
+                const uint32_t lat = t - unit.oldest().timestamp();
+                latency_sum += lat;
+                r.consumer_latency_us_max = std::max(r.consumer_latency_us_max, lat);
+                ++consumed;
+                unit.discard();
+            }
+        }
+    } while (now < end_at);
+    const auto elapsed = m5::utility::millis() - start_at;
+
+    const auto& st         = unit.busStats();
+    const auto& upd        = st.of(meter::Call::Update);
+    r.samples              = pushed;
+    r.achieved_sps         = pushed * 1000.0 / elapsed;
+    r.buffer_drops         = pushed - consumed - (uint32_t)unit.available();
+    r.bus_us_per_sample    = pushed ? (double)bus.stats().busMicros(unit.component_config().clock) / pushed : 0.0;
+    r.update_us_mean       = upd.mean();
+    r.update_us_max        = upd.max;
+    r.polls                = st.polls;
+    r.consumer_latency_us_mean = consumed ? (double)latency_sum / consumed : 0.0;
+    return r;
+}
+
+void write_json(FILE* fp)
+{
+    std::fprintf(fp, "{\n  \"consumer_period_ms\": %u,\n  \"stored_size\": %u,\n  \"benchmarks\": [\n",
+                 CONSUMER_PERIOD_MS, STORED_SIZE);
+    for (size_t i = 0; i < results.size(); ++i) {
+        const auto& r = results[i];
+        std::fprintf(fp,
+                     "    {\"unit\": \"%s\", \"config\": %s, \"configured_sps\": %.2f, \"achieved_sps\": %.2f, "
+                     "\"samples\": %u, \"unread_conversions\": %lld, \"buffer_drops\": %u, "
+                     "\"bus_us_per_sample\": %.1f, \"update_us_mean\": %.1f, \"update_us_max\": %u, \"polls\": %u, "
+                     "\"consumer_latency_us_mean\": %.1f, \"consumer_latency_us_max\": %u}%s\n",
+                     r.unit.c_str(), r.config.c_str(), r.configured_sps, r.achieved_sps, r.samples,
+                     (long long)r.unread_conversions, r.buffer_drops, r.bus_us_per_sample, r.update_us_mean,
+                     r.update_us_max, r.polls, r.consumer_latency_us_mean, r.consumer_latency_us_max,
+                     (i + 1 < results.size()) ? "," : "");
+    }
+    std::fprintf(fp, "  ]\n}\n");
+}
+
+class BenchEnvironment : public ::testing::Environment {
+public:
+    virtual void TearDown() override
+    {
+        write_json(stdout);
+        const char* path = std::getenv("M5_UNIT_METER_BENCH_JSON");
+        if (path && *path) {
+            if (FILE* fp = std::fopen(path, "w")) {
+                write_json(fp);
+                std::fclose(fp);
+            }
+        }
+    }
+};
+
+const ::testing::Environment* bench_env = ::testing::AddGlobalTestEnvironment(new BenchEnvironment());
+
+template <class U>
+void setup(U& unit, sim::Bus& bus)
+{
+    unit.connect(bus);
+    auto ccfg        = unit.component_config();
+    ccfg.stored_size = STORED_SIZE;
+    unit.component_config(ccfg);
+}
+
+}  // namespace
+
+TEST(Bench, ADS1115)
+{
+    using namespace m5::unit::ads111x;
+    constexpr uint8_t ADDRESS{0x48};
+    constexpr std::pair<Sampling, uint32_t> table[] = {
+        {Sampling::Rate8, 8},     {Sampling::Rate16, 16},   {Sampling::Rate32, 32},   {Sampling::Rate64, 64},
+        {Sampling::Rate128, 128}, {Sampling::Rate250, 250}, {Sampling::Rate475, 475}, {Sampling::Rate860, 860},
+    };
+
+    sim::Bus bus{};
+    sim::ADS1115 dev{};
+    dev.input([](const uint8_t, const uint32_t) { return 1.0; });
+    sim::Simulated<UnitADS1115> unit{ADDRESS};
+    setup(unit, bus);
+    bus.attach(ADDRESS, &dev);
+    ASSERT_TRUE(unit.begin());
+
+    for (auto&& e : table) {
+        if (unit.inPeriodic()) {
+            EXPECT_TRUE(unit.stopPeriodicMeasurement());
+        }
+        ASSERT_TRUE(unit.startPeriodicMeasurement(e.first, Mux::AIN_01, Gain::PGA_2048, ComparatorQueue::Disable));
+        if (unit.intervalMicros() > MAX_PERIOD_US) {
+            continue;
+        }
+        const uint32_t before = dev.conversions();
+        auto r                = run(unit, bus, unit.intervalMicros());
+        r.unit                = "UnitADS1115";
+        r.config              = "{\"sampling\": " + std::to_string(e.second) + "}";
+        // The first sample may be a conversion completed before the run
+        const uint32_t conv  = dev.conversions() - before;
+        r.unread_conversions = conv > r.samples ? conv - r.samples : 0;
+        results.push_back(r);
+        EXPECT_GT(r.samples, 0U);
+    }
+}
+
+TEST(Bench, INA226)
+{
+    using namespace m5::unit::ina226;
+    constexpr std::pair<Sampling, uint32_t> rate_table[] = {
+        {Sampling::Rate1, 1}, {Sampling::Rate4, 4}, {Sampling::Rate16, 16}, {Sampling::Rate64, 64}};
+    constexpr std::pair<ConversionTime, uint32_t> ct_table[] = {
+        {ConversionTime::US_140, 140},   {ConversionTime::US_332, 332},   {ConversionTime::US_1100, 1100},
+        {ConversionTime::US_2116, 2116}, {ConversionTime::US_4156, 4156}, {ConversionTime::US_8244, 8244}};
+
+    for (auto&& check : {true, false}) {
+        sim::Bus bus{};
+        sim::INA226 dev{0.080};
+        dev.current(sim::waveform::sine(0.5, 0.2, 50));
+        dev.voltage(sim::waveform::constant(5.0));
+        sim::Simulated<UnitINA226_1A> unit{};
+        setup(unit, bus);
+        bus.attach(unit.address(), &dev);
+        auto cfg             = unit.config();
+        cfg.start_periodic   = false;
+        cfg.data_ready_check = check;
+        unit.config(cfg);
+        ASSERT_TRUE(unit.begin());
+
+        for (auto&& rt : rate_table) {
+            for (auto&& ct : ct_table) {
+                if (unit.inPeriodic()) {
+                    EXPECT_TRUE(unit.stopPeriodicMeasurement());
+                }
+                ASSERT_TRUE(unit.startPeriodicMeasurement(rt.first, ct.first, ct.first));
+                if (unit.intervalMicros() > MAX_PERIOD_US) {
+                    continue;
+                }
+                const uint32_t unread = dev.unread();
+                auto r                = run(unit, bus, unit.intervalMicros());
+                r.unit                = "UnitINA226_1A";
+                r.config = "{\"sampling\": " + std::to_string(rt.second) + ", \"conversion_time_us\": " +
+                           std::to_string(ct.second) + ", \"data_ready_check\": " + (check ? "true" : "false") + "}";
+                r.unread_conversions = dev.unread() - unread;
+                results.push_back(r);
+                EXPECT_GT(r.samples, 0U);
+            }
+        }
+    }
+}
+
+TEST(Bench, KmeterISO)
+{
+    using namespace m5::unit::kmeter_iso;
+    constexpr uint32_t interval_table[] = {10, 20, 50, 100};
+
+    sim::Bus bus{};
+    sim::KmeterISO dev{};
+    dev.timing(10 * 1000U, 0);
+    dev.temperature(sim::waveform::constant(100.0));
+    sim::Simulated<UnitKmeterISO> unit{};
+    setup(unit, bus);
+    bus.attach(unit.address(), &dev);
+    auto cfg           = unit.config();
+    cfg.start_periodic = false;
+    unit.config(cfg);
+    ASSERT_TRUE(unit.begin());
+
+    for (auto&& it : interval_table) {
+        ASSERT_TRUE(unit.startPeriodicMeasurement(it, MeasurementUnit::Celsius));
+        auto r   = run(unit, bus, it * 1000);
+        r.unit   = "UnitKmeterISO";
+        r.config = "{\"interval_ms\": " + std::to_string(it) + "}";
+        results.push_back(r);
+        EXPECT_GT(r.samples, 0U);
+        EXPECT_TRUE(unit.stopPeriodicMeasurement());
+    }
+}
+
+TEST(Bench, DualKmeter)
+{
+    using namespace m5::unit::dual_kmeter;
+    constexpr uint32_t interval_table[] = {10, 20, 50, 100};
+
+    sim::Bus bus{};
+    sim::DualKmeter dev{};
+    dev.timing(10 * 1000U, 20 * 1000U);
+    dev.temperature(sim::waveform::constant(100.0), 0);
+    dev.temperature(sim::waveform::constant(200.0), 1);
+    sim::Simulated<UnitDualKmeter> unit{};
+    setup(unit, bus);
+    bus.attach(unit.address(), &dev);
+    auto cfg           = unit.config();
+    cfg.start_periodic = false;
+    unit.config(cfg);
+    ASSERT_TRUE(unit.begin());
+
+    for (auto&& it : interval_table) {
+        ASSERT_TRUE(unit.startPeriodicMeasurement(it, Channel::One, MeasurementUnit::Celsius));
+        auto r   = run(unit, bus, it * 1000);
+        r.unit   = "UnitDualKmeter";
+        r.config = "{\"interval_ms\": " + std::to_string(it) + "}";
+        results.push_back(r);
+        EXPECT_GT(r.samples, 0U);
+        EXPECT_TRUE(unit.stopPeriodicMeasurement());
+    }
+}
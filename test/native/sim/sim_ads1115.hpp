@@ -0,0 +1,234 @@
+/*
+ * SPDX-FileCopyrightText: 2024 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+/*
+  Simulated ADS1115 for native test/benchmark
+*/
+#ifndef M5_UNIT_METER_TEST_SIM_ADS1115_HPP
+#define M5_UNIT_METER_TEST_SIM_ADS1115_HPP
+
+#include "sim_bus.hpp"
+#include <cmath>
+#include <functional>
+
+namespace m5 {
+namespace unit {
+namespace sim {
+
+/*!
+  @class ADS1115
+  @brief Cycle-approximate ADS1115 register model
+  @details
+  - Config, conversion, Lo_thresh and Hi_thresh registers with the register pointer
+  - Conversions complete every 1/DR in continuous mode, the conversion register holds the latest completed one
+  - OS bit: writing 1 in power-down starts a single-shot, reading 0 while converting
+  - ALERT/RDY pulses per conversion when Hi_thresh MSB = 1, Lo_thresh MSB = 0 and COMP_QUE != 3
+  - General call reset (0x06)
+ */
+class ADS1115 : public Device {
+public:
+    static constexpr uint16_t DEFAULT_CONFIG{0x8583};
+    static constexpr uint16_t DEFAULT_LO_THRESH{0x8000};
+    static constexpr uint16_t DEFAULT_HI_THRESH{0x7FFF};
+
+    //! @brief Input voltage (V) of the multiplexer setting (0-7) at the time (us)
+    using input_function_t = std::function<double(const uint8_t mux, const uint32_t us)>;
+    //! @brief ALERT/RDY edge
+    using alert_function_t = std::function<void()>;
+
+    ADS1115()
+    {
+        reset();
+    }
+
+    //! @brief Reset to the power-on state
+    void reset()
+    {
+        _pointer    = 0;
+        _config     = DEFAULT_CONFIG;
+        _lo         = DEFAULT_LO_THRESH;
+        _hi         = DEFAULT_HI_THRESH;
+        _conversion = 0;
+        _converting = false;
+        _started_at = now();
+        _completed  = 0;
+        ++_resets;
+    }
+
+    inline void input(input_function_t f)
+    {
+        _input = f;
+    }
+    inline void onAlert(alert_function_t f)
+    {
+        _alert = f;
+    }
+
+    //! @brief Number of completed conversions
+    inline uint32_t conversions() const
+    {
+        return _conversions;
+    }
+    //! @brief Number of resets (including power-on)
+    inline uint32_t resets() const
+    {
+        return _resets;
+    }
+    inline uint16_t config() const
+    {
+        return _config;
+    }
+
+    // Device
+    virtual bool write(const uint8_t* data, const size_t len) override
+    {
+        if (!len) {
+            return true;
+        }
+        update();
+        _pointer = data[0] & 0x03;
+        if (len < 3) {
+            return true;  // Pointer only
+        }
+        const uint16_t v = ((uint16_t)data[1] << 8) | data[2];
+        switch (_pointer) {
+            case 1:
+                write_config(v);
+                break;
+            case 2:
+                _lo = v;
+                break;
+            case 3:
+                _hi = v;
+                break;
+            default:  // Conversion register is read only
+                break;
+        }
+        return true;
+    }
+
+    virtual bool read(uint8_t* data, const size_t len) override
+    {
+        update();
+        uint16_t v{};
+        switch (_pointer) {
+            case 0:
+                v = _conversion;
+                break;
+            case 1:
+                // OS reads 0 while converting (always converting in continuous mode)
+                v = (_config & 0x7FFF) | ((continuous() || _converting) ? 0 : 0x8000);
+                break;
+            case 2:
+                v = _lo;
+                break;
+            case 3:
+                v = _hi;
+                break;
+        }
+        for (size_t i = 0; i < len; ++i) {
+            data[i] = (i & 1) ? (uint8_t)v : (uint8_t)(v >> 8);
+        }
+        return true;
+    }
+
+    virtual void generalCall(const uint8_t* data, const size_t len) override
+    {
+        if (len && data[0] == 0x06) {
+            reset();
+        }
+    }
+
+    virtual void tick() override
+    {
+        update();
+    }
+
+    //! @brief Conversion period (us) of the data rate
+    inline uint32_t periodMicros() const
+    {
+        static constexpr uint32_t sps[] = {8, 16, 32, 64, 128, 250, 475, 860};
+        return 1000000U / sps[(_config >> 5) & 0x07];
+    }
+
+protected:
+    static inline uint32_t now()
+    {
+        return (uint32_t)m5::utility::micros();
+    }
+    inline bool continuous() const
+    {
+        return !(_config & 0x0100);
+    }
+    inline bool rdy_mode() const
+    {
+        return (_hi & 0x8000) && !(_lo & 0x8000) && ((_config & 0x03) != 0x03);
+    }
+
+    void write_config(const uint16_t v)
+    {
+        _config = v & 0x7FFF;
+        if (continuous()) {
+            // (Re)starts the conversion cycle on any config write in continuous mode
+            _started_at = now();
+            _completed  = 0;
+        } else if (v & 0x8000) {
+            // Single-shot
+            _converting = true;
+            _started_at = now();
+        }
+    }
+
+    // Evaluate the conversions completed until now
+    void update()
+    {
+        const uint32_t t      = now();
+        const uint32_t period = periodMicros();
+        if (continuous()) {
+            const uint32_t done = (t - _started_at) / period;
+            if (done > _completed) {
+                const uint32_t n = done - _completed;
+                _completed       = done;
+                _conversions += n;
+                _conversion = sample(_started_at + done * period);
+                if (rdy_mode() && _alert) {
+                    for (uint32_t i = 0; i < n; ++i) {
+                        _alert();
+                    }
+                }
+            }
+        } else if (_converting && t - _started_at >= period) {
+            _converting = false;
+            ++_conversions;
+            _conversion = sample(_started_at + period);
+            if (rdy_mode() && _alert) {
+                _alert();
+            }
+        }
+    }
+
+    // Convert the input to the code by PGA
+    uint16_t sample(const uint32_t at) const
+    {
+        static constexpr double fsr[] = {6.144, 4.096, 2.048, 1.024, 0.512, 0.256, 0.256, 0.256};
+        const double v    = _input ? _input((_config >> 12) & 0x07, at) : 0.0;
+        const double code = std::round(v / fsr[(_config >> 9) & 0x07] * 32768.0);
+        const double c    = code > 32767.0 ? 32767.0 : (code < -32768.0 ? -32768.0 : code);
+        return (uint16_t)(int16_t)c;
+    }
+
+private:
+    uint8_t _pointer{};
+    uint16_t _config{DEFAULT_CONFIG}, _lo{DEFAULT_LO_THRESH}, _hi{DEFAULT_HI_THRESH}, _conversion{};
+    bool _converting{};
+    uint32_t _started_at{}, _completed{}, _conversions{}, _resets{};
+    input_function_t _input{};
+    alert_function_t _alert{};
+};
+
+}  // namespace sim
+}  // namespace unit
+}  // namespace m5
+#endif
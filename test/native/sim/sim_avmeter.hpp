@@ -0,0 +1,50 @@
+/*
+ * SPDX-FileCopyrightText: 2024 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+/*
+  Simulated Ameter/Vmeter (ADS1115 and the calibration EEPROM) for native test/benchmark
+*/
+#ifndef M5_UNIT_METER_TEST_SIM_AVMETER_HPP
+#define M5_UNIT_METER_TEST_SIM_AVMETER_HPP
+
+#include "sim_bus.hpp"
+#include <unit/unit_av_base.hpp>
+
+namespace m5 {
+namespace unit {
+namespace sim {
+
+/*!
+  @class SimulatedAVmeter
+  @brief Ameter/Vmeter connected to the simulated bus with the EEPROM child
+  @tparam U UnitAVmeterBase or derived class
+ */
+template <class U>
+class SimulatedAVmeter : public Simulated<U> {
+public:
+    using Simulated<U>::Simulated;
+
+    /*!
+      @brief Connect the unit and the EEPROM child to the simulated bus
+      @param bus Simulated bus
+      @param addr Address of the unit (Use the address of the unit if zero)
+      @param eepromAddr Address of the EEPROM (Use the address of the EEPROM if zero)
+     */
+    void connect(Bus& bus, const uint8_t addr = 0, const uint8_t eepromAddr = 0)
+    {
+        Simulated<U>::connect(bus, addr);
+        this->assign_eeprom_adapter(
+            std::make_shared<SimAdapter>(bus, eepromAddr ? eepromAddr : this->_eeprom.address()));
+    }
+    meter::UnitEEPROM& eeprom()
+    {
+        return this->_eeprom;
+    }
+};
+
+}  // namespace sim
+}  // namespace unit
+}  // namespace m5
+#endif
@@ -0,0 +1,300 @@
+/*
+ * SPDX-FileCopyrightText: 2024 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+/*
+  Simulated I2C bus and adapter for native test/benchmark
+*/
+#ifndef M5_UNIT_METER_TEST_SIM_BUS_HPP
+#define M5_UNIT_METER_TEST_SIM_BUS_HPP
+
+#include <M5UnitComponent.hpp>
+#include <M5Utility.hpp>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <vector>
+
+namespace m5 {
+namespace unit {
+namespace sim {
+
+/*!
+  @struct BusStats
+  @brief Transaction counters of the simulated bus
+ */
+struct BusStats {
+    uint32_t transactions{};  // Number of START ... STOP/repeated START
+    uint32_t reads{};         // Read transactions
+    uint32_t writes{};        // Write transactions
+    uint32_t read_bytes{};    // Payload bytes (excluding address byte)
+    uint32_t write_bytes{};   // Payload bytes (excluding address byte)
+    uint32_t nacks{};         // Transactions to absent devices
+    uint32_t general_calls{};
+
+    //! @brief Bus time at the clock (us), including address bytes and ACK bits
+    inline uint32_t busMicros(const uint32_t clock = 400 * 1000U) const
+    {
+        // 9 bits per byte (8 + ACK/NACK), one address byte per transaction, START/STOP ~2 bits
+        const uint64_t bits = (uint64_t)(read_bytes + write_bytes + transactions) * 9 + transactions * 2;
+        return (uint32_t)(bits * 1000000ULL / clock);
+    }
+};
+
+/*!
+  @class Device
+  @brief Base of the simulated I2C device
+  @details Device models update their state lazily from the elapsed time at each access, or at tick()
+ */
+class Device {
+public:
+    virtual ~Device() = default;
+
+    //! @brief Write transaction (the first byte is typically the register pointer)
+    virtual bool write(const uint8_t* data, const size_t len) = 0;
+    //! @brief Read transaction
+    virtual bool read(uint8_t* data, const size_t len) = 0;
+    //! @brief General call (address 0x00)
+    virtual void generalCall(const uint8_t* /*data*/, const size_t /*len*/)
+    {
+    }
+    //! @brief Advance the model to the current time (e.g. raise ALERT/RDY)
+    virtual void tick()
+    {
+    }
+    //! @brief Requested address change (for the devices that can change the address)
+    virtual bool changedAddress(uint8_t& /*addr*/)
+    {
+        return false;
+    }
+
+    inline const BusStats& stats() const
+    {
+        return _stats;
+    }
+    inline void resetStats()
+    {
+        _stats = BusStats{};
+    }
+    //! @brief Register access counters (by the register pointer written)
+    inline const std::map<uint8_t, uint32_t>& registerWrites() const
+    {
+        return _reg_writes;
+    }
+
+protected:
+    friend class Bus;
+    BusStats _stats{};
+    std::map<uint8_t, uint32_t> _reg_writes{};
+};
+
+/*!
+  @class Bus
+  @brief Simulated I2C bus
+ */
+class Bus {
+public:
+    //! @brief Returns true to NACK the write transaction (fault injection)
+    using write_fault_function_t = std::function<bool(const uint8_t addr, const uint8_t* data, const size_t len)>;
+
+    //! @brief Attach the device model at the address
+    inline void attach(const uint8_t addr, Device* dev)
+    {
+        _devices[addr] = dev;
+    }
+    inline void detach(const uint8_t addr)
+    {
+        _devices.erase(addr);
+    }
+    inline Device* device(const uint8_t addr) const
+    {
+        auto it = _devices.find(addr);
+        return it != _devices.end() ? it->second : nullptr;
+    }
+
+    /*!
+      @brief Occupy the bus for the time of each transaction at the clock
+      @param hz Clock (Hz), zero for no wait
+     */
+    inline void clock(const uint32_t hz)
+    {
+        _clock = hz;
+    }
+    //! @brief Set the fault injection of the write transactions (nullptr to clear)
+    inline void writeFault(write_fault_function_t f)
+    {
+        _write_fault = f;
+    }
+
+    //! @brief Advance all device models (Call from the test loop as the interrupt source)
+    void tick()
+    {
+        for (auto&& e : _devices) {
+            e.second->tick();
+        }
+    }
+
+    m5::hal::error::error_t write(const uint8_t addr, const uint8_t* data, const size_t len)
+    {
+        ++_stats.transactions;
+        ++_stats.writes;
+        auto dev = device(addr);
+        if (!dev || (_write_fault && _write_fault(addr, data, len))) {
+            ++_stats.nacks;
+            return m5::hal::error::error_t::I2C_NO_ACK;
+        }
+        ++dev->_stats.transactions;
+        ++dev->_stats.writes;
+        _stats.write_bytes += len;
+        dev->_stats.write_bytes += len;
+        occupy(len);
+        if (len) {
+            ++dev->_reg_writes[data[0]];
+        }
+        bool ret = dev->write(data, len);
+        follow_address(addr, dev);
+        return ret ? m5::hal::error::error_t::OK : m5::hal::error::error_t::I2C_NO_ACK;
+    }
+
+    m5::hal::error::error_t read(const uint8_t addr, uint8_t* data, const size_t len)
+    {
+        ++_stats.transactions;
+        ++_stats.reads;
+        auto dev = device(addr);
+        if (!dev) {
+            ++_stats.nacks;
+            return m5::hal::error::error_t::I2C_NO_ACK;
+        }
+        ++dev->_stats.transactions;
+        ++dev->_stats.reads;
+        _stats.read_bytes += len;
+        dev->_stats.read_bytes += len;
+        occupy(len);
+        return dev->read(data, len) ? m5::hal::error::error_t::OK : m5::hal::error::error_t::I2C_NO_ACK;
+    }
+
+    m5::hal::error::error_t generalCall(const uint8_t* data, const size_t len)
+    {
+        ++_stats.transactions;
+        ++_stats.general_calls;
+        _stats.write_bytes += len;
+        for (auto&& e : _devices) {
+            e.second->generalCall(data, len);
+        }
+        return m5::hal::error::error_t::OK;
+    }
+
+    inline const BusStats& stats() const
+    {
+        return _stats;
+    }
+    inline void resetStats()
+    {
+        _stats = BusStats{};
+        for (auto&& e : _devices) {
+            e.second->resetStats();
+            e.second->_reg_writes.clear();
+        }
+    }
+
+protected:
+    // Busy wait for the address, payload and START/STOP bits
+    void occupy(const size_t len) const
+    {
+        if (_clock) {
+            const uint32_t us = (uint32_t)(((uint64_t)(len + 1) * 9 + 2) * 1000000ULL / _clock);
+            const auto at     = m5::utility::micros();
+            while (m5::utility::micros() - at < us) {
+            }
+        }
+    }
+
+    // Move the device if it has accepted the address change
+    void follow_address(const uint8_t addr, Device* dev)
+    {
+        uint8_t to{};
+        if (dev->changedAddress(to) && to != addr) {
+            _devices.erase(addr);
+            _devices[to] = dev;
+        }
+    }
+
+private:
+    std::map<uint8_t, Device*> _devices{};
+    BusStats _stats{};
+    uint32_t _clock{};
+    write_fault_function_t _write_fault{};
+};
+
+/*!
+  @class SimAdapter
+  @brief M5UnitUnified adapter connected to the simulated bus
+ */
+class SimAdapter : public m5::unit::Adapter {
+public:
+    SimAdapter(Bus& bus, const uint8_t addr) : Adapter(), _bus(bus), _addr(addr)
+    {
+    }
+
+    virtual Adapter* duplicate(const uint8_t addr) override
+    {
+        return new SimAdapter(_bus, addr);
+    }
+
+    virtual m5::hal::error::error_t readWithTransaction(uint8_t* data, const size_t len) override
+    {
+        return _bus.read(_addr, data, len);
+    }
+    virtual m5::hal::error::error_t writeWithTransaction(const uint8_t* data, const size_t len,
+                                                         const uint32_t /*stop*/ = 1) override
+    {
+        return _bus.write(_addr, data, len);
+    }
+    virtual m5::hal::error::error_t writeWithTransaction(const uint8_t reg, const uint8_t* data, const size_t len,
+                                                         const uint32_t /*stop*/ = 1) override
+    {
+        std::vector<uint8_t> buf(len + 1);
+        buf[0] = reg;
+        if (data && len) {
+            std::copy(data, data + len, buf.begin() + 1);
+        }
+        return _bus.write(_addr, buf.data(), buf.size());
+    }
+    virtual m5::hal::error::error_t generalCall(const uint8_t* data, const size_t len) override
+    {
+        return _bus.generalCall(data, len);
+    }
+
+private:
+    Bus& _bus;
+    uint8_t _addr{};
+};
+
+/*!
+  @class Simulated
+  @brief Unit connected to the simulated bus
+  @details The adapter is assigned by the derived class as UnitUnified does on add()
+  @tparam U Unit class
+ */
+template <class U>
+class Simulated : public U {
+public:
+    using U::U;
+
+    /*!
+      @brief Connect to the simulated bus
+      @param bus Simulated bus
+      @param addr Address (Use the address of the unit if zero)
+     */
+    void connect(Bus& bus, const uint8_t addr = 0)
+    {
+        this->_adapter = std::make_shared<SimAdapter>(bus, addr ? addr : this->address());
+    }
+};
+
+}  // namespace sim
+}  // namespace unit
+}  // namespace m5
+#endif
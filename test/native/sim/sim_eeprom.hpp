@@ -0,0 +1,84 @@
+/*
+ * SPDX-FileCopyrightText: 2024 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+/*
+  Simulated calibration EEPROM of Ameter/Vmeter for native test/benchmark
+*/
+#ifndef M5_UNIT_METER_TEST_SIM_EEPROM_HPP
+#define M5_UNIT_METER_TEST_SIM_EEPROM_HPP
+
+#include "sim_bus.hpp"
+#include <array>
+
+namespace m5 {
+namespace unit {
+namespace sim {
+
+/*!
+  @class EEPROM
+  @brief 256 bytes EEPROM with the byte address pointer
+  @details
+  - A write transaction sets the address pointer (and writes the following bytes)
+  - Reads continue from the pointer and wrap around at the end of the memory
+  - Calibration records of 8 bytes per gain from 0xD0: index, hope (BE), actual (BE), XOR of the preceding 5 bytes
+ */
+class EEPROM : public Device {
+public:
+    static constexpr uint8_t CALIBRATION_ADDRESS{0xD0};
+    static constexpr uint8_t RECORD_SIZE{8};
+
+    //! @brief Set the calibration record of the gain
+    void calibration(const uint8_t gain, const int16_t hope, const int16_t actual, const bool corrupt = false)
+    {
+        uint8_t* rec = _memory.data() + CALIBRATION_ADDRESS + gain * RECORD_SIZE;
+        rec[0]       = gain;
+        rec[1]       = (uint8_t)((uint16_t)hope >> 8);
+        rec[2]       = (uint8_t)(hope & 0xFF);
+        rec[3]       = (uint8_t)((uint16_t)actual >> 8);
+        rec[4]       = (uint8_t)(actual & 0xFF);
+        rec[5]       = rec[0] ^ rec[1] ^ rec[2] ^ rec[3] ^ rec[4];
+        rec[5] ^= corrupt ? 0x5A : 0x00;
+    }
+    /*!
+      @brief Limit the length of a read transaction, longer reads are NACKed (e.g. a small buffer of the host)
+      @param len Maximum length, zero for unlimited
+     */
+    inline void maxRead(const size_t len)
+    {
+        _max_read = len;
+    }
+
+    virtual bool write(const uint8_t* data, const size_t len) override
+    {
+        if (!len) {
+            return false;
+        }
+        _pointer = data[0];
+        for (size_t i = 1; i < len; ++i) {
+            _memory[_pointer++] = data[i];
+        }
+        return true;
+    }
+    virtual bool read(uint8_t* data, const size_t len) override
+    {
+        if (_max_read && len > _max_read) {
+            return false;
+        }
+        for (size_t i = 0; i < len; ++i) {
+            data[i] = _memory[_pointer++];
+        }
+        return true;
+    }
+
+private:
+    std::array<uint8_t, 256> _memory{};
+    uint8_t _pointer{};
+    size_t _max_read{};
+};
+
+}  // namespace sim
+}  // namespace unit
+}  // namespace m5
+#endif
@@ -0,0 +1,324 @@
+/*
+ * SPDX-FileCopyrightText: 2024 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+/*
+  Simulated INA226 for native test/benchmark
+*/
+#ifndef M5_UNIT_METER_TEST_SIM_INA226_HPP
+#define M5_UNIT_METER_TEST_SIM_INA226_HPP
+
+#include "sim_bus.hpp"
+#include "sim_waveform.hpp"
+#include <algorithm>
+#include <cmath>
+#include <functional>
+
+namespace m5 {
+namespace unit {
+namespace sim {
+
+/*!
+  @class INA226
+  @brief INA226 register model driven by current/bus voltage waveforms
+  @details
+  - Configuration/Shunt/Bus/Power/Current/Calibration/Mask/Alert limit/ID registers with the register pointer
+    (no auto-increment)
+  - A conversion cycle takes averages x (shunt + bus conversion time + overhead) in the selected mode, and the results
+    are the mean of the waveforms over the cycle
+  - CVRF is set per cycle and cleared by the Mask read or the Configuration write. OVF on the arithmetic overflow
+  - Alert functions with latch (LEN) and transparent modes. The alert callback is called on each assertion
+ */
+class INA226 : public Device {
+public:
+    static constexpr uint16_t DEFAULT_CONFIG{0x4127};
+    static constexpr uint16_t MANUFACTURER_ID{0x5449};
+    static constexpr uint16_t DIE_ID{0x2260};
+    //! @brief Per averaged sample overhead (us) as the driver expects in calculate_interval
+    static constexpr uint32_t OVERHEAD_PER_SAMPLE{400};
+
+    using alert_function_t = std::function<void()>;
+
+    //! @param shuntRes Shunt resistor (O)
+    explicit INA226(const double shuntRes) : _shunt_res(shuntRes)
+    {
+        reset();
+    }
+
+    //! @brief Reset to the power-on state
+    void reset()
+    {
+        _pointer   = 0;
+        _config    = DEFAULT_CONFIG;
+        _shunt     = _current = 0;
+        _bus       = _power = _cal = _mask = _limit = 0;
+        _alert_pin = false;
+        start_cycle(now());
+        ++_resets;
+    }
+
+    //! @brief Load current (A)
+    inline void current(waveform_t w)
+    {
+        _current_wf = w;
+    }
+    //! @brief Bus voltage (V)
+    inline void voltage(waveform_t w)
+    {
+        _voltage_wf = w;
+    }
+    inline void onAlert(alert_function_t f)
+    {
+        _alert = f;
+    }
+
+    //! @brief Number of completed conversion cycles
+    inline uint32_t conversions() const
+    {
+        return _conversions;
+    }
+    //! @brief Conversion cycles that were overwritten before the data was read
+    inline uint32_t unread() const
+    {
+        return _unread;
+    }
+    inline uint32_t resets() const
+    {
+        return _resets;
+    }
+    inline bool alertPin() const
+    {
+        return _alert_pin;
+    }
+
+    //! @brief Conversion cycle time (us) of the current configuration
+    uint32_t cycleMicros() const
+    {
+        static constexpr uint32_t avg_table[8]  = {1, 4, 16, 64, 128, 256, 512, 1024};
+        static constexpr uint32_t conv_table[8] = {140, 204, 332, 588, 1100, 2116, 4156, 8244};
+        const uint32_t avg                      = avg_table[(_config >> 9) & 0x07];
+        const uint32_t bus                      = (_config & 0x02) ? conv_table[(_config >> 6) & 0x07] : 0;
+        const uint32_t shunt                    = (_config & 0x01) ? conv_table[(_config >> 3) & 0x07] : 0;
+        return (bus || shunt) ? avg * (bus + shunt + OVERHEAD_PER_SAMPLE) : 0;
+    }
+
+    // Device
+    virtual bool write(const uint8_t* data, const size_t len) override
+    {
+        if (!len) {
+            return true;
+        }
+        update();
+        _pointer = data[0];
+        if (len < 3) {
+            return true;  // Pointer only
+        }
+        const uint16_t v = ((uint16_t)data[1] << 8) | data[2];
+        switch (_pointer) {
+            case 0x00:
+                if (v & 0x8000) {
+                    reset();
+                    _pointer = 0;
+                    return true;
+                }
+                _config = (v & 0x0FFF) | 0x4000;
+                _mask &= ~CVRF;  // Cleared by the configuration write
+                update_alert(false);
+                start_cycle(now());
+                break;
+            case 0x05:
+                _cal = v & 0x7FFF;
+                break;
+            case 0x06:
+                _mask = (_mask & 0x001C) | (v & 0xFC03);
+                break;
+            case 0x07:
+                _limit = v;
+                break;
+            default:  // Read only
+                break;
+        }
+        return true;
+    }
+
+    virtual bool read(uint8_t* data, const size_t len) override
+    {
+        update();
+        uint16_t v{};
+        switch (_pointer) {
+            case 0x00:
+                v = _config;
+                break;
+            case 0x01:
+                v = (uint16_t)_shunt;
+                _read_since = true;
+                break;
+            case 0x02:
+                v = _bus;
+                _read_since = true;
+                break;
+            case 0x03:
+                v = _power;
+                _read_since = true;
+                break;
+            case 0x04:
+                v = (uint16_t)_current;
+                _read_since = true;
+                break;
+            case 0x05:
+                v = _cal;
+                break;
+            case 0x06:
+                v = _mask;
+                // Reading clears CVRF, and AFF (latched)
+                _mask &= ~(CVRF | AFF);
+                update_alert(false);
+                break;
+            case 0x07:
+                v = _limit;
+                break;
+            case 0xFE:
+                v = MANUFACTURER_ID;
+                break;
+            case 0xFF:
+                v = DIE_ID;
+                break;
+        }
+        for (size_t i = 0; i < len; ++i) {
+            data[i] = (i & 1) ? (uint8_t)v : (uint8_t)(v >> 8);
+        }
+        return true;
+    }
+
+    virtual void tick() override
+    {
+        update();
+    }
+
+protected:
+    static constexpr uint16_t AFF{1U << 4};
+    static constexpr uint16_t CVRF{1U << 3};
+    static constexpr uint16_t OVF{1U << 2};
+    static constexpr uint16_t LEN{1U << 0};
+
+    static inline uint32_t now()
+    {
+        return (uint32_t)m5::utility::micros();
+    }
+    inline uint8_t mode() const
+    {
+        return _config & 0x07;
+    }
+    inline bool continuous() const
+    {
+        return mode() > 4;
+    }
+
+    void start_cycle(const uint32_t t)
+    {
+        _cycle_at = t;
+        _running  = (mode() & 0x03) != 0;
+    }
+
+    // Evaluate the cycles completed until now
+    void update()
+    {
+        const uint32_t cycle = cycleMicros();
+        if (!_running || !cycle) {
+            return;
+        }
+        const uint32_t t = now();
+        while (_running && t - _cycle_at >= cycle) {
+            convert(_cycle_at, _cycle_at + cycle);
+            _cycle_at += cycle;
+            _running = continuous();
+        }
+    }
+
+    void convert(const uint32_t from, const uint32_t to)
+    {
+        static constexpr uint32_t avg_table[8] = {1, 4, 16, 64, 128, 256, 512, 1024};
+        const uint32_t points                  = std::min<uint32_t>(avg_table[(_config >> 9) & 0x07], 64);
+
+        if (_conversions && !_read_since) {
+            ++_unread;
+        }
+        _read_since = false;
+        ++_conversions;
+
+        if (_config & 0x01) {
+            const double vs = waveform::mean(_current_wf, from, to, points) * _shunt_res;
+            _shunt          = (int16_t)clamp(std::round(vs / 2.5e-6), -32768.0, 32767.0);
+        }
+        if (_config & 0x02) {
+            const double vb = waveform::mean(_voltage_wf, from, to, points);
+            _bus            = (uint16_t)clamp(std::round(vb / 1.25e-3), 0.0, 32767.0);
+        }
+        // Current = Shunt x CAL / 2048, Power = Current x Bus / 20000
+        const int32_t cur = (int32_t)_shunt * _cal / 2048;
+        const int64_t pwr = (int64_t)std::abs(cur) * _bus / 20000;
+        const bool ovf    = cur > 32767 || cur < -32768 || pwr > 65535;
+        _current          = (int16_t)clamp(cur, -32768, 32767);
+        _power            = (uint16_t)std::min<int64_t>(pwr, 65535);
+        _mask             = (_mask & ~OVF) | (ovf ? OVF : 0) | CVRF;
+        update_alert(true);
+    }
+
+    // Alert function and pin
+    void update_alert(const bool converted)
+    {
+        bool hit{};
+        const uint16_t func = _mask & 0xFC00;
+        if (func & 0x8000) {
+            hit = _shunt > (int16_t)_limit;
+        } else if (func & 0x4000) {
+            hit = _shunt < (int16_t)_limit;
+        } else if (func & 0x2000) {
+            hit = _bus > _limit;
+        } else if (func & 0x1000) {
+            hit = _bus < _limit;
+        } else if (func & 0x0800) {
+            hit = _power > _limit;
+        } else if (func & 0x0400) {
+            hit = _mask & CVRF;
+        }
+        // Limit functions are evaluated at the conversion only
+        if (!(func & 0x0400) && !converted) {
+            hit = false;
+        }
+
+        bool asserted{};
+        if (_mask & LEN) {
+            asserted = (_mask & AFF) || hit;
+        } else {
+            asserted = hit;
+        }
+        _mask = (_mask & ~AFF) | (asserted ? AFF : 0);
+        if (asserted && !_alert_pin && _alert) {
+            _alert();
+        }
+        _alert_pin = asserted;
+    }
+
+    template <typename T>
+    static T clamp(const T v, const T lo, const T hi)
+    {
+        return v < lo ? lo : (v > hi ? hi : v);
+    }
+
+private:
+    double _shunt_res{};
+    uint8_t _pointer{};
+    uint16_t _config{DEFAULT_CONFIG}, _bus{}, _power{}, _cal{}, _mask{}, _limit{};
+    int16_t _shunt{}, _current{};
+    bool _running{}, _alert_pin{}, _read_since{};
+    uint32_t _cycle_at{}, _conversions{}, _unread{}, _resets{};
+    waveform_t _current_wf{}, _voltage_wf{};
+    alert_function_t _alert{};
+};
+
+}  // namespace sim
+}  // namespace unit
+}  // namespace m5
+#endif
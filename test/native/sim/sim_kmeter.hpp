@@ -0,0 +1,325 @@
+/*
+ * SPDX-FileCopyrightText: 2024 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+/*
+  Simulated KmeterISO / DualKmeter firmware for native test/benchmark
+*/
+#ifndef M5_UNIT_METER_TEST_SIM_KMETER_HPP
+#define M5_UNIT_METER_TEST_SIM_KMETER_HPP
+
+#include "sim_bus.hpp"
+#include "sim_waveform.hpp"
+#include <array>
+#include <cmath>
+#include <cstdio>
+
+namespace m5 {
+namespace unit {
+namespace sim {
+
+/*!
+  @class Kmeter
+  @brief Common model of the STM32 firmware of KmeterISO and DualKmeter
+  @details
+  - Byte-addressed register map, reads continue from the register pointer
+  - The firmware converts the selected thermocouple every conversion period, the temperature registers hold the latest
+    completed conversion (int32 LE x 100, Celsius and Fahrenheit), and the string registers its text
+  - The status register reads busy (non-zero) until the first conversion after power-on or a channel switch
+    completes, or the fault code if set
+  - Status register reads are counted to measure the poll behaviour of the driver
+ */
+class Kmeter : public Device {
+public:
+    static constexpr uint8_t STATUS_BUSY{0x01};
+
+    //! @brief Reset to the power-on state
+    void reset()
+    {
+        _pointer            = 0;
+        _epoch              = now();
+        _conversions_before = 0;
+        ++_resets;
+    }
+
+    //! @brief Thermocouple temperature (Celsius) of the channel
+    inline void temperature(waveform_t w, const uint8_t ch = 0)
+    {
+        _temperature_wf[ch & 1] = w;
+    }
+    //! @brief Internal (cold junction) temperature (Celsius)
+    inline void internalTemperature(waveform_t w)
+    {
+        _internal_wf = w;
+    }
+    /*!
+      @brief Firmware timing
+      @param conversion Conversion period (us)
+      @param switching Delay after the channel switch before the next conversion starts (us)
+     */
+    inline void timing(const uint32_t conversion, const uint32_t switching)
+    {
+        _conversion_us = conversion ? conversion : 1;
+        _switching_us  = switching;
+    }
+    //! @brief Fault code to be read from the status register (0: none)
+    inline void fault(const uint8_t code)
+    {
+        _fault = code;
+    }
+
+    inline uint32_t conversionMicros() const
+    {
+        return _conversion_us;
+    }
+    inline uint32_t switchingMicros() const
+    {
+        return _switching_us;
+    }
+    //! @brief Number of completed conversions since power-on
+    inline uint32_t conversions() const
+    {
+        return _conversions_before + completed(now());
+    }
+    //! @brief Status register reads
+    inline uint32_t statusReads() const
+    {
+        return _status_reads;
+    }
+    //! @brief Status register reads that returned non-zero
+    inline uint32_t busyReads() const
+    {
+        return _busy_reads;
+    }
+    inline uint32_t resets() const
+    {
+        return _resets;
+    }
+    inline uint8_t channel() const
+    {
+        return _channel;
+    }
+
+    // Device
+    virtual bool write(const uint8_t* data, const size_t len) override
+    {
+        if (!len || !responding()) {
+            return false;
+        }
+        _pointer = data[0];
+        for (size_t i = 1; i < len; ++i) {
+            write_byte((uint8_t)(_pointer + i - 1), data[i]);
+        }
+        return true;
+    }
+
+    virtual bool read(uint8_t* data, const size_t len) override
+    {
+        if (!responding()) {
+            return false;
+        }
+        const uint32_t t = now();
+        for (size_t i = 0; i < len; ++i) {
+            data[i] = read_byte((uint8_t)(_pointer + i), t);
+        }
+        if (_pointer == status_reg()) {
+            ++_status_reads;
+            _busy_reads += data[0] ? 1 : 0;
+        }
+        return true;
+    }
+
+protected:
+    explicit Kmeter(const uint8_t fw) : _firmware(fw)
+    {
+    }
+
+    static inline uint32_t now()
+    {
+        return (uint32_t)m5::utility::micros();
+    }
+
+    virtual uint8_t status_reg() const = 0;
+    virtual uint8_t string_reg(const uint_fast8_t idx) const = 0;
+
+    // The firmware restarts the conversion cycle
+    void restart(const uint32_t at)
+    {
+        _conversions_before += completed(now());
+        _epoch = at;
+    }
+    inline uint32_t completed(const uint32_t t) const
+    {
+        return (int32_t)(t - _epoch) >= 0 ? (t - _epoch) / _conversion_us : 0;
+    }
+    inline bool responding() const
+    {
+        return (int32_t)(now() - _nack_until) >= 0;
+    }
+
+    // Value of the latest completed conversion
+    // idx 0:Temperature(C) 1:Temperature(F) 2:Internal(C) 3:Internal(F)
+    double value(const uint_fast8_t idx, const uint32_t t) const
+    {
+        const uint32_t n = completed(t);
+        if (!n) {
+            return 0.0;
+        }
+        const uint32_t at    = _epoch + n * _conversion_us;
+        const waveform_t& wf = (idx < 2) ? _temperature_wf[_channel] : _internal_wf;
+        const double c       = wf ? wf(at) : 0.0;
+        return (idx & 1) ? c * 9.0 / 5.0 + 32.0 : c;
+    }
+
+    virtual uint8_t read_byte(const uint8_t reg, const uint32_t t)
+    {
+        if (reg < 0x20 && (reg & 0x08) == 0) {
+            // 0x00/0x04/0x10/0x14 int32 LE x 100
+            const uint_fast8_t idx = ((reg >> 4) << 1) | ((reg >> 2) & 1);
+            const int32_t v        = (int32_t)std::lround(value(idx, t) * 100.0);
+            return (uint8_t)((uint32_t)v >> ((reg & 0x03) * 8));
+        }
+        if (reg == status_reg()) {
+            return _fault ? _fault : (completed(t) ? 0 : STATUS_BUSY);
+        }
+        for (uint_fast8_t i = 0; i < 4; ++i) {
+            if (reg >= string_reg(i) && reg < string_reg(i) + 0x10) {
+                char buf[17]{};
+                std::snprintf(buf, sizeof(buf), "%.2f", value(i, t));
+                return (uint8_t)buf[reg - string_reg(i)];
+            }
+        }
+        if (reg == 0xFE) {
+            return _firmware;
+        }
+        return 0;
+    }
+
+    virtual void write_byte(const uint8_t /*reg*/, const uint8_t /*v*/)
+    {
+    }
+
+protected:
+    uint8_t _pointer{}, _firmware{}, _channel{}, _fault{};
+    uint32_t _conversion_us{100 * 1000U}, _switching_us{};
+    uint32_t _epoch{}, _nack_until{}, _conversions_before{};
+    uint32_t _status_reads{}, _busy_reads{}, _resets{};
+    std::array<waveform_t, 2> _temperature_wf{};
+    waveform_t _internal_wf{};
+};
+
+/*!
+  @class KmeterISO
+  @brief KmeterISO firmware
+  @details Writing a valid address to the I2C address register moves the device to it after the restart time,
+  during which it does not respond
+ */
+class KmeterISO : public Kmeter {
+public:
+    explicit KmeterISO(const uint8_t addr = 0x66, const uint8_t fw = 0x01) : Kmeter(fw), _address(addr)
+    {
+        reset();
+    }
+
+    //! @brief Time not responding after the address change (us)
+    inline void restartMicros(const uint32_t us)
+    {
+        _restart_us = us;
+    }
+    inline uint8_t address() const
+    {
+        return _address;
+    }
+
+    virtual bool changedAddress(uint8_t& addr) override
+    {
+        if (_address_changed) {
+            _address_changed = false;
+            addr             = _address;
+            return true;
+        }
+        return false;
+    }
+
+protected:
+    virtual uint8_t status_reg() const override
+    {
+        return 0x20;
+    }
+    virtual uint8_t string_reg(const uint_fast8_t idx) const override
+    {
+        return 0x30 + idx * 0x10;
+    }
+
+    virtual uint8_t read_byte(const uint8_t reg, const uint32_t t) override
+    {
+        return (reg == 0xFF) ? _address : Kmeter::read_byte(reg, t);
+    }
+    virtual void write_byte(const uint8_t reg, const uint8_t v) override
+    {
+        if (reg == 0xFF && v >= 0x08 && v <= 0x77) {
+            _address         = v;
+            _address_changed = true;
+            _nack_until      = now() + _restart_us;
+            restart(_nack_until);
+        }
+    }
+
+private:
+    uint8_t _address{};
+    bool _address_changed{};
+    uint32_t _restart_us{5 * 1000U};
+};
+
+/*!
+  @class DualKmeter
+  @brief DualKmeter (Module 13.2) firmware
+  @details Writing the channel register switches the thermocouple, and the next conversion starts after the switching
+  delay
+ */
+class DualKmeter : public Kmeter {
+public:
+    explicit DualKmeter(const uint8_t fw = 0x01) : Kmeter(fw)
+    {
+        _switching_us = 20 * 1000U;
+        reset();
+    }
+
+    //! @brief Number of the channel switches
+    inline uint32_t switches() const
+    {
+        return _switches;
+    }
+
+protected:
+    virtual uint8_t status_reg() const override
+    {
+        return 0x30;
+    }
+    virtual uint8_t string_reg(const uint_fast8_t idx) const override
+    {
+        return 0x40 + idx * 0x10;
+    }
+
+    virtual uint8_t read_byte(const uint8_t reg, const uint32_t t) override
+    {
+        return (reg == 0x20) ? _channel : Kmeter::read_byte(reg, t);
+    }
+    virtual void write_byte(const uint8_t reg, const uint8_t v) override
+    {
+        if (reg == 0x20 && v < 2 && v != _channel) {
+            _channel = v;
+            ++_switches;
+            restart(now() + _switching_us);
+        }
+    }
+
+private:
+    uint32_t _switches{};
+};
+
+}  // namespace sim
+}  // namespace unit
+}  // namespace m5
+#endif
@@ -0,0 +1,87 @@
+/*
+ * SPDX-FileCopyrightText: 2024 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+/*
+  Test fixture of ADS1115, INA226, KmeterISO and DualKmeter sharing one simulated bus (native)
+*/
+#ifndef M5_UNIT_METER_TEST_SIM_METER_BUS_FIXTURE_HPP
+#define M5_UNIT_METER_TEST_SIM_METER_BUS_FIXTURE_HPP
+
+#include <gtest/gtest.h>
+#include <unit/unit_ADS1115.hpp>
+#include <unit/unit_INA226.hpp>
+#include <unit/unit_KmeterISO.hpp>
+#include <unit/unit_DualKmeter.hpp>
+#include "sim_ads1115.hpp"
+#include "sim_ina226.hpp"
+#include "sim_kmeter.hpp"
+
+namespace m5 {
+namespace unit {
+namespace sim {
+
+/*!
+  @class MeterBusFixture
+  @brief Four units on one bus, begun without starting the periodic measurements
+  @details Inputs: 0.512 V on the ADS1115, 0.25 A at 5 V on the INA226, 100 degrees (10 ms conversion) on the
+  KmeterISO, and 123.45/-40 degrees (10 ms conversion, 5 ms channel switch) on the DualKmeter
+ */
+class MeterBusFixture : public ::testing::Test {
+protected:
+    virtual void SetUp() override
+    {
+        ads_dev.input([](const uint8_t, const uint32_t) { return 0.512; });
+        ina_dev.current(waveform::constant(0.25));
+        ina_dev.voltage(waveform::constant(5.0));
+        iso_dev.timing(10 * 1000U, 0);
+        iso_dev.temperature(waveform::constant(100.0));
+        iso_dev.internalTemperature(waveform::constant(25.0));
+        dual_dev.timing(10 * 1000U, 5 * 1000U);
+        dual_dev.temperature(waveform::constant(123.45), 0);
+        dual_dev.temperature(waveform::constant(-40.0), 1);
+
+        bus.attach(ads.address(), &ads_dev);
+        bus.attach(ina.address(), &ina_dev);
+        bus.attach(iso.address(), &iso_dev);
+        bus.attach(dual.address(), &dual_dev);
+        ads.connect(bus);
+        ina.connect(bus);
+        iso.connect(bus);
+        dual.connect(bus);
+
+        auto ads_cfg           = ads.config();
+        ads_cfg.start_periodic = false;
+        ads.config(ads_cfg);
+        auto ina_cfg           = ina.config();
+        ina_cfg.start_periodic = false;
+        ina.config(ina_cfg);
+        auto iso_cfg           = iso.config();
+        iso_cfg.start_periodic = false;
+        iso.config(iso_cfg);
+        auto dual_cfg           = dual.config();
+        dual_cfg.start_periodic = false;
+        dual.config(dual_cfg);
+
+        ASSERT_TRUE(ads.begin());
+        ASSERT_TRUE(ina.begin());
+        ASSERT_TRUE(iso.begin());
+        ASSERT_TRUE(dual.begin());
+    }
+
+    Bus bus{};
+    ADS1115 ads_dev{};
+    INA226 ina_dev{0.080};
+    KmeterISO iso_dev{};
+    DualKmeter dual_dev{};
+    Simulated<UnitADS1115> ads{0x48};
+    Simulated<UnitINA226_1A> ina{};
+    Simulated<UnitKmeterISO> iso{};
+    Simulated<UnitDualKmeter> dual{};
+};
+
+}  // namespace sim
+}  // namespace unit
+}  // namespace m5
+#endif
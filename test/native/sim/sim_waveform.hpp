@@ -0,0 +1,118 @@
+/*
+ * SPDX-FileCopyrightText: 2024 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+/*
+  Input waveforms for the simulated devices
+*/
+#ifndef M5_UNIT_METER_TEST_SIM_WAVEFORM_HPP
+#define M5_UNIT_METER_TEST_SIM_WAVEFORM_HPP
+
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <istream>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace m5 {
+namespace unit {
+namespace sim {
+
+//! @brief Value at the time (us)
+using waveform_t = std::function<double(const uint32_t us)>;
+
+namespace waveform {
+
+//! @brief Constant value
+inline waveform_t constant(const double v)
+{
+    return [v](const uint32_t) { return v; };
+}
+
+//! @brief offset + amplitude * sin(2 pi hz t)
+inline waveform_t sine(const double offset, const double amplitude, const double hz)
+{
+    return [offset, amplitude, hz](const uint32_t us) {
+        return offset + amplitude * std::sin(2.0 * 3.14159265358979323846 * hz * us / 1e6);
+    };
+}
+
+//! @brief before until at (us), after from at
+inline waveform_t step(const double before, const double after, const uint32_t at)
+{
+    return [before, after, at](const uint32_t us) { return us < at ? before : after; };
+}
+
+/*!
+  @brief Recorded waveform
+  @details Lines of "time(s),value", linearly interpolated. Lines that are not numbers (e.g. header) are skipped.
+  Holds the first/last value outside the recorded range.
+  @param is Input stream
+  @param loop Repeat the recorded range if true
+ */
+inline waveform_t csv(std::istream& is, const bool loop = false)
+{
+    std::vector<std::pair<double, double>> points{};
+    std::string line{};
+    while (std::getline(is, line)) {
+        std::istringstream ls(line);
+        double t{}, v{};
+        char comma{};
+        if (ls >> t >> comma >> v && comma == ',') {
+            points.emplace_back(t * 1e6, v);
+        }
+    }
+    if (points.empty()) {
+        return constant(0.0);
+    }
+    return [points, loop](const uint32_t us) {
+        double t          = us;
+        const double span = points.back().first - points.front().first;
+        if (loop && span > 0.0) {
+            t = points.front().first + std::fmod(t - points.front().first, span);
+        }
+        if (t <= points.front().first) {
+            return points.front().second;
+        }
+        for (size_t i = 1; i < points.size(); ++i) {
+            if (t <= points[i].first) {
+                const double r = (t - points[i - 1].first) / (points[i].first - points[i - 1].first);
+                return points[i - 1].second + r * (points[i].second - points[i - 1].second);
+            }
+        }
+        return points.back().second;
+    };
+}
+
+//! @brief Recorded waveform from file
+inline waveform_t csv(const char* path, const bool loop = false)
+{
+    std::ifstream ifs(path);
+    return csv(ifs, loop);
+}
+
+//! @brief Mean of the waveform over [from, to) (us) with up to n points
+inline double mean(const waveform_t& w, const uint32_t from, const uint32_t to, uint32_t n)
+{
+    if (!w) {
+        return 0.0;
+    }
+    n = n ? n : 1;
+    const double step = (double)(to - from) / n;
+    double sum{};
+    for (uint32_t i = 0; i < n; ++i) {
+        sum += w(from + (uint32_t)(step * (i + 0.5)));
+    }
+    return sum / n;
+}
+
+}  // namespace waveform
+}  // namespace sim
+}  // namespace unit
+}  // namespace m5
+#endif
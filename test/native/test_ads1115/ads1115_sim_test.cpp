@@ -0,0 +1,528 @@
+/*
+ * SPDX-FileCopyrightText: 2024 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+/*
+  UnitTest for UnitADS1115 with the simulated device (native)
+*/
+#include <gtest/gtest.h>
+#include <M5UnitComponent.hpp>
+#include <unit/unit_ADS1115.hpp>
+#include "../sim/sim_ads1115.hpp"
+#include <cmath>
+#include <vector>
+
+using namespace m5::unit;
+using namespace m5::unit::ads111x;
+
+namespace {
+
+constexpr double PI{3.14159265358979323846};
+constexpr uint8_t ADDRESS{0x48};
+
+// Run update() for the duration, and returns the number of updates
+template <class U>
+uint32_t run_for(U& unit, m5::unit::sim::Bus& bus, const uint32_t ms)
+{
+    uint32_t cnt{};
+    auto timeout_at = m5::utility::millis() + ms;
+    do {
+        bus.tick();
+        unit.update();
+        cnt += unit.updated() ? 1 : 0;
+    } while (m5::utility::millis() < timeout_at);
+    return cnt;
+}
+
+}  // namespace
+
+class TestADS1115Sim : public ::testing::Test {
+protected:
+    virtual void SetUp() override
+    {
+        // 1.0 V DC + 10 Hz 0.5 V sine on every input
+        dev.input([](const uint8_t, const uint32_t us) { return 1.0 + 0.5 * std::sin(2 * PI * 10 * us / 1e6); });
+        bus.attach(ADDRESS, &dev);
+        unit.connect(bus);
+
+        auto ccfg        = unit.component_config();
+        ccfg.stored_size = 8;
+        unit.component_config(ccfg);
+        ASSERT_TRUE(unit.begin());
+    }
+
+    sim::Bus bus{};
+    sim::ADS1115 dev{};
+    sim::Simulated<UnitADS1115> unit{ADDRESS};
+};
+
+TEST_F(TestADS1115Sim, Begin)
+{
+    EXPECT_TRUE(unit.inPeriodic());
+    EXPECT_FALSE(unit.isConfigDirty());
+    EXPECT_EQ(unit.configRegister().value & 0x7FFF, dev.config() & 0x7FFF);
+
+    bool match{};
+    EXPECT_TRUE(unit.verifyConfig(match));
+    EXPECT_TRUE(match);
+}
+
+TEST_F(TestADS1115Sim, Configuration)
+{
+    EXPECT_TRUE(unit.stopPeriodicMeasurement());
+
+    EXPECT_TRUE(unit.writeSamplingRate(Sampling::Rate475));
+    EXPECT_TRUE(unit.writeGain(Gain::PGA_1024));
+    EXPECT_TRUE(unit.writeMultiplexer(Mux::GND_2));
+    EXPECT_EQ(unit.configRegister().value & 0x7FFF, dev.config() & 0x7FFF);
+
+    // One transaction for the batched write
+    bus.resetStats();
+    auto c = unit.configRegister();
+    c.dr(Sampling::Rate64).mux(Mux::AIN_03).pga(Gain::PGA_4096);
+    EXPECT_TRUE(unit.writeConfigRegister(c));
+    EXPECT_EQ(bus.stats().transactions, 1U);
+    EXPECT_EQ(unit.configRegister().value & 0x7FFF, dev.config() & 0x7FFF);
+
+    int16_t high{}, low{};
+    EXPECT_TRUE(unit.writeThreshold(1234, -1234));
+    EXPECT_TRUE(unit.readThreshold(high, low));
+    EXPECT_EQ(high, 1234);
+    EXPECT_EQ(low, -1234);
+}
+
+TEST_F(TestADS1115Sim, Periodic)
+{
+    constexpr std::pair<Sampling, uint32_t> table[] = {
+        {Sampling::Rate128, 128},
+        {Sampling::Rate475, 475},
+        {Sampling::Rate860, 860},
+    };
+
+    for (auto&& e : table) {
+        SCOPED_TRACE(e.second);
+        EXPECT_TRUE(unit.stopPeriodicMeasurement());
+        EXPECT_TRUE(unit.startPeriodicMeasurement(e.first, Mux::AIN_01, Gain::PGA_2048, ComparatorQueue::Disable));
+        EXPECT_EQ(unit.intervalMicros(), 1000000U / e.second);
+
+        bus.resetStats();
+        const uint32_t before = dev.conversions();
+        auto cnt              = run_for(unit, bus, 250);
+        const uint32_t conv   = dev.conversions() - before;
+
+        // Phase-locked schedule reads each conversion once
+        EXPECT_NEAR(unit.effectiveSamplingRate(), (float)e.second, e.second * 0.05f);
+        EXPECT_LE(cnt, conv + 1);
+        EXPECT_GE(cnt, conv * 95 / 100);
+
+        // Pointer write + read per sample
+        EXPECT_EQ(dev.stats().transactions, cnt * 2);
+
+        EXPECT_TRUE(unit.full());
+        // 1.0 V +/- 0.5 V on PGA_2048
+        EXPECT_GE(unit.adc(), (int16_t)(0.45 / 2.048 * 32768));
+        EXPECT_LE(unit.adc(), (int16_t)(1.55 / 2.048 * 32768));
+    }
+}
+
+TEST_F(TestADS1115Sim, Singleshot)
+{
+    EXPECT_TRUE(unit.stopPeriodicMeasurement());
+    EXPECT_TRUE(unit.writeSamplingRate(Sampling::Rate128));
+
+    dev.input([](const uint8_t, const uint32_t) { return 0.512; });
+    Data d{};
+    const uint32_t before = dev.conversions();
+    EXPECT_TRUE(unit.measureSingleshot(d));
+    EXPECT_EQ(dev.conversions() - before, 1U);
+    EXPECT_EQ(d.adc(), 8192);
+}
+
+TEST_F(TestADS1115Sim, AsyncSingleshot)
+{
+    EXPECT_TRUE(unit.stopPeriodicMeasurement());
+    EXPECT_TRUE(unit.writeSamplingRate(Sampling::Rate8));  // 125 ms
+    dev.input([](const uint8_t, const uint32_t) { return 1.024; });
+
+    bool called{}, result{};
+    Data cd{};
+    unit.setSingleshotCallback([&](const bool ok, const Data& d) {
+        called = true;
+        result = ok;
+        cd     = d;
+    });
+
+    Data d{};
+    EXPECT_TRUE(unit.requestSingleshot());
+    EXPECT_FALSE(unit.requestSingleshot());  // Converting
+    EXPECT_FALSE(unit.measureSingleshot(d));
+    EXPECT_EQ(unit.singleshotState(), meter::SingleshotState::Converting);
+
+    // No bus access until the expected conversion time
+    bus.resetStats();
+    run_for(unit, bus, 100);
+    EXPECT_FALSE(unit.trySingleshotResult(d));
+    EXPECT_FALSE(called);
+    EXPECT_EQ(dev.stats().transactions, 0U);
+
+    auto timeout_at = m5::utility::millis() + 100;
+    while (!called && m5::utility::millis() < timeout_at) {
+        bus.tick();
+        unit.update();
+    }
+    EXPECT_TRUE(called);
+    EXPECT_TRUE(result);
+    EXPECT_EQ(cd.adc(), 16384);
+    // Config register read(s) and the conversion register read, pointer write + read each
+    EXPECT_LE(dev.stats().transactions, 2U * 4);
+
+    // The result is kept until taken
+    EXPECT_EQ(unit.singleshotState(), meter::SingleshotState::Completed);
+    EXPECT_TRUE(unit.trySingleshotResult(d));
+    EXPECT_EQ(d.adc(), 16384);
+    EXPECT_EQ(unit.singleshotState(), meter::SingleshotState::Idle);
+    EXPECT_FALSE(unit.trySingleshotResult(d));
+
+    // Polled without the callback
+    unit.setSingleshotCallback(nullptr);
+    EXPECT_TRUE(unit.writeSamplingRate(Sampling::Rate860));
+    EXPECT_TRUE(unit.requestSingleshot());
+    timeout_at = m5::utility::millis() + 100;
+    bool done{};
+    while (!(done = unit.trySingleshotResult(d)) && m5::utility::millis() < timeout_at) {
+        bus.tick();
+    }
+    EXPECT_TRUE(done);
+    EXPECT_EQ(d.adc(), 16384);
+
+    // Timed out
+    called = false;
+    unit.setSingleshotCallback([&](const bool ok, const Data&) {
+        called = true;
+        result = ok;
+    });
+    EXPECT_TRUE(unit.writeSamplingRate(Sampling::Rate8));
+    EXPECT_TRUE(unit.requestSingleshot(10));
+    run_for(unit, bus, 20);
+    EXPECT_TRUE(called);
+    EXPECT_FALSE(result);
+    EXPECT_EQ(unit.singleshotState(), meter::SingleshotState::Failed);
+    EXPECT_FALSE(unit.trySingleshotResult(d));
+
+    // Canceled by the periodic measurement
+    EXPECT_TRUE(unit.requestSingleshot());
+    EXPECT_TRUE(unit.startPeriodicMeasurement());
+    EXPECT_EQ(unit.singleshotState(), meter::SingleshotState::Failed);
+    EXPECT_FALSE(unit.requestSingleshot());
+}
+
+TEST_F(TestADS1115Sim, GeneralReset)
+{
+    EXPECT_TRUE(unit.stopPeriodicMeasurement());
+    EXPECT_TRUE(unit.writeGain(Gain::PGA_256));
+
+    const uint32_t resets = dev.resets();
+    EXPECT_TRUE(unit.generalReset());
+    EXPECT_EQ(dev.resets(), resets + 1);
+    EXPECT_EQ(unit.configRegister().value & 0x7FFF, sim::ADS1115::DEFAULT_CONFIG & 0x7FFF);
+    EXPECT_EQ(unit.gain(), Gain::PGA_2048);
+
+    // The conversion-ready mode is cleared with the default thresholds and COMP_QUE
+    EXPECT_TRUE(unit.enableConversionReady(true));
+    EXPECT_TRUE(unit.generalReset());
+    EXPECT_FALSE(unit.inConversionReady());
+    EXPECT_TRUE(unit.writeThreshold(1234, -1234));
+    EXPECT_TRUE(unit.startPeriodicMeasurement(Sampling::Rate860, Mux::AIN_01, Gain::PGA_2048,
+                                              ComparatorQueue::Disable));
+    EXPECT_GT(run_for(unit, bus, 20), 0U);  // Not waiting for the notification
+    EXPECT_TRUE(unit.stopPeriodicMeasurement());
+
+    // Also by begin()
+    EXPECT_TRUE(unit.enableConversionReady(true));
+    EXPECT_TRUE(unit.begin());
+    EXPECT_FALSE(unit.inConversionReady());
+}
+
+TEST_F(TestADS1115Sim, ConversionReadyRestore)
+{
+    EXPECT_TRUE(unit.stopPeriodicMeasurement());
+    EXPECT_TRUE(unit.writeComparatorPolarity(true));
+    EXPECT_TRUE(unit.writeComparatorQueue(ComparatorQueue::Two));
+    EXPECT_TRUE(unit.writeLatchingComparator(true));
+    EXPECT_TRUE(unit.writeThreshold(1000, -1000));
+
+    EXPECT_TRUE(unit.enableConversionReady(true, false));
+    EXPECT_FALSE(unit.comparatorPolarity());
+    EXPECT_EQ(unit.comparatorQueue(), ComparatorQueue::One);
+    EXPECT_TRUE(unit.enableConversionReady(true, true));  // Change the polarity only
+
+    // The settings before enabling
+    EXPECT_TRUE(unit.enableConversionReady(false));
+    EXPECT_TRUE(unit.comparatorPolarity());
+    EXPECT_EQ(unit.comparatorQueue(), ComparatorQueue::Two);
+    EXPECT_TRUE(unit.latchingComparator());
+    int16_t high{}, low{};
+    EXPECT_TRUE(unit.readThreshold(high, low));
+    EXPECT_EQ(high, 1000);
+    EXPECT_EQ(low, -1000);
+    EXPECT_EQ(unit.configRegister().value & 0x7FFF, dev.config() & 0x7FFF);
+
+    // Not enabled, the default thresholds and COMP_QUE, and the polarity is kept
+    EXPECT_TRUE(unit.enableConversionReady(false));
+    EXPECT_TRUE(unit.comparatorPolarity());
+    EXPECT_EQ(unit.comparatorQueue(), ComparatorQueue::Disable);
+    EXPECT_TRUE(unit.readThreshold(high, low));
+    EXPECT_EQ(high, 0x7FFF);
+    EXPECT_EQ(low, (int16_t)0x8000);
+}
+
+TEST_F(TestADS1115Sim, ConversionReady)
+{
+    dev.onAlert([this]() { unit.onConversionReady(); });
+
+    EXPECT_TRUE(unit.stopPeriodicMeasurement());
+    EXPECT_TRUE(unit.startPeriodicMeasurement(Sampling::Rate860, Mux::AIN_01, Gain::PGA_2048,
+                                              ComparatorQueue::Disable));
+    EXPECT_TRUE(unit.enableConversionReady(true));
+
+    // The comparator settings for RDY are kept
+    EXPECT_FALSE(unit.writeThreshold(1234, -1234));
+    EXPECT_FALSE(unit.writeComparatorQueue(ComparatorQueue::Disable));
+    EXPECT_FALSE(unit.writeLatchingComparator(true));
+    EXPECT_FALSE(unit.writeConfigRegister(unit.configRegister().comp_que(ComparatorQueue::Disable)));
+    EXPECT_TRUE(unit.inConversionReady());
+    EXPECT_EQ(unit.comparatorQueue(), ComparatorQueue::One);
+
+    const uint32_t before = dev.conversions();
+    auto cnt              = run_for(unit, bus, 200);
+    const uint32_t conv   = dev.conversions() - before;
+
+    // Exactly one read per notified conversion (Overruns only if the host preempts the loop)
+    EXPECT_EQ(cnt + unit.conversionReadyOverruns(), conv);
+    EXPECT_LE(unit.conversionReadyOverruns(), conv / 20);
+
+    EXPECT_TRUE(unit.enableConversionReady(false));
+    dev.onAlert(nullptr);
+    EXPECT_TRUE(unit.writeThreshold(1234, -1234));
+}
+
+TEST_F(TestADS1115Sim, Drain)
+{
+    EXPECT_TRUE(unit.writeSamplingRate(Sampling::Rate860));
+    run_for(unit, bus, 30);  // Wrapped
+    EXPECT_TRUE(unit.stopPeriodicMeasurement());
+    ASSERT_TRUE(unit.full());
+
+    Data d[3]{};
+    EXPECT_EQ(unit.drain(d, 3), 3U);
+    EXPECT_EQ(unit.available(), 5U);
+    int16_t adc[16]{};
+    UnitADS1115::convertADC(adc, d, 3);
+    for (int i = 0; i < 3; ++i) {
+        EXPECT_EQ(adc[i], d[i].adc());
+    }
+
+    const int16_t oldest = unit.adc();
+    EXPECT_EQ(unit.drainADC(adc, 16), 5U);
+    EXPECT_EQ(adc[0], oldest);
+    EXPECT_TRUE(unit.empty());
+    EXPECT_EQ(unit.drainADC(adc, 16), 0U);
+}
+
+TEST_F(TestADS1115Sim, Spans)
+{
+    EXPECT_TRUE(unit.writeSamplingRate(Sampling::Rate860));
+    run_for(unit, bus, 30);  // Wrapped
+    EXPECT_TRUE(unit.stopPeriodicMeasurement());
+    ASSERT_TRUE(unit.full());
+
+    // Zero-copy view of the stored data in order
+    meter::Span<const Data> a{}, b{};
+    EXPECT_EQ(unit.spans(a, b), 8U);
+    EXPECT_EQ(a.size() + b.size(), 8U);
+    ASSERT_FALSE(a.empty());
+    EXPECT_EQ(a[0].raw, unit.oldest().raw);
+    EXPECT_EQ((b.empty() ? a[a.size() - 1] : b[b.size() - 1]).raw, unit.latest().raw);
+
+    // Bulk discard
+    const uint16_t fourth = (a.size() > 3 ? a[3] : b[3 - a.size()]).raw;
+    EXPECT_EQ(unit.discard(3), 3U);
+    EXPECT_EQ(unit.available(), 5U);
+    EXPECT_EQ(unit.oldest().raw, fourth);
+    EXPECT_EQ(unit.spans(a, b), 5U);
+    unit.discard();
+    EXPECT_EQ(unit.available(), 4U);
+    EXPECT_EQ(unit.discard(10), 4U);
+    EXPECT_TRUE(unit.empty());
+    EXPECT_EQ(unit.spans(a, b), 0U);
+    EXPECT_TRUE(a.empty());
+    EXPECT_TRUE(b.empty());
+}
+
+TEST_F(TestADS1115Sim, Scan)
+{
+    // 0.5 V on AIN0, 1.5 V on AIN1
+    dev.input([](const uint8_t mux, const uint32_t) { return mux == 4 ? 0.5 : (mux == 5 ? 1.5 : 0.0); });
+    constexpr ScanSlot slots[] = {
+        {Mux::GND_0, Gain::PGA_2048, Sampling::Rate860},
+        {Mux::GND_1, Gain::PGA_4096, Sampling::Rate860},
+    };
+    EXPECT_TRUE(unit.stopPeriodicMeasurement());
+    EXPECT_TRUE(unit.startScanMeasurement(slots, m5::stl::size(slots)));
+
+    // The scan owns the config register
+    Data d{};
+    EXPECT_FALSE(unit.startPeriodicMeasurement());
+    EXPECT_FALSE(unit.startPeriodicMeasurement(Sampling::Rate128, Mux::AIN_01, Gain::PGA_2048,
+                                               ComparatorQueue::Disable));
+    EXPECT_FALSE(unit.measureSingleshot(d));
+    EXPECT_FALSE(unit.requestSingleshot());
+    EXPECT_TRUE(unit.inScan());
+    EXPECT_FALSE(unit.inPeriodic());
+
+    // Forced update does not read the conversion in progress
+    bus.resetStats();
+    unit.update(true);
+    EXPECT_FALSE(unit.updated());
+    EXPECT_EQ(dev.stats().transactions, 0U);
+
+    run_for(unit, bus, 30);
+    for (uint8_t slot = 0; slot < 2; ++slot) {
+        SCOPED_TRACE(slot);
+        const int16_t expected = slot ? 12000 : 8000;  // 1.5/4.096, 0.5/2.048
+        meter::Span<const ScanData> a{}, b{};
+        const size_t n = unit.scanSpans(slot, a, b);
+        EXPECT_EQ(n, unit.scanAvailable(slot));
+        ASSERT_GE(n, 4U);
+        for (auto&& sd : a) {
+            EXPECT_EQ(sd.slot, slot);
+            EXPECT_EQ(sd.adc(), expected);
+        }
+        for (auto&& sd : b) {
+            EXPECT_EQ(sd.slot, slot);
+            EXPECT_EQ(sd.adc(), expected);
+        }
+        EXPECT_EQ(unit.scanDiscard(slot, 2), 2U);
+        ScanData out[16]{};
+        EXPECT_EQ(unit.scanDrain(slot, out, 16), n - 2);
+        EXPECT_EQ(out[0].gain, slots[slot].gain);
+        EXPECT_TRUE(unit.scanEmpty(slot));
+    }
+
+    EXPECT_TRUE(unit.stopScanMeasurement());
+    EXPECT_TRUE(unit.startPeriodicMeasurement());
+}
+
+TEST_F(TestADS1115Sim, ScanStartFailure)
+{
+    constexpr ScanSlot slots[] = {
+        {Mux::GND_0, Gain::PGA_2048, Sampling::Rate860},
+        {Mux::GND_1, Gain::PGA_4096, Sampling::Rate860},
+    };
+    EXPECT_TRUE(unit.stopPeriodicMeasurement());
+    EXPECT_TRUE(unit.startScanMeasurement(slots, m5::stl::size(slots)));
+
+    // NACK every other config write, so the start of the next slot fails after a successful read
+    uint32_t attempts{};
+    bus.writeFault([&attempts](const uint8_t, const uint8_t* data, const size_t len) {
+        return len == 3 && data[0] == 0x01 /* Config */ && (attempts++ & 1) == 0;
+    });
+    bus.resetStats();
+    auto cnt = run_for(unit, bus, 30);
+    bus.writeFault(nullptr);
+
+    // Each sample needs its own conversion, so the failed starts are retried and not read again
+    const uint32_t started = dev.registerWrites().at(0x01);
+    EXPECT_GT(attempts, started);
+    EXPECT_GT(cnt, 4U);
+    EXPECT_LE(cnt, started);
+
+    EXPECT_TRUE(unit.stopScanMeasurement());
+    EXPECT_TRUE(unit.startPeriodicMeasurement());
+}
+
+TEST_F(TestADS1115Sim, LongTimeout)
+{
+    EXPECT_EQ(meter::millisToMicros(1000U), 1000000U);
+    EXPECT_EQ(meter::millisToMicros(meter::MAX_SPAN_MILLIS), meter::MAX_SPAN_MILLIS * 1000U);
+    EXPECT_EQ(meter::millisToMicros(meter::MAX_SPAN_MILLIS + 1), meter::MAX_SPAN_MICROS);
+    EXPECT_EQ(meter::millisToMicros(0xFFFFFFFFU), meter::MAX_SPAN_MICROS);
+
+    // Clamped, not wrapped to an expired deadline
+    EXPECT_TRUE(unit.stopPeriodicMeasurement());
+    EXPECT_TRUE(unit.writeSamplingRate(Sampling::Rate8));  // 125 ms
+    EXPECT_TRUE(unit.requestSingleshot(0xFFFFFFFFU));
+    unit.update();
+    EXPECT_EQ(unit.singleshotState(), meter::SingleshotState::Converting);
+
+    Data d{};
+    auto timeout_at = m5::utility::millis() + 500;
+    while (!unit.trySingleshotResult(d) && m5::utility::millis() < timeout_at) {
+        bus.tick();
+    }
+    EXPECT_EQ(unit.singleshotState(), meter::SingleshotState::Idle);  // Completed and taken
+    EXPECT_TRUE(unit.measureSingleshot(d, 5 * 1000 * 1000U));
+}
+
+TEST_F(TestADS1115Sim, DecimationMuxChange)
+{
+    // 0.5 V on AIN_01, 1.0 V on GND_0
+    dev.input([](const uint8_t mux, const uint32_t) { return mux == 4 ? 1.0 : 0.5; });
+    EXPECT_TRUE(unit.writeSamplingRate(Sampling::Rate860));
+    EXPECT_TRUE(unit.writeDecimation(meter::Decimation::Boxcar, 4));
+    run_for(unit, bus, 10);
+    unit.flushAggregate();
+
+    // Partial block of AIN_01 is discarded on the change
+    EXPECT_TRUE(unit.writeMultiplexer(Mux::GND_0));
+    run_for(unit, bus, 30);
+    ASSERT_FALSE(unit.aggregateEmpty());
+    bool first{true};
+    while (!unit.aggregateEmpty()) {
+        const auto a = unit.oldestAggregate();
+        if (first) {
+            // The conversion in progress at the change may still be of AIN_01
+            EXPECT_GE(a.max, 15900);
+            first = false;
+        } else {
+            EXPECT_GE(a.min, 15900);  // 1.0 V on PGA_2048
+        }
+        EXPECT_EQ(a.count, 4U);
+        unit.discardAggregate();
+    }
+}
+
+TEST_F(TestADS1115Sim, AggregateBulk)
+{
+    meter::Span<const meter::Aggregate> a{}, b{};
+    meter::Aggregate out[8]{};
+    // Without the decimation
+    EXPECT_EQ(unit.aggregateSpans(a, b), 0U);
+    EXPECT_TRUE(a.empty() && b.empty());
+    EXPECT_EQ(unit.drainAggregate(out, 8), 0U);
+    EXPECT_EQ(unit.discardAggregate(1), 0U);
+
+    EXPECT_TRUE(unit.writeSamplingRate(Sampling::Rate860));
+    EXPECT_TRUE(unit.writeDecimation(meter::Decimation::Boxcar, 4));
+    run_for(unit, bus, 50);  // Wraps around the buffer of 8 records
+    EXPECT_TRUE(unit.stopPeriodicMeasurement());
+
+    const size_t n = unit.aggregateSpans(a, b);
+    EXPECT_EQ(n, unit.aggregateAvailable());
+    EXPECT_EQ(a.size() + b.size(), n);
+    ASSERT_GE(n, 4U);
+    std::vector<meter::Aggregate> spanned(a.begin(), a.end());
+    spanned.insert(spanned.end(), b.begin(), b.end());
+    for (auto&& r : spanned) {
+        EXPECT_EQ(r.count, 4U);
+    }
+
+    EXPECT_EQ(unit.discardAggregate(2), 2U);
+    EXPECT_EQ(unit.drainAggregate(out, 8), n - 2);
+    for (size_t i = 0; i < n - 2; ++i) {
+        EXPECT_EQ(out[i].sum, spanned[i + 2].sum);
+        EXPECT_EQ(out[i].count, spanned[i + 2].count);
+    }
+    EXPECT_TRUE(unit.aggregateEmpty());
+}
@@ -0,0 +1,195 @@
+/*
+ * SPDX-FileCopyrightText: 2024 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+/*
+  UnitTest for the fixed-point conversion of Ameter/Vmeter with the simulated devices (native)
+*/
+#include <gtest/gtest.h>
+#include <M5UnitComponent.hpp>
+#include <unit/unit_Ameter.hpp>
+#include <unit/unit_Vmeter.hpp>
+#include "../sim/sim_ads1115.hpp"
+#include "../sim/sim_eeprom.hpp"
+#include "../sim/sim_avmeter.hpp"
+#include <cmath>
+#include <vector>
+
+using namespace m5::unit;
+using namespace m5::unit::ads111x;
+
+namespace {
+
+constexpr int16_t hope_table[]   = {6144, 4096, 2048, 1024, 512, 256};
+constexpr int16_t actual_table[] = {6100, 4111, 2040, 1030, 500, 260};
+
+template <class U>
+using TestUnit = sim::SimulatedAVmeter<U>;
+
+// Within the rounding of the output and the precision of the scale
+::testing::AssertionResult near_micro(const int32_t v, const float expected)
+{
+    const float tol = 1.0f + std::fabs(expected) * 1e-5f;
+    if (std::fabs(v - expected) <= tol) {
+        return ::testing::AssertionSuccess();
+    }
+    return ::testing::AssertionFailure() << v << " vs " << expected;
+}
+
+}  // namespace
+
+class TestAVmeterSim : public ::testing::Test {
+protected:
+    virtual void SetUp() override
+    {
+        for (uint8_t g = 0; g < 6; ++g) {
+            eeprom_dev.calibration(g, hope_table[g], actual_table[g]);
+        }
+        ads_dev.input([this](const uint8_t, const uint32_t) { return vin; });
+        bus.attach(0x48, &ads_dev);
+        bus.attach(0x51, &eeprom_dev);
+    }
+
+    template <class U>
+    void setup_unit(U& unit)
+    {
+        unit.connect(bus, 0x48, 0x51);
+        auto ccfg        = unit.component_config();
+        ccfg.stored_size = 8;
+        unit.component_config(ccfg);
+        auto cfg           = unit.config();
+        cfg.start_periodic = false;
+        unit.config(cfg);
+        ASSERT_TRUE(unit.begin());
+    }
+
+    // Every gain of the table and the conversions agree with the float path
+    template <class U>
+    void check_conversion(U& unit)
+    {
+        std::vector<Data> data{};
+        std::vector<int16_t> raw{};
+        for (int32_t r = -32768; r <= 32767; r += 257) {
+            Data d{};
+            d.raw = (uint16_t)(int16_t)r;
+            data.push_back(d);
+            raw.push_back((int16_t)r);
+        }
+        std::vector<int32_t> out(data.size()), out_raw(data.size());
+        std::vector<float> out_f(data.size());
+
+        for (uint8_t g = 0; g < 6; ++g) {
+            SCOPED_TRACE(g);
+            const Gain gain = static_cast<Gain>(g);
+            ASSERT_TRUE(unit.writeGain(gain));
+            EXPECT_EQ(unit.scale(), unit.scale(gain));
+            EXPECT_FLOAT_EQ(unit.calibrationFactor(), (float)hope_table[g] / actual_table[g]);
+
+            EXPECT_FLOAT_EQ(unit.correction(), unit.resolution() * unit.calibrationFactor());
+            const float per_lsb = unit.correction() * 1000.f;
+            EXPECT_NEAR(unit.scale() / 65536.f, per_lsb, per_lsb * 1e-5f);
+
+            unit.toMicro(out.data(), data.data(), data.size());
+            unit.toMicro(out_raw.data(), raw.data(), raw.size());
+            unit.toMilli(out_f.data(), data.data(), data.size());
+            for (size_t i = 0; i < data.size(); ++i) {
+                const float expected = per_lsb * data[i].adc();
+                EXPECT_TRUE(near_micro(out[i], expected));
+                EXPECT_EQ(out[i], out_raw[i]);
+                EXPECT_EQ(out[i], unit.toMicro(data[i].adc()));
+                EXPECT_FLOAT_EQ(out_f[i], out[i] * 0.001f);
+            }
+        }
+        ASSERT_TRUE(unit.writeGain(Gain::PGA_2048));
+    }
+
+    // Wait for a sample of the input after the first conversion
+    template <class U>
+    bool wait_sample(U& unit)
+    {
+        auto timeout_at = m5::utility::millis() + 100;
+        uint32_t cnt{};
+        do {
+            bus.tick();
+            unit.update();
+            cnt += unit.updated() ? 1 : 0;
+        } while (cnt < 2 && m5::utility::millis() < timeout_at);
+        while (unit.available() > 1) {
+            unit.discard();
+        }
+        return cnt >= 2;
+    }
+
+    sim::Bus bus{};
+    sim::ADS1115 ads_dev{};
+    sim::EEPROM eeprom_dev{};
+    double vin{};
+};
+
+TEST_F(TestAVmeterSim, Ameter)
+{
+    TestUnit<UnitAmeter> unit{0x48, 0x51};
+    setup_unit(unit);
+    check_conversion(unit);
+
+    EXPECT_EQ(unit.currentMicro(), std::numeric_limits<int32_t>::min());  // Empty
+
+    vin = 0.5;  // 10 A
+    ASSERT_TRUE(unit.startPeriodicMeasurement());
+    ASSERT_TRUE(wait_sample(unit));
+    EXPECT_TRUE(near_micro(unit.currentMicro(), unit.current() * 1000.f));
+    EXPECT_NEAR(unit.currentMicro(), 10000000 * (2048.f / 2040), 10000);
+
+    // Bulk
+    ASSERT_TRUE(wait_sample(unit));
+    unit.update(true);
+    unit.update(true);
+    EXPECT_TRUE(unit.stopPeriodicMeasurement());
+    ASSERT_EQ(unit.available(), 3U);
+
+    int32_t micro[4]{};
+    const int32_t oldest_micro = unit.currentMicro();
+    EXPECT_EQ(unit.drainMicro(micro, 1), 1U);
+    EXPECT_EQ(micro[0], oldest_micro);
+
+    float f[4]{};
+    const float oldest = unit.current();
+    EXPECT_EQ(unit.drain(f, 1), 1U);
+    EXPECT_FLOAT_EQ(f[0], oldest);
+
+    Data d{};
+    EXPECT_EQ(unit.drain(&d, 4), 1U);
+    unit.convert(f, &d, 1);
+    EXPECT_FLOAT_EQ(f[0], unit.correction() * d.adc());
+    EXPECT_TRUE(unit.empty());
+}
+
+TEST_F(TestAVmeterSim, Vmeter)
+{
+    TestUnit<UnitVmeter> unit{0x48, 0x51};
+    setup_unit(unit);
+    check_conversion(unit);
+
+    vin = -0.5;
+    ASSERT_TRUE(unit.startPeriodicMeasurement());
+    ASSERT_TRUE(wait_sample(unit));
+    EXPECT_LT(unit.voltageMicro(), 0);
+    EXPECT_TRUE(near_micro(unit.voltageMicro(), unit.voltage() * 1000.f));
+    EXPECT_TRUE(unit.stopPeriodicMeasurement());
+}
+
+TEST_F(TestAVmeterSim, CalibrationChanged)
+{
+    TestUnit<UnitAmeter> unit{0x48, 0x51};
+    setup_unit(unit);
+    const int32_t before = unit.scale(Gain::PGA_512);
+
+    // The table is rebuilt when the calibration changes
+    eeprom_dev.calibration(4, 512, 520);
+    EXPECT_TRUE(unit.verifyCalibration());
+    const int32_t after = unit.scale(Gain::PGA_512);
+    EXPECT_NE(after, before);
+    EXPECT_NEAR((float)after / before, (512.f / 520) / (512.f / 500), 1e-5f);
+    EXPECT_EQ(unit.scale(), unit.scale(Gain::PGA_2048));  // Current gain is unchanged
+}
@@ -0,0 +1,596 @@
+/*
+ * SPDX-FileCopyrightText: 2024 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+/*
+  UnitTest of test/embedded/avmeter_template.hpp and the Ameter/Vmeter specific cases
+  with the simulated devices (native)
+  The cases are the same as the embedded ones, one for one
+*/
+#include <gtest/gtest.h>
+#include <M5UnitComponent.hpp>
+#include <unit/unit_Ameter.hpp>
+#include <unit/unit_Vmeter.hpp>
+#include "../sim/sim_ads1115.hpp"
+#include "../sim/sim_eeprom.hpp"
+#include "../sim/sim_avmeter.hpp"
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <tuple>
+#include <utility>
+
+using namespace m5::unit;
+using namespace m5::unit::ads111x;
+
+namespace {
+
+constexpr uint8_t ADDRESS{0x48};
+constexpr uint8_t EEPROM_ADDRESS{0x51};
+constexpr int16_t hope_table[]   = {6144, 4096, 2048, 1024, 512, 256};
+constexpr int16_t actual_table[] = {6100, 4111, 2040, 1030, 500, 260};
+
+inline void check_measurement_values(m5::unit::UnitAVmeterBase* u)
+{
+    EXPECT_NE(u->adc(), std::numeric_limits<int16_t>::min());
+}
+
+}  // namespace
+
+// Same as ComponentTestBase of the embedded test, on the simulated bus
+template <class U>
+class TestAVmeterSimBase : public ::testing::Test {
+protected:
+    virtual void SetUp() override
+    {
+        for (uint8_t g = 0; g < 6; ++g) {
+            eeprom_dev.calibration(g, hope_table[g], actual_table[g]);
+        }
+        ads_dev.input([](const uint8_t mux, const uint32_t) { return 0.25 * (mux + 1); });
+        bus.attach(ADDRESS, &ads_dev);
+        bus.attach(EEPROM_ADDRESS, &eeprom_dev);
+
+        unit.reset(new sim::SimulatedAVmeter<U>(ADDRESS, EEPROM_ADDRESS));
+        unit->connect(bus);
+        configure();
+        ASSERT_TRUE(unit->begin());
+    }
+    virtual void configure()
+    {
+    }
+
+    // Same as test_periodic_measurement of the embedded test helper
+    void periodic_measurement(const uint32_t times)
+    {
+        const uint32_t timeout_ms = unit->intervalMicros() / 1000 * times * 2 + 100;
+        auto timeout_at           = m5::utility::millis() + timeout_ms;
+        uint32_t cnt{};
+        do {
+            bus.tick();
+            unit->update();
+            if (unit->updated()) {
+                ++cnt;
+                check_measurement_values(unit.get());
+            }
+        } while (cnt < times && m5::utility::millis() <= timeout_at);
+        EXPECT_EQ(cnt, times);
+    }
+
+    sim::Bus bus{};
+    sim::ADS1115 ads_dev{};
+    sim::EEPROM eeprom_dev{};
+    std::unique_ptr<sim::SimulatedAVmeter<U>> unit{};
+};
+
+class TestAVmeterTemplateSim : public TestAVmeterSimBase<UnitAVmeterBase> {
+protected:
+    virtual void configure() override
+    {
+        auto ccfg        = unit->component_config();
+        ccfg.stored_size = 4;
+        unit->component_config(ccfg);
+    }
+};
+
+TEST_F(TestAVmeterTemplateSim, Address)
+{
+    m5::unit::UnitAVmeterBase tmp(0x00, 0x00);
+    EXPECT_FALSE(tmp.begin());
+}
+
+TEST_F(TestAVmeterTemplateSim, GeneralReset)
+{
+    EXPECT_TRUE(unit->stopPeriodicMeasurement());
+    EXPECT_FALSE(unit->inPeriodic());
+
+    // Rewriting config register
+    EXPECT_TRUE(unit->writeMultiplexer(Mux::AIN_23));
+    EXPECT_TRUE(unit->writeGain(Gain::PGA_256));
+    EXPECT_TRUE(unit->writeSamplingRate(Sampling::Rate475));
+    EXPECT_TRUE(unit->writeComparatorQueue(ComparatorQueue::Four));
+    EXPECT_TRUE(unit->writeThreshold(0x7123, 0x8123));
+
+    EXPECT_TRUE(unit->startPeriodicMeasurement());
+    EXPECT_TRUE(unit->inPeriodic());
+
+    EXPECT_TRUE(unit->generalReset());
+
+    constexpr uint16_t default_value{0x8583};
+    EXPECT_EQ(unit->multiplexer(), Mux::AIN_01);
+    EXPECT_EQ(unit->gain(), Gain::PGA_2048);
+    EXPECT_EQ(unit->samplingRate(), Sampling::Rate128);
+    EXPECT_EQ(unit->comparatorQueue(), ComparatorQueue::Disable);
+
+    uint16_t v{};
+    EXPECT_TRUE(unit->readRegister16BE(command::CONFIG_REG, v, 0));
+    EXPECT_EQ(v, default_value);
+
+    constexpr int16_t default_high = 0x7FFF;
+    constexpr int16_t default_low  = 0x8000;
+    int16_t high{}, low{};
+    EXPECT_TRUE(unit->readThreshold(high, low));
+    EXPECT_EQ(high, default_high);
+    EXPECT_EQ(low, default_low);
+}
+
+TEST_F(TestAVmeterTemplateSim, Configration)
+{
+    uint16_t prev{}, now{};
+    {
+        constexpr Mux mux_table[] = {
+            Mux::GND_0, Mux::GND_1, Mux::GND_2, Mux::GND_3, Mux::AIN_01, Mux::AIN_03, Mux::AIN_13, Mux::AIN_23,
+        };
+
+        SCOPED_TRACE("Mux");
+        EXPECT_TRUE(unit->readRegister16BE(command::CONFIG_REG, prev, 0));
+
+        for (auto&& e : mux_table) {
+            EXPECT_TRUE(unit->writeMultiplexer(e));
+
+            EXPECT_EQ(unit->multiplexer(), e);
+
+            EXPECT_TRUE(unit->readRegister16BE(command::CONFIG_REG, now, 0));
+            EXPECT_NE(now, prev);
+            prev = now;
+        }
+    }
+
+    {
+        constexpr Gain gain_table[] = {
+            Gain::PGA_6144, Gain::PGA_4096, Gain::PGA_2048, Gain::PGA_1024, Gain::PGA_512, Gain::PGA_256,
+        };
+
+        SCOPED_TRACE("Gain");
+        EXPECT_TRUE(unit->readRegister16BE(command::CONFIG_REG, prev, 0));
+
+        auto prev_c = unit->coefficient();
+        EXPECT_TRUE(std::isfinite(prev_c));
+
+        for (auto&& e : gain_table) {
+            EXPECT_TRUE(unit->writeGain(e));
+
+            EXPECT_EQ(unit->gain(), e);
+
+            EXPECT_TRUE(unit->readRegister16BE(command::CONFIG_REG, now, 0));
+            EXPECT_NE(now, prev);
+            prev = now;
+
+            auto now_c = unit->coefficient();
+            EXPECT_TRUE(std::isfinite(now_c));
+            EXPECT_NE(now_c, prev_c);
+            prev_c = now_c;
+        }
+    }
+
+    {
+        SCOPED_TRACE("Mode");
+        EXPECT_TRUE(unit->stopPeriodicMeasurement());
+        EXPECT_FALSE(unit->inPeriodic());
+
+        EXPECT_TRUE(unit->readRegister16BE(command::CONFIG_REG, prev, 0));
+
+        EXPECT_TRUE(unit->startPeriodicMeasurement());
+        EXPECT_TRUE(unit->inPeriodic());
+        EXPECT_TRUE(unit->readRegister16BE(command::CONFIG_REG, now, 0));
+        EXPECT_NE(now, prev);
+        prev = now;
+
+        EXPECT_TRUE(unit->stopPeriodicMeasurement());
+        EXPECT_FALSE(unit->inPeriodic());
+        EXPECT_TRUE(unit->readRegister16BE(command::CONFIG_REG, now, 0));
+        EXPECT_NE(now, prev);
+    }
+
+    {
+        constexpr Sampling rate_table[] = {
+            Sampling::Rate8,   Sampling::Rate16,  Sampling::Rate32,  Sampling::Rate64,
+            Sampling::Rate128, Sampling::Rate250, Sampling::Rate475, Sampling::Rate860,
+        };
+
+        SCOPED_TRACE("Rate");
+        EXPECT_TRUE(unit->readRegister16BE(command::CONFIG_REG, prev, 0));
+
+        for (auto&& e : rate_table) {
+            EXPECT_TRUE(unit->writeSamplingRate(e));
+
+            EXPECT_EQ(unit->samplingRate(), e);
+
+            EXPECT_TRUE(unit->readRegister16BE(command::CONFIG_REG, now, 0));
+            EXPECT_NE(now, prev);
+            prev = now;
+        }
+    }
+
+    constexpr bool bool_table[] = {true, false};
+    {
+        SCOPED_TRACE("COMP_MODE");
+        EXPECT_TRUE(unit->readRegister16BE(command::CONFIG_REG, prev, 0));
+
+        for (auto&& e : bool_table) {
+            EXPECT_TRUE(unit->writeComparatorMode(e));
+
+            EXPECT_EQ(unit->comparatorMode(), e);
+
+            EXPECT_TRUE(unit->readRegister16BE(command::CONFIG_REG, now, 0));
+            EXPECT_NE(now, prev);
+            prev = now;
+        }
+    }
+
+    {
+        SCOPED_TRACE("COMP_POL");
+        EXPECT_TRUE(unit->readRegister16BE(command::CONFIG_REG, prev, 0));
+
+        for (auto&& e : bool_table) {
+            EXPECT_TRUE(unit->writeComparatorPolarity(e));
+
+            EXPECT_EQ(unit->comparatorPolarity(), e);
+
+            EXPECT_TRUE(unit->readRegister16BE(command::CONFIG_REG, now, 0));
+            EXPECT_NE(now, prev);
+            prev = now;
+        }
+    }
+
+    {
+        SCOPED_TRACE("COMP_LAT");
+        EXPECT_TRUE(unit->readRegister16BE(command::CONFIG_REG, prev, 0));
+
+        for (auto&& e : bool_table) {
+            EXPECT_TRUE(unit->writeLatchingComparator(e));
+
+            EXPECT_EQ(unit->latchingComparator(), e);
+
+            EXPECT_TRUE(unit->readRegister16BE(command::CONFIG_REG, now, 0));
+            EXPECT_NE(now, prev);
+            prev = now;
+        }
+    }
+
+    {
+        constexpr ComparatorQueue que_table[] = {
+            ComparatorQueue::One,
+            ComparatorQueue::Two,
+            ComparatorQueue::Four,
+            ComparatorQueue::Disable,
+        };
+
+        SCOPED_TRACE("COMP_QUE");
+        EXPECT_TRUE(unit->readRegister16BE(command::CONFIG_REG, prev, 0));
+
+        for (auto&& e : que_table) {
+            EXPECT_TRUE(unit->writeComparatorQueue(e));
+
+            EXPECT_EQ(unit->comparatorQueue(), e);
+
+            EXPECT_TRUE(unit->readRegister16BE(command::CONFIG_REG, now, 0));
+            EXPECT_NE(now, prev);
+            prev = now;
+        }
+    }
+
+    {
+        std::pair<int16_t, int16_t> thres_table[] = {{100, -100}, {1000, -1000}, {0x7FFF, 0x8000}};
+        for (auto&& e : thres_table) {
+            EXPECT_TRUE(unit->writeThreshold(e.first, e.second));
+            int16_t high{}, low{};
+            EXPECT_TRUE(unit->readThreshold(high, low));
+            EXPECT_EQ(high, e.first);
+            EXPECT_EQ(low, e.second);
+        }
+    }
+}
+
+TEST_F(TestAVmeterTemplateSim, ShadowRegister)
+{
+    EXPECT_TRUE(unit->stopPeriodicMeasurement());
+    EXPECT_FALSE(unit->isConfigDirty());
+
+    bool match{};
+    EXPECT_TRUE(unit->writeMultiplexer(Mux::GND_2));
+    EXPECT_TRUE(unit->writeGain(Gain::PGA_1024));
+    EXPECT_TRUE(unit->writeSamplingRate(Sampling::Rate250));
+    EXPECT_TRUE(unit->verifyConfig(match));
+    EXPECT_TRUE(match);
+
+    // Rewrite behind the shadow
+    uint16_t v{};
+    EXPECT_TRUE(unit->readRegister16BE(command::CONFIG_REG, v, 0));
+    Config c{};
+    c.value = v;
+    c.os(false);
+    c.mux(Mux::AIN_13);
+    c.pga(Gain::PGA_4096);
+    EXPECT_TRUE(unit->writeRegister16BE(command::CONFIG_REG, c.value));
+
+    EXPECT_TRUE(unit->verifyConfig(match));
+    EXPECT_FALSE(match);
+    EXPECT_EQ(unit->multiplexer(), Mux::AIN_13);
+    EXPECT_EQ(unit->gain(), Gain::PGA_4096);
+    EXPECT_EQ(unit->samplingRate(), Sampling::Rate250);
+
+    EXPECT_TRUE(unit->verifyConfig(match));
+    EXPECT_TRUE(match);
+
+    EXPECT_TRUE(unit->resyncConfig());
+    EXPECT_FALSE(unit->isConfigDirty());
+    EXPECT_EQ(unit->multiplexer(), Mux::AIN_13);
+}
+
+TEST_F(TestAVmeterTemplateSim, ConfigTransaction)
+{
+    EXPECT_TRUE(unit->stopPeriodicMeasurement());
+
+    auto c = unit->configRegister();
+    c.dr(Sampling::Rate475).mux(Mux::GND_1).pga(Gain::PGA_512).comp_que(ComparatorQueue::Two);
+    EXPECT_TRUE(unit->writeConfigRegister(c));
+
+    EXPECT_EQ(unit->samplingRate(), Sampling::Rate475);
+    EXPECT_EQ(unit->multiplexer(), Mux::GND_1);
+    EXPECT_EQ(unit->gain(), Gain::PGA_512);
+    EXPECT_EQ(unit->comparatorQueue(), ComparatorQueue::Two);
+
+    uint16_t v{};
+    EXPECT_TRUE(unit->readRegister16BE(command::CONFIG_REG, v, 0));
+    EXPECT_EQ(v & 0x7FFF, c.value & 0x7FFF);
+
+    EXPECT_TRUE(unit->startPeriodicMeasurement(Sampling::Rate860, Mux::AIN_01, Gain::PGA_2048, ComparatorQueue::Disable));
+    EXPECT_TRUE(unit->inPeriodic());
+    EXPECT_EQ(unit->samplingRate(), Sampling::Rate860);
+    EXPECT_EQ(unit->multiplexer(), Mux::AIN_01);
+    EXPECT_EQ(unit->gain(), Gain::PGA_2048);
+    EXPECT_EQ(unit->comparatorQueue(), ComparatorQueue::Disable);
+    EXPECT_TRUE(unit->stopPeriodicMeasurement());
+}
+
+TEST_F(TestAVmeterTemplateSim, Periodic)
+{
+    constexpr uint32_t rate_table[] = {8, 16, 32, 64, 128, 250, 475, 860};
+
+    std::tuple<const char*, Sampling> table[] = {
+        {"8sps", Sampling::Rate8},     {"16sps", Sampling::Rate16},   {"32sps", Sampling::Rate32},
+        {"64sps", Sampling::Rate64},   {"128sps", Sampling::Rate128}, {"250sps", Sampling::Rate250},
+        {"475sps", Sampling::Rate475}, {"860sps", Sampling::Rate860},
+    };
+
+    EXPECT_TRUE(unit->stopPeriodicMeasurement());
+    EXPECT_FALSE(unit->inPeriodic());
+
+    EXPECT_EQ(unit->adc(), std::numeric_limits<int16_t>::min());
+
+    {
+        // float correction = unit->resolution() * unit->calibrationFactor();
+        for (auto&& e : table) {
+            const char* s{};
+            Sampling rate{};
+            std::tie(s, rate) = e;
+            SCOPED_TRACE(s);
+            EXPECT_TRUE(unit->writeSamplingRate(rate));
+            EXPECT_TRUE(unit->startPeriodicMeasurement());
+            EXPECT_TRUE(unit->inPeriodic());
+
+            EXPECT_EQ(unit->intervalMicros(), 1000000U / rate_table[m5::stl::to_underlying(rate)]);
+
+            periodic_measurement(4);
+            EXPECT_GT(unit->effectiveSamplingRate(), 0.0f);
+
+            EXPECT_TRUE(unit->stopPeriodicMeasurement());
+            EXPECT_FALSE(unit->inPeriodic());
+
+            EXPECT_TRUE(unit->full());
+            EXPECT_FALSE(unit->empty());
+            EXPECT_EQ(unit->available(), 4U);
+        }
+    }
+}
+
+TEST_F(TestAVmeterTemplateSim, ConversionReady)
+{
+    EXPECT_TRUE(unit->enableConversionReady(true));
+    EXPECT_TRUE(unit->inConversionReady());
+    EXPECT_NE(unit->comparatorQueue(), ComparatorQueue::Disable);
+
+    uint16_t hh{}, ll{};
+    EXPECT_TRUE(unit->readRegister16BE(command::HIGH_THRESHOLD_REG, hh, 0));
+    EXPECT_TRUE(unit->readRegister16BE(command::LOW_THRESHOLD_REG, ll, 0));
+    EXPECT_TRUE(hh & 0x8000);
+    EXPECT_FALSE(ll & 0x8000);
+
+    EXPECT_TRUE(unit->inPeriodic());
+    unit->flush();
+
+    // Not read without notification
+    for (int i = 0; i < 8; ++i) {
+        m5::utility::delay(2);
+        unit->update();
+        EXPECT_FALSE(unit->updated());
+    }
+    EXPECT_TRUE(unit->empty());
+
+    // Read once per notification
+    unit->onConversionReady();
+    unit->update();
+    EXPECT_TRUE(unit->updated());
+    unit->update();
+    EXPECT_FALSE(unit->updated());
+    EXPECT_EQ(unit->available(), 1U);
+
+    unit->onConversionReady();
+    unit->onConversionReady();
+    unit->update();
+    EXPECT_TRUE(unit->updated());
+    EXPECT_EQ(unit->conversionReadyOverruns(), 1U);
+
+    EXPECT_TRUE(unit->enableConversionReady(false));
+    EXPECT_FALSE(unit->inConversionReady());
+    EXPECT_EQ(unit->comparatorQueue(), ComparatorQueue::Disable);
+    int16_t high{}, low{};
+    EXPECT_TRUE(unit->readThreshold(high, low));
+    EXPECT_EQ(high, 0x7FFF);
+    EXPECT_EQ(low, (int16_t)0x8000);
+}
+
+TEST_F(TestAVmeterTemplateSim, Decimation)
+{
+    EXPECT_TRUE(unit->stopPeriodicMeasurement());
+
+    EXPECT_FALSE(unit->writeDecimation(meter::Decimation::Boxcar, 1));
+    EXPECT_FALSE(unit->writeDecimation(meter::Decimation::CIC2, meter::Decimator::MAX_CIC2_RATIO + 1));
+    EXPECT_EQ(unit->decimation(), meter::Decimation::None);
+
+    for (auto&& type : {meter::Decimation::Boxcar, meter::Decimation::CIC2}) {
+        SCOPED_TRACE(m5::stl::to_underlying(type));
+        EXPECT_TRUE(unit->writeDecimation(type, 8));
+        EXPECT_EQ(unit->decimation(), type);
+        EXPECT_EQ(unit->decimationRatio(), 8U);
+
+        EXPECT_TRUE(unit->startPeriodicMeasurement(Sampling::Rate860, Mux::AIN_01, Gain::PGA_2048,
+                                                   ComparatorQueue::Disable));
+        unit->flush();
+        unit->flushAggregate();
+
+        periodic_measurement(4);
+        EXPECT_TRUE(unit->stopPeriodicMeasurement());
+
+        EXPECT_EQ(unit->aggregateAvailable(), unit->available());
+        while (!unit->aggregateEmpty()) {
+            auto a = unit->oldestAggregate();
+            EXPECT_EQ(a.count, 8U);
+            EXPECT_LE(a.min, a.max);
+            EXPECT_LE(a.min, a.meanRaw());
+            EXPECT_GE(a.max, a.meanRaw());
+            EXPECT_EQ(a.meanRaw(), unit->adc());
+            unit->discardAggregate();
+            unit->discard();
+        }
+    }
+
+    EXPECT_TRUE(unit->writeDecimation(meter::Decimation::None, 0));
+    EXPECT_EQ(unit->decimation(), meter::Decimation::None);
+    EXPECT_EQ(unit->aggregateAvailable(), 0U);
+}
+
+TEST_F(TestAVmeterTemplateSim, Scan)
+{
+    constexpr ScanSlot slots[] = {
+        {Mux::AIN_01, Gain::PGA_2048, Sampling::Rate860},
+        {Mux::GND_0, Gain::PGA_4096, Sampling::Rate475},
+        {Mux::GND_1, Gain::PGA_1024, Sampling::Rate860},
+    };
+
+    EXPECT_FALSE(unit->startScanMeasurement(slots, m5::stl::size(slots)));  // In periodic
+    EXPECT_TRUE(unit->stopPeriodicMeasurement());
+    auto prev = unit->configRegister();
+
+    EXPECT_FALSE(unit->startScanMeasurement(slots, 0));
+    EXPECT_TRUE(unit->startScanMeasurement(slots, m5::stl::size(slots)));
+    EXPECT_TRUE(unit->inScan());
+    EXPECT_EQ(unit->scanSlots(), m5::stl::size(slots));
+
+    auto timeout_at = m5::utility::millis() + 1000;
+    bool done{};
+    do {
+        bus.tick();
+        unit->update();
+        done = true;
+        for (uint8_t i = 0; i < m5::stl::size(slots); ++i) {
+            done &= (unit->scanAvailable(i) == 4U);
+        }
+    } while (!done && m5::utility::millis() <= timeout_at);
+    EXPECT_TRUE(done);
+
+    EXPECT_TRUE(unit->stopScanMeasurement());
+    EXPECT_FALSE(unit->inScan());
+    EXPECT_EQ(unit->configRegister().value, prev.value);
+
+    for (uint8_t i = 0; i < m5::stl::size(slots); ++i) {
+        while (!unit->scanEmpty(i)) {
+            auto d = unit->scanOldest(i);
+            EXPECT_EQ(d.slot, i);
+            EXPECT_EQ(d.gain, slots[i].gain);
+            unit->scanDiscard(i);
+        }
+    }
+}
+
+TEST_F(TestAVmeterTemplateSim, SingleShot)
+{
+    m5::unit::ads111x::Data d{};
+
+    EXPECT_FALSE(unit->measureSingleshot(d));
+    EXPECT_TRUE(unit->stopPeriodicMeasurement());
+    EXPECT_FALSE(unit->inPeriodic());
+
+    //    float correction = unit->resolution() * unit->calibrationFactor();
+    int cnt{16};
+    while (cnt--) {
+        EXPECT_TRUE(unit->measureSingleshot(d));
+        //        M5_LOGI("raw:%d current:%f", raw, raw * correction);
+    }
+}
+
+// test/embedded/test_ameter
+using TestAmeterSim = TestAVmeterSimBase<UnitAmeter>;
+
+TEST_F(TestAmeterSim, Correction)
+{
+    constexpr Gain gain_table[] = {
+        Gain::PGA_6144, Gain::PGA_4096, Gain::PGA_2048, Gain::PGA_1024, Gain::PGA_512, Gain::PGA_256,
+    };
+
+    float prev = unit->correction();
+    EXPECT_TRUE(std::isfinite(prev));
+
+    for (auto&& e : gain_table) {
+        EXPECT_TRUE(unit->writeGain(e));
+        auto now = unit->correction();
+
+        EXPECT_TRUE(std::isfinite(now));
+        EXPECT_NE(now, prev);
+        prev = now;
+    }
+}
+
+// test/embedded/test_vmeter
+using TestVmeterSim = TestAVmeterSimBase<UnitVmeter>;
+
+TEST_F(TestVmeterSim, Correction)
+{
+    constexpr Gain gain_table[] = {
+        Gain::PGA_6144, Gain::PGA_4096, Gain::PGA_2048, Gain::PGA_1024, Gain::PGA_512, Gain::PGA_256,
+    };
+
+    float prev = unit->correction();
+    EXPECT_TRUE(std::isfinite(prev));
+
+    for (auto&& e : gain_table) {
+        EXPECT_TRUE(unit->writeGain(e));
+        auto now = unit->correction();
+
+        EXPECT_TRUE(std::isfinite(now));
+        EXPECT_NE(now, prev);
+
+        prev = now;
+    }
+}
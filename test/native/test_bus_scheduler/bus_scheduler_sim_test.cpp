@@ -0,0 +1,236 @@
+/*
+ * SPDX-FileCopyrightText: 2024 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+/*
+  UnitTest for BusScheduler with the simulated devices on one bus (native)
+*/
+#include <gtest/gtest.h>
+#include <M5UnitComponent.hpp>
+#include <unit/meter_bus_scheduler.hpp>
+#include "../sim/sim_meter_bus_fixture.hpp"
+
+using namespace m5::unit;
+using m5::unit::meter::BusScheduler;
+
+namespace {
+
+// Run the scheduler for the duration, and returns the number of updates
+uint32_t run_for(BusScheduler& sched, m5::unit::sim::Bus& bus, const uint32_t ms)
+{
+    uint32_t cnt{};
+    auto timeout_at = m5::utility::millis() + ms;
+    do {
+        bus.tick();
+        cnt += sched.update();
+    } while (m5::utility::millis() < timeout_at);
+    return cnt;
+}
+
+// Component without nextDue(), scheduled by updatedMillis() + interval()
+class Ticker : public Component {
+    M5_UNIT_COMPONENT_HPP_BUILDER(Ticker, 0x00);
+
+public:
+    void start(const uint32_t ms)
+    {
+        _periodic = true;
+        _interval = ms;
+        _latest   = 0;
+    }
+    virtual void update(const bool force = false) override
+    {
+        _updated = false;
+        const auto now = m5::utility::millis();
+        if (_periodic && (force || !_latest || now >= _latest + _interval)) {
+            _latest  = now;
+            _updated = true;
+            ++calls;
+        }
+    }
+    uint32_t calls{};
+};
+const char Ticker::name[] = "Ticker";
+const types::uid_t Ticker::uid{0};
+const types::attr_t Ticker::attr{0};
+
+}  // namespace
+
+class TestBusSchedulerSim : public sim::MeterBusFixture {
+protected:
+    virtual void SetUp() override
+    {
+        sim::MeterBusFixture::SetUp();
+        if (HasFatalFailure()) {
+            return;
+        }
+        EXPECT_TRUE(sched.add(ads));
+        EXPECT_TRUE(sched.add(ina));
+        EXPECT_TRUE(sched.add(iso));
+        EXPECT_TRUE(sched.add(dual));
+        EXPECT_FALSE(sched.add(ads));  // Already added
+        EXPECT_EQ(sched.size(), 4U);
+    }
+
+    void start()
+    {
+        ASSERT_TRUE(ads.writeSamplingRate(ads111x::Sampling::Rate128));  // 7.8 ms
+        ASSERT_TRUE(ads.startPeriodicMeasurement());
+        ASSERT_TRUE(ina.startPeriodicMeasurement(ina226::Sampling::Rate4, ina226::ConversionTime::US_1100,
+                                                 ina226::ConversionTime::US_1100));  // 8.8 ms
+        ASSERT_TRUE(iso.startPeriodicMeasurement(20, kmeter_iso::MeasurementUnit::Celsius));
+        ASSERT_TRUE(dual.startPeriodicMeasurement(50));
+    }
+
+    BusScheduler sched{};
+};
+
+TEST_F(TestBusSchedulerSim, Idle)
+{
+    // Nothing to do if not in periodic
+    uint32_t us{};
+    EXPECT_FALSE(sched.nextWakeup(us));
+    bus.resetStats();
+    EXPECT_EQ(run_for(sched, bus, 20), 0U);
+    EXPECT_EQ(bus.stats().transactions, 0U);
+}
+
+TEST_F(TestBusSchedulerSim, Interleave)
+{
+    constexpr uint32_t DURATION{500};
+    bus.clock(100 * 1000U);
+    start();
+    run_for(sched, bus, 30);  // Until the first conversions complete
+
+    sched.resetStats();
+    bus.resetStats();
+    run_for(sched, bus, DURATION);
+    sched.dump();
+
+    struct Expected {
+        const Component* unit;
+        uint32_t interval_us;
+    };
+    const Expected table[] = {
+        {&ads, ads.intervalMicros()}, {&ina, ina.intervalMicros()}, {&iso, 20 * 1000U}, {&dual, 50 * 1000U}};
+    for (auto&& e : table) {
+        SCOPED_TRACE(e.interval_us);
+        auto st = sched.stats(*e.unit);
+        ASSERT_NE(st, nullptr);
+        const uint32_t n = DURATION * 1000U / e.interval_us;
+        EXPECT_GE(st->updates, n - 1);
+        EXPECT_LE(st->updates, n + 1);
+        EXPECT_EQ(st->misses, 0U);
+        EXPECT_EQ(st->deferred, 0U);
+        EXPECT_GT(st->cost, 0U);
+        EXPECT_LT(st->late_max, e.interval_us);
+    }
+    // No useless accesses: pointer and read per sample on ADS, the Kmeters poll the status once per sample
+    EXPECT_EQ(ads_dev.stats().transactions, sched.stats(ads)->updates * 2);
+    EXPECT_LE(sched.stats(ina)->idles, 2U);
+    EXPECT_LE(sched.stats(iso)->idles, 1U);
+    EXPECT_LE(sched.stats(dual)->idles, 1U);
+
+    // Learned cost is that of the transactions (status and temperature read, 4 transactions on KmeterISO)
+    EXPECT_GT(sched.stats(iso)->cost, sched.stats(ads)->cost);
+
+    uint32_t us{};
+    EXPECT_TRUE(sched.nextWakeup(us));
+    EXPECT_LE(us, 20 * 1000U);
+}
+
+TEST_F(TestBusSchedulerSim, EarliestDeadlineFirst)
+{
+    bus.clock(100 * 1000U);
+    start();
+    run_for(sched, bus, 60);
+
+    // Every unit is due after the stall
+    m5::utility::delay(60);
+    const Component* units[] = {&ads, &ina, &iso, &dual};
+    uint32_t due[4]{};
+    EXPECT_TRUE(ads.nextDue(due[0]));
+    EXPECT_TRUE(ina.nextDue(due[1]));
+    EXPECT_TRUE(iso.nextDue(due[2]));
+    EXPECT_TRUE(dual.nextDue(due[3]));
+
+    // Served one by one in order of the deadline with a budget less than a transaction
+    sched.resetStats();
+    sched.budget(1);
+    bool served[4]{};
+    for (int pass = 0; pass < 4; ++pass) {
+        SCOPED_TRACE(pass);
+        EXPECT_EQ(sched.update(), 1U);
+        int idx{-1};
+        for (int i = 0; i < 4; ++i) {
+            if (!served[i] && sched.stats(*units[i])->updates) {
+                idx = i;
+            }
+        }
+        ASSERT_GE(idx, 0);
+        served[idx] = true;
+        // Earliest among the rest
+        for (int i = 0; i < 4; ++i) {
+            if (!served[i]) {
+                EXPECT_LE((int32_t)(due[idx] - due[i]), 0);
+                EXPECT_EQ(sched.stats(*units[i])->deferred, (uint32_t)pass + 1);
+            }
+        }
+    }
+    sched.budget(0);
+    EXPECT_EQ(sched.budget(), 0U);
+}
+
+TEST_F(TestBusSchedulerSim, DeadlineMiss)
+{
+    start();
+    run_for(sched, bus, 60);
+    sched.resetStats();
+
+    // Stalled longer than the interval of KmeterISO (20 ms), but not of DualKmeter (50 ms)
+    m5::utility::delay(30);
+    run_for(sched, bus, 10);
+
+    EXPECT_GE(sched.stats(iso)->misses, 1U);
+    EXPECT_GE(sched.stats(iso)->late_max, 20 * 1000U);
+    EXPECT_GE(sched.stats(ina)->misses, 1U);
+    EXPECT_GE(sched.stats(ads)->misses, 1U);
+    EXPECT_EQ(sched.stats(dual)->misses, 0U);
+
+    // Resynchronized, on time again (one miss is tolerated on the short intervals for the jitter of the host)
+    sched.resetStats();
+    run_for(sched, bus, 100);
+    EXPECT_EQ(sched.stats(iso)->misses, 0U);
+    EXPECT_LE(sched.stats(ina)->misses, 1U);
+    EXPECT_LE(sched.stats(ads)->misses, 1U);
+    EXPECT_GE(sched.stats(ina)->updates, 100 * 1000U / ina.intervalMicros() - 1);
+}
+
+TEST_F(TestBusSchedulerSim, Fallback)
+{
+    Ticker ticker{};
+    EXPECT_TRUE(sched.add(ticker));
+    ticker.start(10);
+    run_for(sched, bus, 105);
+    EXPECT_GE(ticker.calls, 10U);
+    EXPECT_LE(ticker.calls, 12U);
+    EXPECT_EQ(sched.stats(ticker)->updates, ticker.calls);
+    EXPECT_LE(sched.stats(ticker)->idles, 1U);  // Not called before the time
+    EXPECT_TRUE(sched.remove(ticker));
+
+    // An interval beyond the wrap-safe span is clamped, not overflowed into the past
+    Ticker slow{};
+    EXPECT_TRUE(sched.add(slow));
+    slow.start(50 * 60 * 1000U);  // 50 minutes
+    run_for(sched, bus, 5);
+    EXPECT_EQ(slow.calls, 1U);
+    uint32_t us{};
+    EXPECT_TRUE(sched.nextWakeup(us));
+    EXPECT_GT(us, meter::MAX_SPAN_MICROS - 1000 * 1000U);
+    EXPECT_LE(us, meter::MAX_SPAN_MICROS);
+    EXPECT_TRUE(sched.remove(slow));
+
+    EXPECT_FALSE(sched.remove(ticker));
+    EXPECT_EQ(sched.stats(ticker), nullptr);
+}
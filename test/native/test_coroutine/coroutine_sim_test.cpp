@@ -0,0 +1,241 @@
+/*
+ * SPDX-FileCopyrightText: 2024 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+/*
+  UnitTest for the coroutine layer with the simulated devices (native, C++20)
+*/
+#include <gtest/gtest.h>
+#include <M5UnitComponent.hpp>
+#include "../sim/sim_meter_bus_fixture.hpp"
+#include <string>
+#include <vector>
+
+#if M5_UNIT_METER_COROUTINE
+
+using namespace m5::unit;
+using m5::unit::meter::Scheduler;
+using m5::unit::meter::Task;
+
+namespace {
+
+uint32_t sim_now{};
+uint32_t sim_clock()
+{
+    return sim_now;
+}
+
+Task<int> twice(const int v, const uint32_t us)
+{
+    co_await meter::sleepFor(us);
+    co_return v * 2;
+}
+
+}  // namespace
+
+TEST(Coroutine, Scheduler)
+{
+    sim_now = 0xFFFFF000U;  // Wraps around while running
+    Scheduler sched{sim_clock};
+    std::vector<std::string> log{};
+
+    auto worker = [&](const char* name, const uint32_t us, const int n) -> Task<> {
+        for (int i = 0; i < n; ++i) {
+            co_await meter::sleepFor(us);
+            log.push_back(std::string(name) + std::to_string(i));
+        }
+    };
+    int result{};
+    auto nested = [&]() -> Task<> {
+        result = co_await twice(21, 2500);
+        log.push_back("nested");
+    };
+
+    sched.spawn(worker("a", 1000, 3));
+    sched.spawn(worker("b", 1500, 2));
+    sched.spawn(nested());
+    EXPECT_EQ(sched.size(), 3U);
+    EXPECT_TRUE(log.empty());  // Not started until polled
+
+    uint32_t us{};
+    EXPECT_TRUE(sched.nextWakeup(us));
+    EXPECT_EQ(us, 0U);
+    EXPECT_EQ(sched.poll(), 3U);  // Run until the first sleep
+
+    // Nothing before the time
+    sim_now += 999;
+    EXPECT_EQ(sched.poll(), 0U);
+    EXPECT_TRUE(sched.nextWakeup(us));
+    EXPECT_EQ(us, 1U);
+
+    while (!sched.empty()) {
+        sched.nextWakeup(us);
+        sim_now += us;
+        sched.poll();
+    }
+    // a2 and b1 are due at the same time, b1 requested earlier
+    const std::vector<std::string> expected = {"a0", "b0", "a1", "nested", "b1", "a2"};
+    EXPECT_EQ(log, expected);
+    EXPECT_EQ(result, 42);
+    EXPECT_FALSE(sched.nextWakeup(us));
+}
+
+TEST(Coroutine, Destroy)
+{
+    sim_now = 0;
+    bool resumed{};
+    auto sleeper = [&]() -> Task<> {
+        co_await meter::sleepFor(1000);
+        resumed = true;
+    };
+    {
+        Scheduler sched{sim_clock};
+        sched.spawn(sleeper());
+        sched.poll();
+        EXPECT_EQ(sched.size(), 1U);
+        // Destroyed while sleeping
+    }
+    EXPECT_FALSE(resumed);
+}
+
+using TestCoroutineSim = sim::MeterBusFixture;
+
+TEST_F(TestCoroutineSim, Singleshot)
+{
+    ASSERT_TRUE(ads.writeSamplingRate(ads111x::Sampling::Rate8));  // 125 ms
+    ASSERT_TRUE(ina.writeSamplingRate(ina226::Sampling::Rate16));
+    iso_dev.reset();  // Busy until the first conversion
+
+    Scheduler sched{};
+    ads111x::Data ad{};
+    ina226::Data id{};
+    kmeter_iso::Data kd{};
+    dual_kmeter::Data dd[2]{};
+    bool ok[5]{};
+    std::vector<int> order{};
+
+    // The closures must outlive the tasks
+    auto ads_task = [&]() -> Task<> {
+        ok[0] = co_await ads.measureSingleshotAsync(ad);
+        order.push_back(0);
+    };
+    auto ina_task = [&]() -> Task<> {
+        ok[1] = co_await ina.measureSingleshotAsync(id);
+        order.push_back(1);
+    };
+    auto iso_task = [&]() -> Task<> {
+        ok[2] = co_await iso.measureSingleshotAsync(kd);
+        order.push_back(2);
+    };
+    auto dual_task = [&]() -> Task<> {
+        // Sequential on the same unit
+        ok[3] = co_await dual.measureSingleshotAsync(dd[0], dual_kmeter::Channel::One);
+        ok[4] = co_await dual.measureSingleshotAsync(dd[1], dual_kmeter::Channel::Two);
+        order.push_back(3);
+    };
+    sched.spawn(ads_task());
+    sched.spawn(ina_task());
+    sched.spawn(iso_task());
+    sched.spawn(dual_task());
+
+    bus.resetStats();
+    while (!sched.empty()) {
+        bus.tick();
+        sched.poll();
+    }
+
+    for (auto&& b : ok) {
+        EXPECT_TRUE(b);
+    }
+    EXPECT_EQ(ad.adc(), 8192);
+    EXPECT_NEAR(id.current(), 250.f, ina.currentLSB() * 1000 * 2);
+    EXPECT_FLOAT_EQ(kd.temperature(), 100.0f);
+    EXPECT_FLOAT_EQ(dd[0].temperature(), 123.45f);
+    EXPECT_FLOAT_EQ(dd[1].temperature(), -40.0f);
+    EXPECT_EQ(dual_dev.channel(), 0U);  // Restored
+
+    // Overlapped: the others complete while the ADS1115 (125 ms) converts
+    ASSERT_EQ(order.size(), 4U);
+    EXPECT_EQ(order.back(), 0);
+    // Slept until the expected conversion time: config read and write, then config and conversion reads
+    EXPECT_LE(ads_dev.stats().transactions, 3U + 4);
+    // Once at the computed deadline: config read and write, Mask read and the measurement registers
+    EXPECT_LE(ina_dev.stats().transactions, 4U + 2 + 4 * 2);
+    // Only status polls at 1 ms on KmeterISO
+    EXPECT_LE(iso_dev.statusReads(), 10U + 2);
+}
+
+TEST_F(TestCoroutineSim, SchedulerClock)
+{
+    // The deadline of the reset is measured by the scheduler clock, not by the system clock
+    sim_now = 0xFFFFF000U;  // Wraps around while running
+    Scheduler sched{sim_clock};
+    bool ok{true}, done{};
+    auto ads_task = [&]() -> Task<> {
+        ok   = co_await ads.generalResetAsync();
+        done = true;
+    };
+    bus.detach(ads.address());  // No response
+    sched.spawn(ads_task());
+
+    const uint32_t start{sim_now};
+    uint32_t polls{};
+    while (!sched.empty()) {
+        uint32_t us{};
+        sched.nextWakeup(us);
+        sim_now += us;
+        polls += sched.poll() ? 1 : 0;
+    }
+    bus.attach(ads.address(), &ads_dev);
+
+    EXPECT_TRUE(done);
+    EXPECT_FALSE(ok);
+    // Timed out after 10 ms polling every 1 ms in the simulated time
+    EXPECT_GT(sim_now - start, 10 * 1000U);
+    EXPECT_LE(sim_now - start, 12 * 1000U);
+    EXPECT_GE(polls, 11U);
+    EXPECT_LE(polls, 13U);
+}
+
+TEST_F(TestCoroutineSim, Reset)
+{
+    Scheduler sched{};
+    bool ok[3]{};
+    ASSERT_TRUE(ads.writeGain(ads111x::Gain::PGA_256));
+    const uint32_t ads_resets = ads_dev.resets();
+    const uint32_t ina_resets = ina_dev.resets();
+
+    auto ads_task = [&]() -> Task<> { ok[0] = co_await ads.generalResetAsync(); };
+    auto ina_task = [&]() -> Task<> { ok[1] = co_await ina.softResetAsync(); };
+    auto iso_task = [&]() -> Task<> {
+        ok[2] = co_await iso.changeI2CAddressAsync(0x10);
+        kmeter_iso::Data d{};
+        ok[2] = ok[2] && co_await iso.measureSingleshotAsync(d);
+    };
+    sched.spawn(ads_task());
+    sched.spawn(ina_task());
+    sched.spawn(iso_task());
+    while (!sched.empty()) {
+        bus.tick();
+        sched.poll();
+    }
+
+    for (auto&& b : ok) {
+        EXPECT_TRUE(b);
+    }
+    EXPECT_EQ(ads_dev.resets(), ads_resets + 1);
+    EXPECT_EQ(ads.gain(), ads111x::Gain::PGA_2048);
+    EXPECT_EQ(ina_dev.resets(), ina_resets + 1);
+    EXPECT_EQ(iso.address(), 0x10);
+    EXPECT_EQ(iso_dev.address(), 0x10);
+}
+
+#else
+
+TEST(Coroutine, Unsupported)
+{
+    GTEST_SKIP() << "Requires C++20 coroutines";
+}
+
+#endif
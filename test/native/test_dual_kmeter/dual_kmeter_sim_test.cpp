@@ -0,0 +1,221 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+/*
+  UnitTest for UnitDualKmeter with the simulated device (native)
+*/
+#include <gtest/gtest.h>
+#include <M5UnitComponent.hpp>
+#include <unit/unit_DualKmeter.hpp>
+#include "../sim/sim_kmeter.hpp"
+
+using namespace m5::unit;
+using namespace m5::unit::dual_kmeter;
+using namespace m5::unit::dual_kmeter::command;
+
+namespace {
+
+constexpr uint32_t CONVERSION_US{10 * 1000U};
+constexpr uint32_t SWITCHING_US{5 * 1000U};
+
+// Run update() for the duration, and returns the number of updates
+template <class U>
+uint32_t run_for(U& unit, m5::unit::sim::Bus& bus, const uint32_t ms)
+{
+    uint32_t cnt{};
+    auto timeout_at = m5::utility::millis() + ms;
+    do {
+        bus.tick();
+        unit.update();
+        cnt += unit.updated() ? 1 : 0;
+    } while (m5::utility::millis() < timeout_at);
+    return cnt;
+}
+
+}  // namespace
+
+class TestDualKmeterSim : public ::testing::Test {
+protected:
+    virtual void SetUp() override
+    {
+        dev.timing(CONVERSION_US, SWITCHING_US);
+        dev.temperature(sim::waveform::constant(123.45), 0);
+        dev.temperature(sim::waveform::constant(-40.0), 1);
+        dev.internalTemperature(sim::waveform::constant(30.0));
+        bus.attach(unit.address(), &dev);
+        unit.connect(bus);
+
+        auto ccfg        = unit.component_config();
+        ccfg.stored_size = 8;
+        unit.component_config(ccfg);
+        auto cfg           = unit.config();
+        cfg.start_periodic = false;
+        unit.config(cfg);
+        ASSERT_TRUE(unit.begin());
+    }
+
+    sim::Bus bus{};
+    sim::DualKmeter dev{};
+    sim::Simulated<UnitDualKmeter> unit{};
+};
+
+TEST_F(TestDualKmeterSim, Channel)
+{
+    Channel ch{};
+    EXPECT_TRUE(unit.writeCurrentChannel(Channel::Two));
+    EXPECT_TRUE(unit.readCurrentChannel(ch));
+    EXPECT_EQ(ch, Channel::Two);
+    EXPECT_EQ(dev.channel(), 1U);
+
+    EXPECT_TRUE(unit.writeCurrentChannel(Channel::One));
+    EXPECT_TRUE(unit.readCurrentChannel(ch));
+    EXPECT_EQ(ch, Channel::One);
+    EXPECT_EQ(dev.switches(), 2U);
+}
+
+TEST_F(TestDualKmeterSim, Singleshot)
+{
+    run_for(unit, bus, CONVERSION_US / 1000 + 1);
+
+    Data d{};
+    EXPECT_TRUE(unit.measureSingleshot(d, Channel::One));
+    EXPECT_EQ(d.channel, Channel::One);
+    EXPECT_FLOAT_EQ(d.temperature(), 123.45f);
+
+    // Switching delay + conversion before the status gets ready
+    const uint32_t reads = dev.statusReads();
+    auto start_at        = m5::utility::micros();
+    EXPECT_TRUE(unit.measureSingleshot(d, Channel::Two, MeasurementUnit::Fahrenheit));
+    auto elapsed = m5::utility::micros() - start_at;
+    EXPECT_EQ(d.channel, Channel::Two);
+    EXPECT_FLOAT_EQ(d.temperature(), -40.0f);
+    EXPECT_GE(elapsed, SWITCHING_US + CONVERSION_US);
+    // 1 ms poll
+    EXPECT_LE(dev.statusReads() - reads, (SWITCHING_US + CONVERSION_US) / 1000 + 2);
+
+    // Switched back to the previous channel
+    EXPECT_EQ(dev.channel(), 0U);
+
+    EXPECT_TRUE(unit.measureInternalSingleshot(d, Channel::One));
+    EXPECT_FLOAT_EQ(d.temperature(), 30.0f);
+
+    // String register
+    char buf[17]{};
+    EXPECT_TRUE(unit.readRegister(TEMPERATURE_CELSIUS_STRING_REG, (uint8_t*)buf, 16, 0, false));
+    EXPECT_STREQ(buf, "123.45");
+}
+
+TEST_F(TestDualKmeterSim, Periodic)
+{
+    EXPECT_TRUE(unit.startPeriodicMeasurement(20, Channel::Two, MeasurementUnit::Celsius));
+
+    bus.resetStats();
+    auto cnt = run_for(unit, bus, 300);
+
+    // The first samples wait for the switching delay and the conversion
+    EXPECT_GE(cnt, 300 / 20 - 2);
+    EXPECT_LE(cnt, 300 / 20 + 1);
+    EXPECT_EQ(unit.oldest().channel, Channel::Two);
+    EXPECT_FLOAT_EQ(unit.temperature(), -40.0f);
+    // 1 ms polls while busy after the channel switch
+    EXPECT_GT(dev.busyReads(), 0U);
+    EXPECT_LE(dev.busyReads(), (SWITCHING_US + CONVERSION_US) / 1000 + 1);
+    EXPECT_TRUE(unit.stopPeriodicMeasurement());
+}
+
+TEST_F(TestDualKmeterSim, LongInterval)
+{
+    // Longest interval the microsecond schedule can hold
+    EXPECT_FALSE(unit.startPeriodicMeasurement(meter::MAX_SPAN_MILLIS + 1, Channel::One, MeasurementUnit::Celsius));
+    EXPECT_FALSE(unit.startAlternatingMeasurement(meter::MAX_SPAN_MILLIS + 1, MeasurementUnit::Celsius));
+    EXPECT_FALSE(unit.inPeriodic());
+
+    EXPECT_TRUE(unit.startPeriodicMeasurement(meter::MAX_SPAN_MILLIS, Channel::One, MeasurementUnit::Celsius));
+    EXPECT_EQ(unit.intervalMicros(), meter::MAX_SPAN_MILLIS * 1000U);
+    EXPECT_TRUE(unit.stopPeriodicMeasurement());
+}
+
+TEST_F(TestDualKmeterSim, Alternating)
+{
+    constexpr uint32_t SETTLE_US{SWITCHING_US + CONVERSION_US};
+
+    EXPECT_TRUE(unit.startAlternatingMeasurement(0));
+    EXPECT_TRUE(unit.inAlternating());
+    EXPECT_FALSE(unit.startAlternatingMeasurement(0));  // Already running
+
+    bus.resetStats();
+    const uint32_t switches = dev.switches();
+    auto cnt                = run_for(unit, bus, 300);
+
+    // As fast as the firmware settles after each switch
+    EXPECT_GE(cnt, 300 * 1000U / SETTLE_US - 2);
+    EXPECT_LE(cnt, 300 * 1000U / SETTLE_US + 1);
+    EXPECT_GE(dev.switches() - switches, cnt - 1);
+
+    // Interleaved in the measurement data buffer, and separated in the channel buffers
+    ASSERT_GE(unit.available(), 2U);
+    Channel prev = unit.oldest().channel;
+    unit.discard();
+    while (unit.available()) {
+        EXPECT_NE(unit.oldest().channel, prev);
+        prev = unit.oldest().channel;
+        unit.discard();
+    }
+    EXPECT_GE(unit.channelAvailable(Channel::One), cnt / 2 < 8 ? cnt / 2 : 8U);
+    EXPECT_GE(unit.channelAvailable(Channel::Two), (cnt - 1) / 2 < 8 ? (cnt - 1) / 2 : 8U);
+    EXPECT_FLOAT_EQ(unit.channelOldest(Channel::One).temperature(), 123.45f);
+    EXPECT_FLOAT_EQ(unit.channelLatest(Channel::Two).temperature(), -40.0f);
+    EXPECT_EQ(unit.channelLatest(Channel::Two).channel, Channel::Two);
+
+    // Settle latency at the resolution of the status poll
+    for (auto&& ch : {Channel::One, Channel::Two}) {
+        const auto& h = unit.settleLatency(ch);
+        EXPECT_GE(h.count, cnt / 2 - 2);
+        EXPECT_GE(h.min, SETTLE_US);
+        EXPECT_LE(h.max, SETTLE_US + 2000);
+    }
+    // The status is not polled before the settle latency once learned
+    EXPECT_LE(dev.statusReads(), cnt * 3 + SETTLE_US / 1000 * 2);
+
+    // Without copying
+    meter::Span<const Data> a{}, b{};
+    const size_t n = unit.channelSpans(Channel::Two, a, b);
+    EXPECT_EQ(n, unit.channelAvailable(Channel::Two));
+    EXPECT_EQ(a.size() + b.size(), n);
+    for (auto&& d : a) {
+        EXPECT_EQ(d.channel, Channel::Two);
+    }
+    for (auto&& d : b) {
+        EXPECT_EQ(d.channel, Channel::Two);
+    }
+    EXPECT_EQ(unit.channelDiscard(Channel::Two, 2), 2U);
+    EXPECT_EQ(unit.channelAvailable(Channel::Two), n - 2);
+
+    unit.channelDiscard(Channel::One);
+    EXPECT_LT(unit.channelAvailable(Channel::One), 8U);
+    unit.channelFlush();
+    EXPECT_TRUE(unit.channelEmpty(Channel::One));
+    EXPECT_TRUE(unit.channelEmpty(Channel::Two));
+
+    EXPECT_TRUE(unit.stopPeriodicMeasurement());
+    EXPECT_FALSE(unit.inAlternating());
+
+    // Limited by the interval
+    EXPECT_TRUE(unit.startAlternatingMeasurement(50, MeasurementUnit::Fahrenheit));
+    cnt = run_for(unit, bus, 300);
+    EXPECT_GE(cnt, 300 / 50 - 1);
+    EXPECT_LE(cnt, 300 / 50 + 1);
+    EXPECT_FLOAT_EQ(unit.channelLatest(Channel::Two).temperature(), -40.0f);
+    EXPECT_NEAR(unit.channelLatest(Channel::One).temperature(), 123.45f * 9 / 5 + 32, 0.01f);
+    // Already settled at the first poll, the time until the poll is not the settle latency
+    EXPECT_EQ(unit.settleLatency(Channel::One).count, 0U);
+    EXPECT_EQ(unit.settleLatency(Channel::Two).count, 0U);
+    EXPECT_TRUE(unit.stopPeriodicMeasurement());
+
+    // Normal periodic is not alternating
+    EXPECT_TRUE(unit.startPeriodicMeasurement(20, Channel::Two));
+    EXPECT_FALSE(unit.inAlternating());
+    EXPECT_TRUE(unit.stopPeriodicMeasurement());
+}
@@ -0,0 +1,287 @@
+/*
+ * SPDX-FileCopyrightText: 2024 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+/*
+  UnitTest for the calibration EEPROM of Ameter/Vmeter with the simulated device (native)
+*/
+#include <gtest/gtest.h>
+#include <M5UnitComponent.hpp>
+#include <unit/unit_EEPROM.hpp>
+#include <unit/unit_av_base.hpp>
+#include <unit/meter_calibration_cache.hpp>
+#include "../sim/sim_ads1115.hpp"
+#include "../sim/sim_eeprom.hpp"
+#include "../sim/sim_avmeter.hpp"
+#include <map>
+#include <string>
+#include <vector>
+
+using namespace m5::unit;
+using namespace m5::unit::ads111x;
+using m5::unit::meter::UnitEEPROM;
+
+namespace {
+
+constexpr uint8_t ADDRESS{0x51};
+constexpr int16_t hope_table[]   = {-6144, 4096, 2048, 1024, 512, 256};
+constexpr int16_t actual_table[] = {-6100, 4111, 2040, 1030, 500, 260};
+
+}  // namespace
+
+class TestEEPROMSim : public ::testing::Test {
+protected:
+    virtual void SetUp() override
+    {
+        for (uint8_t g = 0; g < 6; ++g) {
+            dev.calibration(g, hope_table[g], actual_table[g]);
+        }
+        bus.attach(ADDRESS, &dev);
+        unit.connect(bus, ADDRESS);
+    }
+
+    sim::Bus bus{};
+    sim::EEPROM dev{};
+    sim::Simulated<UnitEEPROM> unit{ADDRESS};
+};
+
+TEST_F(TestEEPROMSim, Bulk)
+{
+    bus.resetStats();
+    EXPECT_TRUE(unit.readCalibration());
+
+    // Pointer write and one sequential read of the whole block
+    EXPECT_EQ(dev.stats().transactions, 2U);
+    EXPECT_EQ(dev.stats().read_bytes, 48U);
+
+    for (uint8_t g = 0; g < 8; ++g) {
+        SCOPED_TRACE(g);
+        const Gain gain = static_cast<Gain>(g);
+        const uint8_t r = g < 6 ? g : 5;  // 6,7 are the same as 5
+        EXPECT_TRUE(unit.validCalibration(gain));
+        EXPECT_EQ(unit.hope(gain), hope_table[r]);
+        EXPECT_EQ(unit.actual(gain), actual_table[r]);
+        EXPECT_FLOAT_EQ(unit.calibrationFactor(gain), (float)hope_table[r] / actual_table[r]);
+    }
+}
+
+TEST_F(TestEEPROMSim, Invalid)
+{
+    dev.calibration(2, 2048, 2040, true);
+    dev.calibration(5, 256, 260, true);
+    EXPECT_FALSE(unit.readCalibration());
+
+    for (uint8_t g = 0; g < 8; ++g) {
+        SCOPED_TRACE(g);
+        const Gain gain  = static_cast<Gain>(g);
+        const bool valid = (g != 2 && g < 5);
+        EXPECT_EQ(unit.validCalibration(gain), valid);
+        if (!valid) {
+            EXPECT_FLOAT_EQ(unit.calibrationFactor(gain), 1.0f);
+        } else {
+            EXPECT_EQ(unit.hope(gain), hope_table[g]);
+        }
+    }
+
+    // Recovered
+    dev.calibration(2, 2048, 2040);
+    dev.calibration(5, 256, 260);
+    EXPECT_TRUE(unit.readCalibration());
+    EXPECT_TRUE(unit.validCalibration(Gain::PGA_256));
+}
+
+TEST_F(TestEEPROMSim, Fallback)
+{
+    // The sequential read fails, then each gain is read
+    dev.maxRead(8);
+    bus.resetStats();
+    EXPECT_TRUE(unit.readCalibration());
+    EXPECT_EQ(dev.stats().transactions, 2U + 6 * 2);
+    for (uint8_t g = 0; g < 6; ++g) {
+        EXPECT_EQ(unit.actual(static_cast<Gain>(g)), actual_table[g]);
+    }
+
+    // Nothing is read
+    bus.detach(ADDRESS);
+    EXPECT_FALSE(unit.readCalibration());
+    for (uint8_t g = 0; g < 8; ++g) {
+        EXPECT_FALSE(unit.validCalibration(static_cast<Gain>(g)));
+        EXPECT_FLOAT_EQ(unit.calibrationFactor(static_cast<Gain>(g)), 1.0f);
+    }
+}
+
+namespace {
+
+// Key-value store on the memory
+struct MemoryStore {
+    std::map<std::string, std::vector<uint8_t>> blobs{};
+
+    meter::KeyValueCalibrationCache cache()
+    {
+        return meter::KeyValueCalibrationCache(
+            [this](const char* k, uint8_t* b, const size_t n) {
+                auto it = blobs.find(k);
+                if (it == blobs.end() || it->second.size() != n) {
+                    return false;
+                }
+                std::copy(it->second.begin(), it->second.end(), b);
+                return true;
+            },
+            [this](const char* k, const uint8_t* b, const size_t n) {
+                blobs[k].assign(b, b + n);
+                return true;
+            },
+            [this](const char* k) { return blobs.erase(k) != 0; });
+    }
+};
+
+using TestAVmeter = sim::SimulatedAVmeter<UnitAVmeterBase>;
+
+}  // namespace
+
+TEST_F(TestEEPROMSim, CacheRecord)
+{
+    char key[meter::CalibrationCache::KEY_SIZE]{};
+    meter::CalibrationCache::makeKey(key, 1, ADDRESS);
+    EXPECT_STREQ(key, "mcal_01_51");
+
+    EXPECT_TRUE(unit.readCalibration());
+    EXPECT_NE(unit.calibrationHash(), 0U);
+    meter::CalibrationRecord rec{};
+    unit.exportCalibration(rec);
+    EXPECT_EQ(rec.valid, 0xFF);
+    EXPECT_EQ(rec.hash, unit.calibrationHash());
+
+    MemoryStore store{};
+    auto kv = store.cache();
+    meter::FileCalibrationCache file{::testing::TempDir()};
+    file.remove(key);
+    for (meter::CalibrationCache* cache : {static_cast<meter::CalibrationCache*>(&kv),
+                                           static_cast<meter::CalibrationCache*>(&file)}) {
+        meter::CalibrationRecord r{};
+        EXPECT_FALSE(cache->read(key, r));  // Not stored
+        EXPECT_TRUE(cache->write(key, rec));
+        ASSERT_TRUE(cache->read(key, r));
+        EXPECT_EQ(r.hash, rec.hash);
+
+        UnitEEPROM other{ADDRESS};
+        other.importCalibration(r);
+        for (uint8_t g = 0; g < 8; ++g) {
+            const Gain gain = static_cast<Gain>(g);
+            EXPECT_TRUE(other.validCalibration(gain));
+            EXPECT_EQ(other.hope(gain), unit.hope(gain));
+            EXPECT_EQ(other.actual(gain), unit.actual(gain));
+        }
+        EXPECT_TRUE(cache->remove(key));
+        EXPECT_FALSE(cache->read(key, r));
+    }
+
+    // Corrupted record is rejected
+    EXPECT_TRUE(kv.write(key, rec));
+    store.blobs[key][20] ^= 0x01;
+    meter::CalibrationRecord r{};
+    EXPECT_FALSE(kv.read(key, r));
+
+    // Same content, same hash. Changed content, changed hash
+    const uint32_t hash = unit.calibrationHash();
+    dev.maxRead(8);
+    EXPECT_TRUE(unit.readCalibration());
+    EXPECT_EQ(unit.calibrationHash(), hash);
+    dev.calibration(3, 1024, 1031);
+    EXPECT_TRUE(unit.readCalibration());
+    EXPECT_NE(unit.calibrationHash(), hash);
+}
+
+TEST_F(TestEEPROMSim, CachedBegin)
+{
+    sim::ADS1115 ads_dev{};
+    ads_dev.input([](const uint8_t, const uint32_t) { return 0.5; });
+    bus.attach(0x48, &ads_dev);
+
+    MemoryStore store{};
+    auto cache = store.cache();
+    // Gain::PGA_2048 by default
+    const float factor = (float)hope_table[2] / actual_table[2];
+
+    auto make_unit = [&](TestAVmeter& u) {
+        u.connect(bus, 0x48, ADDRESS);
+        auto cfg           = u.config();
+        cfg.start_periodic = false;
+        u.config(cfg);
+        u.setCalibrationCache(&cache, 1);
+    };
+
+    // Not cached, read the EEPROM and store
+    {
+        TestAVmeter u{0x48, ADDRESS};
+        make_unit(u);
+        bus.resetStats();
+        EXPECT_TRUE(u.begin());
+        EXPECT_EQ(dev.stats().transactions, 2U);
+        EXPECT_FALSE(u.calibrationFromCache());
+        EXPECT_FLOAT_EQ(u.calibrationFactor(), factor);
+        EXPECT_EQ(store.blobs.size(), 1U);
+    }
+
+    // Cached, the EEPROM is not accessed on begin nor on update, only by the explicit verification
+    {
+        TestAVmeter u{0x48, ADDRESS};
+        make_unit(u);
+        bus.resetStats();
+        EXPECT_TRUE(u.begin());
+        EXPECT_EQ(dev.stats().transactions, 0U);
+        EXPECT_TRUE(u.calibrationFromCache());
+        EXPECT_FLOAT_EQ(u.calibrationFactor(), factor);
+
+        EXPECT_TRUE(u.startPeriodicMeasurement());
+        uint32_t cnt{};
+        auto timeout_at = m5::utility::millis() + 100;
+        do {
+            u.update();
+            cnt += u.updated() ? 1 : 0;
+        } while (m5::utility::millis() < timeout_at);
+        EXPECT_GT(cnt, 0U);
+        EXPECT_EQ(dev.stats().transactions, 0U);
+        EXPECT_TRUE(u.calibrationFromCache());
+        EXPECT_TRUE(u.stopPeriodicMeasurement());
+
+        EXPECT_TRUE(u.verifyCalibration());
+        EXPECT_EQ(dev.stats().transactions, 2U);
+        EXPECT_FALSE(u.calibrationFromCache());
+        EXPECT_FLOAT_EQ(u.calibrationFactor(), factor);
+    }
+
+    // The EEPROM has been changed (e.g. another unit on the same address)
+    dev.calibration(2, 2048, 2000);
+    const float changed = 2048.f / 2000;
+    {
+        TestAVmeter u{0x48, ADDRESS};
+        make_unit(u);
+        EXPECT_TRUE(u.begin());
+        EXPECT_FLOAT_EQ(u.calibrationFactor(), factor);  // Cached
+        EXPECT_TRUE(u.verifyCalibration());
+        EXPECT_FLOAT_EQ(u.calibrationFactor(), changed);  // Applied
+    }
+    {
+        TestAVmeter u{0x48, ADDRESS};
+        make_unit(u);
+        EXPECT_TRUE(u.begin());
+        EXPECT_TRUE(u.calibrationFromCache());
+        EXPECT_FLOAT_EQ(u.calibrationFactor(), changed);  // Updated cache
+
+        // Failed to verify, keep the applied one
+        dev.calibration(2, 2048, 2000, true);
+        EXPECT_FALSE(u.verifyCalibration());
+        EXPECT_TRUE(u.calibrationFromCache());
+        EXPECT_FLOAT_EQ(u.calibrationFactor(), changed);
+    }
+
+    // Checksum failure aborts begin without the cache as before
+    {
+        TestAVmeter u{0x48, ADDRESS};
+        make_unit(u);
+        u.setCalibrationCache(nullptr);
+        EXPECT_FALSE(u.begin());
+    }
+}
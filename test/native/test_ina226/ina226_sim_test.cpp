@@ -0,0 +1,399 @@
+/*
+ * SPDX-FileCopyrightText: 2024 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+/*
+  UnitTest for UnitINA226 with the simulated device (native)
+*/
+#include <gtest/gtest.h>
+#include <M5UnitComponent.hpp>
+#include <unit/unit_INA226.hpp>
+#include "../sim/sim_ina226.hpp"
+#include <cmath>
+#include <sstream>
+
+using namespace m5::unit;
+using namespace m5::unit::ina226;
+
+namespace {
+
+constexpr double SHUNT_RES{0.080};  // UnitINA226_1A
+
+// Run update() for the duration, and returns the number of updates
+template <class U>
+uint32_t run_for(U& unit, m5::unit::sim::Bus& bus, const uint32_t ms)
+{
+    uint32_t cnt{};
+    auto timeout_at = m5::utility::millis() + ms;
+    do {
+        bus.tick();
+        unit.update();
+        cnt += unit.updated() ? 1 : 0;
+    } while (m5::utility::millis() < timeout_at);
+    return cnt;
+}
+
+}  // namespace
+
+class TestINA226Sim : public ::testing::Test {
+protected:
+    virtual void SetUp() override
+    {
+        dev.current(sim::waveform::constant(0.25));
+        dev.voltage(sim::waveform::constant(5.0));
+        bus.attach(unit.address(), &dev);
+        unit.connect(bus);
+
+        auto ccfg        = unit.component_config();
+        ccfg.stored_size = 8;
+        unit.component_config(ccfg);
+        ASSERT_TRUE(unit.begin());
+    }
+
+    sim::Bus bus{};
+    sim::INA226 dev{SHUNT_RES};
+    sim::Simulated<UnitINA226_1A> unit{};
+};
+
+TEST_F(TestINA226Sim, Begin)
+{
+    EXPECT_TRUE(unit.inPeriodic());
+    EXPECT_GE(dev.resets(), 2U);  // Power-on and softReset
+
+    uint16_t cal{};
+    EXPECT_TRUE(unit.readCalibration(cal));
+    EXPECT_NE(cal, 0U);
+
+    Mode mode{};
+    EXPECT_TRUE(unit.readMode(mode));
+    EXPECT_EQ(mode, Mode::ShuntAndBus);
+}
+
+TEST_F(TestINA226Sim, Periodic)
+{
+    EXPECT_TRUE(unit.stopPeriodicMeasurement());
+    EXPECT_TRUE(unit.startPeriodicMeasurement(Sampling::Rate4, ConversionTime::US_140, ConversionTime::US_140));
+    EXPECT_EQ(unit.intervalMicros(), dev.cycleMicros());
+
+    bus.resetStats();
+    const uint32_t before = dev.conversions();
+    auto cnt              = run_for(unit, bus, 250);
+    const uint32_t conv   = dev.conversions() - before;
+
+    // No stale repeats, no dropped conversions
+    EXPECT_LE(cnt, conv);
+    EXPECT_GE(cnt, conv * 95 / 100);
+
+    EXPECT_NEAR(unit.current(), 250.f, unit.currentLSB() * 1000 * 2);
+    EXPECT_NEAR(unit.voltage(), 5000.f, 1.25f);
+    EXPECT_NEAR(unit.power(), 1250.f, unit.currentLSB() * 25 * 1000 * 2);
+
+    // Mask (pointer + read) and 4 registers (pointer + read) per sample, plus not-ready polls
+    const float tps = (float)dev.stats().transactions / cnt;
+    EXPECT_GE(tps, 10.0f);
+    EXPECT_LE(tps, 11.0f);
+}
+
+TEST_F(TestINA226Sim, WithoutDataReadyCheck)
+{
+    EXPECT_TRUE(unit.stopPeriodicMeasurement());
+    unit.setDataReadyCheck(false);
+    EXPECT_TRUE(unit.startPeriodicMeasurement(Sampling::Rate4, ConversionTime::US_140, ConversionTime::US_140));
+
+    bus.resetStats();
+    const uint32_t before = dev.conversions();
+    auto cnt              = run_for(unit, bus, 250);
+    const uint32_t conv   = dev.conversions() - before;
+
+    EXPECT_LE(cnt, conv + 1);
+    EXPECT_GE(cnt, conv * 95 / 100);
+
+    // 4 registers (pointer + read) per sample, without the Mask read
+    const float tps = (float)dev.stats().transactions / cnt;
+    EXPECT_LE(tps, 8.1f);
+    EXPECT_NEAR(unit.current(), 250.f, unit.currentLSB() * 1000 * 2);
+
+    unit.setDataReadyCheck(true);
+}
+
+TEST_F(TestINA226Sim, Waveform)
+{
+    EXPECT_TRUE(unit.stopPeriodicMeasurement());
+
+    // Step 0.1 A -> 0.6 A after 50 ms
+    const uint32_t step_at = (uint32_t)m5::utility::micros() + 50 * 1000;
+    dev.current(sim::waveform::step(0.1, 0.6, step_at));
+    EXPECT_TRUE(unit.startPeriodicMeasurement(Sampling::Rate1, ConversionTime::US_588, ConversionTime::US_588));
+    const uint32_t cycle = dev.cycleMicros();
+
+    uint32_t detected_at{};
+    auto timeout_at = m5::utility::millis() + 100;
+    do {
+        bus.tick();
+        unit.update();
+        if (unit.updated() && !detected_at && unit.latest().current() > 350.f) {
+            detected_at = (uint32_t)m5::utility::micros();
+        }
+    } while (m5::utility::millis() < timeout_at);
+
+    // Observed within the conversion cycle that crosses the midpoint, plus one more
+    ASSERT_NE(detected_at, 0U);
+    EXPECT_LE(detected_at - step_at, cycle * 2);
+    EXPECT_NEAR(unit.latest().current(), 600.f, unit.currentLSB() * 1000 * 2);
+
+    // Recorded waveform (1 s period triangle 0 -> 0.8 A)
+    std::istringstream iss("t,A\n0,0\n0.5,0.8\n1.0,0\n");
+    auto tri = sim::waveform::csv(iss, true);
+    EXPECT_DOUBLE_EQ(tri(250 * 1000), 0.4);
+    EXPECT_DOUBLE_EQ(tri(1750 * 1000), 0.4);
+    EXPECT_DOUBLE_EQ(sim::waveform::mean(tri, 0, 1000 * 1000, 1000), 0.4);
+
+    // Sine is averaged out over the whole periods of the conversion cycle
+    EXPECT_NEAR(sim::waveform::mean(sim::waveform::sine(1.0, 0.5, 1000), 0, 10 * 1000, 64), 1.0, 1e-9);
+}
+
+TEST_F(TestINA226Sim, Accumulation)
+{
+    EXPECT_TRUE(unit.stopPeriodicMeasurement());
+    unit.resetAccumulation();
+    EXPECT_TRUE(unit.startPeriodicMeasurement(Sampling::Rate1, ConversionTime::US_588, ConversionTime::US_588));
+
+    const uint32_t start_at = (uint32_t)m5::utility::micros();
+    run_for(unit, bus, 300);
+    const uint32_t elapsed = (uint32_t)m5::utility::micros() - start_at;
+
+    // 0.25 A for the elapsed time (The last conversion is not yet read)
+    auto acc             = unit.accumulation();
+    const double expects = 0.25 * elapsed / 3600.0 / 1000.0;
+    EXPECT_NEAR(acc.mAh(), expects, expects * 0.02 + 0.25 * dev.cycleMicros() / 3600.0 / 1000.0);
+    EXPECT_NEAR(acc.Wh(), acc.mAh() * 5.0 / 1000.0, acc.Wh() * 0.02);
+    EXPECT_NEAR(acc.duration, elapsed, dev.cycleMicros() * 2);
+}
+
+TEST_F(TestINA226Sim, ConversionReady)
+{
+    dev.onAlert([this]() { unit.onConversionReady(); });
+
+    EXPECT_TRUE(unit.stopPeriodicMeasurement());
+    EXPECT_TRUE(unit.startPeriodicMeasurement(Sampling::Rate4, ConversionTime::US_332, ConversionTime::US_332));
+    EXPECT_TRUE(unit.enableConversionReady(true));
+
+    const uint32_t before = dev.conversions();
+    auto cnt              = run_for(unit, bus, 200);
+    const uint32_t conv   = dev.conversions() - before;
+
+    // The Mask read releases the pin, so each conversion is notified and read once
+    EXPECT_LE(cnt, conv);
+    EXPECT_GE(cnt + 1, conv);
+    EXPECT_LE(unit.conversionReadyOverruns(), conv / 20);
+
+    EXPECT_TRUE(unit.enableConversionReady(false));
+
+    // Soft reset clears CNVR, so update() must go back to polling
+    EXPECT_TRUE(unit.enableConversionReady(true));
+    EXPECT_TRUE(unit.softReset());
+    EXPECT_FALSE(unit.inConversionReady());
+    EXPECT_GT(run_for(unit, bus, 50), 0U);
+
+    dev.onAlert(nullptr);
+}
+
+TEST_F(TestINA226Sim, Alert)
+{
+    EXPECT_TRUE(unit.stopPeriodicMeasurement());
+    uint32_t alerts{};
+    dev.onAlert([&alerts]() { ++alerts; });
+
+    // Bus over-voltage (latched) 4.0 V
+    // Without the flag check, since the Mask read releases the latch
+    unit.setDataReadyCheck(false);
+    EXPECT_TRUE(unit.writeAlert(Alert::BusOver, (uint16_t)(4.0 / 1.25e-3), true));
+    EXPECT_TRUE(unit.startPeriodicMeasurement(Sampling::Rate1, ConversionTime::US_140, ConversionTime::US_140));
+    run_for(unit, bus, 10);
+    EXPECT_TRUE(dev.alertPin());
+    EXPECT_EQ(alerts, 1U);  // Stays asserted while latched
+
+    bool occurred{};
+    EXPECT_TRUE(unit.readAlertOccurred(occurred));
+    EXPECT_TRUE(occurred);
+
+    EXPECT_FALSE(dev.alertPin());
+
+    EXPECT_TRUE(unit.stopPeriodicMeasurement());
+    dev.onAlert(nullptr);
+    unit.setDataReadyCheck(true);
+}
+
+TEST_F(TestINA226Sim, Singleshot)
+{
+    EXPECT_TRUE(unit.stopPeriodicMeasurement());
+    dev.current(sim::waveform::constant(-0.5));
+    dev.voltage(sim::waveform::constant(12.0));
+
+    Data d{};
+    const uint32_t before = dev.conversions();
+    EXPECT_TRUE(unit.measureSingleshot(d, Sampling::Rate1, ConversionTime::US_1100, ConversionTime::US_1100));
+    EXPECT_EQ(dev.conversions() - before, 1U);
+    EXPECT_NEAR(d.current(), -500.f, unit.currentLSB() * 1000 * 2);
+    EXPECT_NEAR(d.voltage(), 12000.f, 1.25f);
+    EXPECT_NEAR(d.shuntVoltage(), -0.5 * SHUNT_RES * 1000.0, 0.0025);
+}
+
+TEST_F(TestINA226Sim, AsyncSingleshot)
+{
+    // Two units in the triggered mode driven by one loop
+    constexpr uint8_t ADDRESS2{0x45};
+    sim::INA226 dev2{SHUNT_RES};
+    dev2.current(sim::waveform::constant(0.1));
+    dev2.voltage(sim::waveform::constant(3.3));
+    sim::Simulated<UnitINA226_1A> unit2{};
+    bus.attach(ADDRESS2, &dev2);
+    unit2.connect(bus, ADDRESS2);  // As if the address pins were strapped
+    auto cfg           = unit2.config();
+    cfg.start_periodic = false;
+    unit2.config(cfg);
+    ASSERT_TRUE(unit2.begin());
+    EXPECT_TRUE(unit.stopPeriodicMeasurement());
+
+    uint32_t done_at[2]{};
+    bool result[2]{};
+    Data cd[2]{};
+    unit.setSingleshotCallback([&](const bool ok, const Data& d) {
+        done_at[0] = m5::utility::micros();
+        result[0]  = ok;
+        cd[0]      = d;
+    });
+    unit2.setSingleshotCallback([&](const bool ok, const Data& d) {
+        done_at[1] = m5::utility::micros();
+        result[1]  = ok;
+        cd[1]      = d;
+    });
+
+    Data d{};
+    const uint32_t start_at = m5::utility::micros();
+    EXPECT_TRUE(unit.requestSingleshot(Sampling::Rate4, ConversionTime::US_1100, ConversionTime::US_1100));
+    EXPECT_TRUE(unit2.requestSingleshot(Sampling::Rate1, ConversionTime::US_4156, ConversionTime::US_4156));
+    EXPECT_FALSE(unit.requestSingleshot());  // Converting
+    EXPECT_FALSE(unit.measureSingleshot(d));
+    EXPECT_FALSE(unit.trySingleshotResult(d));
+    EXPECT_EQ(unit.singleshotState(), meter::SingleshotState::Converting);
+
+    bus.resetStats();
+    auto timeout_at = m5::utility::millis() + 100;
+    while ((!done_at[0] || !done_at[1]) && m5::utility::millis() < timeout_at) {
+        bus.tick();
+        unit.update();
+        unit2.update();
+    }
+    ASSERT_TRUE(done_at[0] && done_at[1]);
+    EXPECT_TRUE(result[0]);
+    EXPECT_TRUE(result[1]);
+    EXPECT_NEAR(cd[0].current(), 250.f, unit.currentLSB() * 1000 * 2);
+    EXPECT_NEAR(cd[0].voltage(), 5000.f, 1.25f);
+    EXPECT_NEAR(cd[1].current(), 100.f, unit2.currentLSB() * 1000 * 2);
+    EXPECT_NEAR(cd[1].voltage(), 3300.f, 1.25f);
+
+    // Completed in the order of the computed deadlines, each not before its own
+    EXPECT_GE(done_at[0] - start_at, dev.cycleMicros());
+    EXPECT_GE(done_at[1] - start_at, dev2.cycleMicros());
+    EXPECT_LT(done_at[1], done_at[0]);
+
+    // One Mask read at the deadline and the measurement registers (pointer write + read each at most)
+    EXPECT_LE(dev.stats().transactions, 2U + 4 * 2);
+    EXPECT_LE(dev2.stats().transactions, 2U + 4 * 2);
+
+    // The result is kept until taken
+    EXPECT_TRUE(unit.trySingleshotResult(d));
+    EXPECT_EQ(d.raw, cd[0].raw);
+    EXPECT_EQ(unit.singleshotState(), meter::SingleshotState::Idle);
+
+    // Polled without the callback
+    unit2.setSingleshotCallback(nullptr);
+    EXPECT_TRUE(unit2.requestSingleshot(true, false, false));
+    timeout_at = m5::utility::millis() + 100;
+    bool done{};
+    while (!(done = unit2.trySingleshotResult(d)) && m5::utility::millis() < timeout_at) {
+        bus.tick();
+    }
+    EXPECT_TRUE(done);
+    EXPECT_NEAR(d.current(), 100.f, unit2.currentLSB() * 1000 * 2);
+
+    // Canceled by the periodic measurement
+    EXPECT_TRUE(unit2.requestSingleshot());
+    EXPECT_TRUE(unit2.startPeriodicMeasurement());
+    EXPECT_EQ(unit2.singleshotState(), meter::SingleshotState::Failed);
+    EXPECT_FALSE(unit2.requestSingleshot());
+    EXPECT_TRUE(unit2.stopPeriodicMeasurement());
+}
+
+#if M5_UNIT_METER_BUS_STATS
+TEST_F(TestINA226Sim, BusStats)
+{
+    using namespace m5::unit::ina226::command;
+    const auto& st = unit.busStats();
+
+    EXPECT_TRUE(unit.stopPeriodicMeasurement());
+    EXPECT_TRUE(unit.startPeriodicMeasurement(Sampling::Rate4, ConversionTime::US_140, ConversionTime::US_140));
+    unit.resetBusStats();
+    bus.resetStats();
+    auto cnt = run_for(unit, bus, 100);
+
+    // Each register read is one read transaction on the bus
+    EXPECT_EQ(st.reads, dev.stats().reads);
+    EXPECT_EQ(st.read_bytes, dev.stats().read_bytes);
+    EXPECT_EQ(st.errors, 0U);
+    ASSERT_NE(st.find(CURRENT_REG), nullptr);
+    ASSERT_NE(st.find(MASK_REG), nullptr);
+    EXPECT_EQ(st.find(CURRENT_REG)->reads, cnt);
+    EXPECT_EQ(st.find(MASK_REG)->reads, cnt + st.polls);
+    EXPECT_EQ(st.find(CALIBRATION_REG), nullptr);
+
+    // Only the updates that accessed the bus
+    EXPECT_EQ(st.of(meter::Call::Update).count, cnt + st.polls);
+    EXPECT_GT(st.bus_us, 0U);
+    EXPECT_LE(st.bus_us, st.of(meter::Call::Update).total);
+
+    EXPECT_TRUE(unit.stopPeriodicMeasurement());
+    unit.resetBusStats();
+    Data d{};
+    EXPECT_TRUE(unit.measureSingleshot(d));
+    EXPECT_EQ(st.of(meter::Call::Singleshot).count, 1U);
+    EXPECT_GE(st.of(meter::Call::Singleshot).min, dev.cycleMicros());
+    // One Mask read at the computed deadline
+    EXPECT_EQ(st.polls, 0U);
+    EXPECT_EQ(st.find(MASK_REG)->reads, 1U);
+    EXPECT_EQ(st.of(meter::Call::Update).count, 0U);
+    st.dump("INA226");
+}
+#endif
+
+TEST_F(TestINA226Sim, Drain)
+{
+    EXPECT_TRUE(unit.stopPeriodicMeasurement());
+    EXPECT_TRUE(unit.startPeriodicMeasurement(Sampling::Rate4, ConversionTime::US_140, ConversionTime::US_140));
+    run_for(unit, bus, 50);  // Wrapped
+    EXPECT_TRUE(unit.stopPeriodicMeasurement());
+    ASSERT_TRUE(unit.full());
+
+    Data d[4]{};
+    EXPECT_EQ(unit.drain(d, 4), 4U);
+    float v[4]{};
+    UnitINA226::convertCurrent(v, d, 4);
+    for (int i = 0; i < 4; ++i) {
+        EXPECT_FLOAT_EQ(v[i], d[i].current());
+    }
+    UnitINA226::convertPower(v, d, 4);
+    EXPECT_FLOAT_EQ(v[3], d[3].power());
+    UnitINA226::convertVoltage(v, d, 4);
+    EXPECT_FLOAT_EQ(v[3], d[3].voltage());
+    UnitINA226::convertShuntVoltage(v, d, 4);
+    EXPECT_FLOAT_EQ(v[3], d[3].shuntVoltage());
+
+    const float oldest = unit.current();
+    float cur[16]{};
+    EXPECT_EQ(unit.drainCurrent(cur, 16), 4U);
+    EXPECT_FLOAT_EQ(cur[0], oldest);
+    EXPECT_NEAR(cur[3], 250.f, unit.currentLSB() * 1000 * 2);
+    EXPECT_TRUE(unit.empty());
+}
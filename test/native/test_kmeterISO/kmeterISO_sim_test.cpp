@@ -0,0 +1,215 @@
+/*
+ * SPDX-FileCopyrightText: 2024 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+/*
+  UnitTest for UnitKmeterISO with the simulated device (native)
+*/
+#include <gtest/gtest.h>
+#include <M5UnitComponent.hpp>
+#include <unit/unit_KmeterISO.hpp>
+#include "../sim/sim_kmeter.hpp"
+#include <cstdlib>
+
+using namespace m5::unit;
+using namespace m5::unit::kmeter_iso;
+using namespace m5::unit::kmeter_iso::command;
+
+namespace {
+
+constexpr uint32_t CONVERSION_US{10 * 1000U};
+
+// Run update() for the duration, and returns the number of updates
+template <class U>
+uint32_t run_for(U& unit, m5::unit::sim::Bus& bus, const uint32_t ms)
+{
+    uint32_t cnt{};
+    auto timeout_at = m5::utility::millis() + ms;
+    do {
+        bus.tick();
+        unit.update();
+        cnt += unit.updated() ? 1 : 0;
+    } while (m5::utility::millis() < timeout_at);
+    return cnt;
+}
+
+}  // namespace
+
+class TestKmeterISOSim : public ::testing::Test {
+protected:
+    virtual void SetUp() override
+    {
+        dev.timing(CONVERSION_US, 0);
+        dev.temperature(sim::waveform::sine(100.0, 50.0, 1.0));
+        dev.internalTemperature(sim::waveform::constant(25.0));
+        bus.attach(unit.address(), &dev);
+        unit.connect(bus);
+
+        auto ccfg        = unit.component_config();
+        ccfg.stored_size = 8;
+        unit.component_config(ccfg);
+        auto cfg           = unit.config();
+        cfg.start_periodic = false;
+        unit.config(cfg);
+        ASSERT_TRUE(unit.begin());
+    }
+
+    sim::Bus bus{};
+    sim::KmeterISO dev{};
+    sim::Simulated<UnitKmeterISO> unit{};
+};
+
+TEST_F(TestKmeterISOSim, Singleshot)
+{
+    // Busy until the first conversion after power-on
+    dev.reset();
+    Data d{};
+    auto start_at = m5::utility::millis();
+    EXPECT_TRUE(unit.measureSingleshot(d));
+    auto elapsed = m5::utility::millis() - start_at;
+
+    EXPECT_GE(elapsed, CONVERSION_US / 1000 - 1);
+    EXPECT_GT(dev.busyReads(), 0U);
+    // 1 ms poll
+    EXPECT_LE(dev.statusReads(), CONVERSION_US / 1000 + 2);
+    EXPECT_NEAR(d.temperature(), 100.0f, 50.f);
+
+    EXPECT_TRUE(unit.measureInternalSingleshot(d, MeasurementUnit::Fahrenheit));
+    EXPECT_FLOAT_EQ(d.temperature(), 77.0f);
+
+    // Fault code
+    dev.fault(0x04);
+    EXPECT_FALSE(unit.measureSingleshot(d, MeasurementUnit::Celsius, 5));
+    dev.fault(0);
+}
+
+TEST_F(TestKmeterISOSim, Periodic)
+{
+    constexpr uint32_t interval_table[] = {10, 20, 50};
+
+    for (auto&& it : interval_table) {
+        SCOPED_TRACE(it);
+        EXPECT_TRUE(unit.startPeriodicMeasurement(it, MeasurementUnit::Celsius));
+
+        bus.resetStats();
+        const uint32_t reads = dev.statusReads();
+        auto cnt             = run_for(unit, bus, 300);
+
+        EXPECT_NEAR(unit.effectiveSamplingRate(), 1000.f / it, 1000.f / it * 0.05f);
+        EXPECT_GE(cnt, 300 / it - 1);
+        EXPECT_LE(cnt, 300 / it + 1);
+        // One status poll per sample once the conversions are running,
+        // and 1 ms polls only while the first conversion is busy
+        const uint32_t polls = dev.statusReads() - reads;
+        EXPECT_GE(polls, cnt);
+        EXPECT_LE(polls, cnt + CONVERSION_US / 1000 + 1);
+        // Status (pointer + read) and temperature (pointer + read)
+        EXPECT_EQ(dev.stats().transactions, polls * 2 + cnt * 2);
+
+        EXPECT_GE(unit.temperature(), 50.0f);
+        EXPECT_LE(unit.temperature(), 150.0f);
+        EXPECT_TRUE(unit.stopPeriodicMeasurement());
+    }
+
+    // Longest interval the microsecond schedule can hold
+    EXPECT_FALSE(unit.startPeriodicMeasurement(meter::MAX_SPAN_MILLIS + 1, MeasurementUnit::Celsius));
+    EXPECT_FALSE(unit.inPeriodic());
+    EXPECT_TRUE(unit.startPeriodicMeasurement(meter::MAX_SPAN_MILLIS, MeasurementUnit::Celsius));
+    EXPECT_EQ(unit.intervalMicros(), meter::MAX_SPAN_MILLIS * 1000U);
+    EXPECT_TRUE(unit.stopPeriodicMeasurement());
+}
+
+TEST_F(TestKmeterISOSim, StringRegister)
+{
+    dev.temperature(sim::waveform::constant(-12.34));
+    run_for(unit, bus, CONVERSION_US / 1000 + 1);
+
+    char buf[17]{};
+    EXPECT_TRUE(unit.readRegister(TEMPERATURE_CELSIUS_STRING_REG, (uint8_t*)buf, 16, 0));
+    EXPECT_STREQ(buf, "-12.34");
+    EXPECT_TRUE(unit.readRegister(INTERNAL_TEMPERATURE_FAHRENHEIT_STRING_REG, (uint8_t*)buf, 16, 0));
+    EXPECT_STREQ(buf, "77.00");
+
+    Data d{};
+    EXPECT_TRUE(unit.measureSingleshot(d));
+    EXPECT_FLOAT_EQ(d.temperature(), std::strtof("-12.34", nullptr));
+}
+
+TEST_F(TestKmeterISOSim, I2CAddress)
+{
+    EXPECT_FALSE(unit.changeI2CAddress(0x07));  // Invalid
+    EXPECT_FALSE(unit.changeI2CAddress(0x78));  // Invalid
+
+    uint8_t addr{};
+    Data d{};
+    for (auto&& to : {0x10, 0x77, 0x52, +UnitKmeterISO::DEFAULT_ADDRESS}) {
+        SCOPED_TRACE(to);
+        EXPECT_TRUE(unit.changeI2CAddress(to));
+        EXPECT_EQ(unit.address(), to);
+        EXPECT_EQ(dev.address(), to);
+        EXPECT_EQ(bus.device(to), &dev);
+
+        EXPECT_TRUE(unit.readI2CAddress(addr));
+        EXPECT_EQ(addr, to);
+        EXPECT_TRUE(unit.measureSingleshot(d));
+    }
+
+    // Address change is rejected in periodic
+    EXPECT_TRUE(unit.startPeriodicMeasurement(20, MeasurementUnit::Celsius));
+    EXPECT_FALSE(unit.changeI2CAddress(0x10));
+    EXPECT_TRUE(unit.stopPeriodicMeasurement());
+}
+
+#if M5_UNIT_METER_BUS_STATS
+TEST_F(TestKmeterISOSim, BusStats)
+{
+    const auto& st = unit.busStats();
+
+    dev.reset();
+    unit.resetBusStats();
+    Data d{};
+    EXPECT_TRUE(unit.measureSingleshot(d));
+
+    // One status read per poll iteration
+    ASSERT_NE(st.find(STATUS_REG), nullptr);
+    EXPECT_EQ(st.find(STATUS_REG)->reads, st.polls);
+    EXPECT_EQ(st.find(STATUS_REG)->reads, dev.statusReads());
+    EXPECT_EQ(st.find(TEMPERATURE_CELSIUS_REG)->reads, 1U);
+    EXPECT_EQ(st.read_bytes, st.polls + 4);
+    EXPECT_EQ(st.of(meter::Call::Singleshot).count, 1U);
+    EXPECT_GE(st.of(meter::Call::Singleshot).max + 1000, CONVERSION_US);
+
+    // Histogram bucket of the latency
+    const auto& h = st.of(meter::Call::Singleshot);
+    uint32_t b{};
+    for (uint32_t v = h.max; v && b < meter::Histogram::BUCKETS - 1; v >>= 1) {
+        ++b;
+    }
+    EXPECT_EQ(h.bucket[b], 1U);
+}
+#endif
+
+TEST_F(TestKmeterISOSim, Drain)
+{
+    EXPECT_TRUE(unit.startPeriodicMeasurement(10, MeasurementUnit::Celsius));
+    run_for(unit, bus, 150);  // Wrapped
+    EXPECT_TRUE(unit.stopPeriodicMeasurement());
+    ASSERT_TRUE(unit.full());
+
+    Data d[2]{};
+    EXPECT_EQ(unit.drain(d, 2), 2U);
+    float t[16]{};
+    UnitKmeterISO::convertTemperature(t, d, 2);
+    EXPECT_FLOAT_EQ(t[0], d[0].temperature());
+    EXPECT_FLOAT_EQ(t[1], d[1].temperature());
+
+    const float oldest = unit.temperature();
+    EXPECT_EQ(unit.drainTemperature(t, 16), 6U);
+    EXPECT_FLOAT_EQ(t[0], oldest);
+    for (int i = 0; i < 6; ++i) {
+        EXPECT_GE(t[i], 50.0f);
+        EXPECT_LE(t[i], 150.0f);
+    }
+    EXPECT_TRUE(unit.empty());
+}
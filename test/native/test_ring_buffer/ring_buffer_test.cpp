@@ -0,0 +1,110 @@
+/*
+ * SPDX-FileCopyrightText: 2024 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+/*
+  UnitTest for RingBuffer (native)
+*/
+#include <gtest/gtest.h>
+#include <unit/meter_ring_buffer.hpp>
+#include <vector>
+
+using m5::unit::meter::RingBuffer;
+using m5::unit::meter::Span;
+
+TEST(RingBuffer, Basic)
+{
+    RingBuffer<int> rb{4};
+    EXPECT_EQ(rb.capacity(), 4U);
+    EXPECT_TRUE(rb.empty());
+    EXPECT_FALSE(rb.front());
+    EXPECT_FALSE(rb.back());
+
+    for (int i = 0; i < 3; ++i) {
+        rb.push_back(i);
+    }
+    EXPECT_EQ(rb.size(), 3U);
+    EXPECT_FALSE(rb.full());
+    EXPECT_EQ(rb.front().value(), 0);
+    EXPECT_EQ(rb.back().value(), 2);
+
+    // Overwrite the oldest
+    rb.push_back(3);
+    rb.push_back(4);
+    EXPECT_TRUE(rb.full());
+    EXPECT_EQ(rb.size(), 4U);
+    EXPECT_EQ(rb.front().value(), 1);
+    EXPECT_EQ(rb.back().value(), 4);
+    for (size_t i = 0; i < rb.size(); ++i) {
+        EXPECT_EQ(rb[i], (int)i + 1);
+        EXPECT_EQ(rb.at(i), (int)i + 1);
+    }
+
+    rb.pop_front();
+    EXPECT_EQ(rb.front().value(), 2);
+    EXPECT_EQ(rb.pop_front(10), 3U);
+    EXPECT_TRUE(rb.empty());
+    rb.push_back(5);
+    EXPECT_EQ(rb.front().value(), 5);
+    rb.clear();
+    EXPECT_TRUE(rb.empty());
+}
+
+TEST(RingBuffer, Segments)
+{
+    RingBuffer<int> rb{8};
+    Span<const int> a{}, b{};
+    EXPECT_EQ(rb.segments(a, b), 0U);
+    EXPECT_TRUE(a.empty());
+    EXPECT_TRUE(b.empty());
+
+    // Every phase of the wraparound
+    for (int start = 0; start < 8; ++start) {
+        SCOPED_TRACE(start);
+        rb.clear();
+        for (int i = 0; i < 8 + start; ++i) {
+            rb.push_back(i);
+        }
+        for (size_t max : {3U, 8U, 100U}) {
+            const size_t n = rb.segments(a, b, max);
+            EXPECT_EQ(n, std::min<size_t>(max, 8));
+            EXPECT_EQ(a.size() + b.size(), n);
+            EXPECT_EQ(b.size(), start && n > 8U - start ? n - (8 - start) : 0U);
+            std::vector<int> v(a.begin(), a.end());
+            v.insert(v.end(), b.begin(), b.end());
+            for (size_t i = 0; i < v.size(); ++i) {
+                EXPECT_EQ(v[i], start + (int)i);
+            }
+        }
+    }
+}
+
+TEST(RingBuffer, Consume)
+{
+    RingBuffer<int> rb{8};
+    for (int i = 0; i < 10; ++i) {
+        rb.push_back(i);
+    }
+    // Wrapped, 2...9
+    int out[16]{};
+    EXPECT_EQ(rb.read(out, 3), 3U);
+    EXPECT_EQ(out[0], 2);
+    EXPECT_EQ(out[2], 4);
+    EXPECT_EQ(rb.size(), 5U);
+
+    size_t calls{};
+    std::vector<int> v(16);
+    EXPECT_EQ(rb.consume(16,
+                         [&](const int* p, const size_t n, const size_t offset) {
+                             ++calls;
+                             std::copy(p, p + n, v.begin() + offset);
+                         }),
+              5U);
+    EXPECT_EQ(calls, 2U);  // Two segments
+    for (int i = 0; i < 5; ++i) {
+        EXPECT_EQ(v[i], 5 + i);
+    }
+    EXPECT_TRUE(rb.empty());
+    EXPECT_EQ(rb.read(out, 16), 0U);
+}